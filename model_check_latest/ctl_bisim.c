@@ -0,0 +1,247 @@
+// ctl_bisim.c - Bisimulation minimization of a model before checking
+//
+// Signature-based partition refinement: states start out grouped by their
+// labels, and a block is split while its states disagree on the set of blocks
+// their successors fall into. The stable partition is the coarsest
+// bisimulation respecting atomic_props. CTL cannot tell bisimilar states
+// apart, so formulas can be checked on the quotient model and the result
+// mapped back to the original states. A model keeps its bisimulation until
+// it changes, so every formula checked on it shares one quotient.
+#include "ctl_common.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+// Lazy builds may race when the sweep runs on a worker pool
+static pthread_mutex_t bisimulation_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// Sorted, duplicate-free successor blocks of one state
+typedef struct {
+    int count;
+    int blocks[MAX_TRANSITIONS];
+} Signature;
+
+static void compute_signature(Signature* sig, Model* model, const int* block, int state) {
+    State* current_state = &model->states[state];
+    sig->count = 0;
+
+    for (int j = 0; j < current_state->num_transitions; j++) {
+        int b = block[current_state->transitions[j]];
+        int pos = 0;
+        while (pos < sig->count && sig->blocks[pos] < b) pos++;
+        if (pos < sig->count && sig->blocks[pos] == b) continue;
+        memmove(&sig->blocks[pos + 1], &sig->blocks[pos], (sig->count - pos) * sizeof(int));
+        sig->blocks[pos] = b;
+        sig->count++;
+    }
+}
+
+static bool same_labels(Model* model, int s, int t) {
+    for (int p = 0; p < model->num_props; p++) {
+        if (model->states[s].atomic_props[p] != model->states[t].atomic_props[p]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool same_signature(const Signature* a, const Signature* b) {
+    return a->count == b->count && memcmp(a->blocks, b->blocks, a->count * sizeof(int)) == 0;
+}
+
+// Build the quotient: one state per block, labelled and connected like its representative
+static Model* build_quotient(Model* model, Bisimulation* bisim) {
+    Model* quotient = create_model();
+    if (quotient == NULL) return NULL;
+
+    for (int b = 0; b < bisim->num_blocks; b++) {
+        add_state(quotient);
+    }
+    for (int p = 0; p < model->num_props; p++) {
+        add_proposition(quotient, model->prop_names[p]);
+    }
+    // The quotient is checked with the kernels the model was set up for
+    quotient->use_reach_index = model->use_reach_index;
+    quotient->use_small_kernels = model->use_small_kernels;
+
+    for (int b = 0; b < bisim->num_blocks; b++) {
+        int rep = bisim->representative[b];
+        Signature sig;
+
+        for (int p = 0; p < model->num_props; p++) {
+            if (model->states[rep].atomic_props[p]) {
+                set_proposition_true(quotient, b, p);
+            }
+        }
+        compute_signature(&sig, model, bisim->block, rep);
+        for (int j = 0; j < sig.count; j++) {
+            add_transition(quotient, b, sig.blocks[j]);
+        }
+    }
+
+    return quotient;
+}
+
+// Compute the coarsest bisimulation of the model and its quotient model
+Bisimulation* compute_bisimulation(Model* model) {
+    Bisimulation* bisim = (Bisimulation*)malloc(sizeof(Bisimulation));
+    Signature* sigs = (Signature*)malloc(MAX_STATES * sizeof(Signature));
+    int* next_block = (int*)malloc(MAX_STATES * sizeof(int));
+    if (bisim == NULL || sigs == NULL || next_block == NULL) {
+        fprintf(stderr, "Error: Memory allocation failed for bisimulation\n");
+        free(bisim);
+        free(sigs);
+        free(next_block);
+        return NULL;
+    }
+
+    // Initial partition: equal labels
+    bisim->num_blocks = 0;
+    for (int s = 0; s < model->num_states; s++) {
+        int b = 0;
+        while (b < bisim->num_blocks && !same_labels(model, bisim->representative[b], s)) b++;
+        if (b == bisim->num_blocks) {
+            bisim->representative[bisim->num_blocks++] = s;
+        }
+        bisim->block[s] = b;
+    }
+
+    // Refine by (block, successor blocks) until the number of blocks is stable.
+    // Blocks are numbered by their first state, so the result is deterministic.
+    for (;;) {
+        int num_next = 0;
+        int next_rep[MAX_STATES];
+
+        for (int s = 0; s < model->num_states; s++) {
+            compute_signature(&sigs[s], model, bisim->block, s);
+        }
+        for (int s = 0; s < model->num_states; s++) {
+            int b = 0;
+            while (b < num_next &&
+                   !(bisim->block[next_rep[b]] == bisim->block[s] && same_signature(&sigs[next_rep[b]], &sigs[s]))) {
+                b++;
+            }
+            if (b == num_next) {
+                next_rep[num_next++] = s;
+            }
+            next_block[s] = b;
+        }
+
+        bool stable = (num_next == bisim->num_blocks);
+        bisim->num_blocks = num_next;
+        memcpy(bisim->block, next_block, model->num_states * sizeof(int));
+        memcpy(bisim->representative, next_rep, num_next * sizeof(int));
+        if (stable) break;
+    }
+
+    free(sigs);
+    free(next_block);
+
+    bisim->num_states = model->num_states;
+    bisim->quotient = build_quotient(model, bisim);
+    if (bisim->quotient == NULL) {
+        free(bisim);
+        return NULL;
+    }
+    return bisim;
+}
+
+void free_bisimulation(Bisimulation* bisim) {
+    if (bisim == NULL) return;
+    free_model(bisim->quotient);
+    free(bisim);
+}
+
+// Map a set of original states to quotient states (the set must be a union of
+// blocks, as every [[φ]] is; each block is decided by its representative)
+void project_state_set(StateSet* result, StateSet* set, Bisimulation* bisim) {
+    init_state_set(result, bisim->num_blocks);
+    for (int b = 0; b < bisim->num_blocks; b++) {
+        if (set->members[bisim->representative[b]]) {
+            add_to_state_set(result, b);
+        }
+    }
+}
+
+// Map a set of quotient states back to all the original states they stand for
+void lift_state_set(StateSet* result, StateSet* set, Bisimulation* bisim) {
+    init_state_set(result, bisim->num_states);
+    for (int s = 0; s < bisim->num_states; s++) {
+        if (set->members[bisim->block[s]]) {
+            add_to_state_set(result, s);
+        }
+    }
+}
+
+// The bisimulation of a model, computed on first use (NULL if it cannot be)
+Bisimulation* get_bisimulation(Model* model) {
+    pthread_mutex_lock(&bisimulation_lock);
+    if (model->bisimulation == NULL) {
+        model->bisimulation = compute_bisimulation(model);
+    }
+    Bisimulation* bisim = model->bisimulation;
+    pthread_mutex_unlock(&bisimulation_lock);
+    return bisim;
+}
+
+// Drop the bisimulation after a change to the model
+void invalidate_bisimulation(Model* model) {
+    free_bisimulation(model->bisimulation);
+    model->bisimulation = NULL;
+}
+
+// Check the formulas of this model on its bisimulation quotient
+void enable_bisimulation(Model* model, bool enabled) {
+    model->use_bisimulation = enabled;
+}
+
+// The model formulas are evaluated on: the quotient if the model checks on
+// its bisimulation (and it could be computed), else the model itself
+Model* formula_model(Model* model) {
+    Bisimulation* bisim = model->use_bisimulation ? get_bisimulation(model) : NULL;
+    return bisim != NULL ? bisim->quotient : model;
+}
+
+// Map the satisfaction set of a formula evaluated on formula_model(model)
+// back to the states of the model
+void lift_formula_result(StateSet* result, StateSet* set, Model* model) {
+    Bisimulation* bisim = model->use_bisimulation ? get_bisimulation(model) : NULL;
+    if (bisim == NULL) {
+        copy_state_set(result, set);
+        return;
+    }
+    lift_state_set(result, set, bisim);
+}
+
+// [[op p]] for an atomic proposition p, on formula_model(model)
+void eval_unary_formula(StateSet* result, CtlUnaryOperator op, Model* model, int prop_p) {
+    Model* target = formula_model(model);
+    StateSet p, target_result;
+
+    eval_atomic_prop(&p, target, prop_p);
+    op(&target_result, &p, target);
+    lift_formula_result(result, &target_result, model);
+}
+
+// [[op(p, q)]] for atomic propositions p and q, on formula_model(model)
+void eval_binary_formula(StateSet* result, CtlBinaryOperator op, Model* model, int prop_p, int prop_q) {
+    Model* target = formula_model(model);
+    StateSet p, q, target_result;
+
+    eval_atomic_prop(&p, target, prop_p);
+    eval_atomic_prop(&q, target, prop_q);
+    op(&target_result, &p, &q, target);
+    lift_formula_result(result, &target_result, model);
+}
+
+// The operators themselves, run by the caller on the quotient model of
+// get_bisimulation: atomic propositions are evaluated there directly, and
+// only the satisfaction set of the whole formula is lifted back
+const CtlEngine bisim_engine = {
+    "bisimulation_quotient",
+    existential_successor, universal_successor,
+    eval_ef, eval_eg, eval_af, eval_ag,
+    eval_eu, eval_au,
+    true
+};
@@ -3,19 +3,20 @@
 #define CTL_COMMON_H
 
 #include <stdbool.h>
+#include <stdio.h>
+#include <stdint.h>
 
-// Maximum number of states and atomic propositions
-#define MAX_STATES 100
+// Maximum number of states and atomic propositions (MAX_STATES is the small
+// model bound, so every model can use the word-set kernels)
+#define MAX_STATES 256
 #define MAX_PROPS 20
 #define MAX_TRANSITIONS 10
+#define PROP_TABLE_SIZE 64    // Slots of the proposition name table: a power of two above 2 * MAX_PROPS
 
 // Structure for representing a state
 
-// Global variables to store actual model dimensions
-extern int g_num_states;
-extern int g_num_props;
-extern int g_max_transitions;
-extern char* msg_tag;
+extern _Thread_local char* msg_tag;
+extern _Thread_local FILE* g_verify_out;  // Verification output of the current thread (NULL = stdout)
 
 typedef struct {
     int id;
@@ -30,14 +31,147 @@ typedef struct {
     int num_states;
     int num_props;
     char* prop_names[MAX_PROPS];  // Names of atomic propositions
+    int prop_table[PROP_TABLE_SIZE]; // Name hash table (open addressing): proposition ID or -1
+    bool use_reach_index;         // Answer EF queries from the reachability index
+    struct ReachIndex* reach_index;  // Built on the first EF query, dropped on graph changes
+    bool use_small_kernels;       // Run the operators on word sets when the model is small
+    struct SmallModel* small_model;  // Built on the first operator call, dropped on changes
+    bool use_bisimulation;        // Check formulas on the bisimulation quotient
+    struct Bisimulation* bisimulation;  // Built on first use, dropped on changes
 } Model;
 
 // Structure for representing a set of states
 typedef struct {
     bool members[MAX_STATES];
     int size;
+    int num_states;      // States of the model the set belongs to
 } StateSet;
 
+// Result of one equation check, as handed to the report writer
+typedef struct {
+    int equation;
+    int prop_p;
+    int prop_q;          // -1 for equations with a single proposition
+    StateSet computed;
+    StateSet manual;
+    bool holds;
+} EquationResult;
+
+// One (equation, P, Q) check of the sweep over all propositions
+typedef struct {
+    int equation;
+    int prop_p;
+    int prop_q;          // -1 for equations with a single proposition
+} EquationTask;
+
+// A CTL evaluation engine: one entry point per temporal operator, with the
+// same contract as the functions in ctl_operators.c
+typedef struct {
+    const char* name;
+    void (*ex)(StateSet* result, StateSet* set, Model* model);
+    void (*ax)(StateSet* result, StateSet* set, Model* model);
+    void (*ef)(StateSet* result, StateSet* prop_p, Model* model);
+    void (*eg)(StateSet* result, StateSet* prop_p, Model* model);
+    void (*af)(StateSet* result, StateSet* prop_p, Model* model);
+    void (*ag)(StateSet* result, StateSet* prop_p, Model* model);
+    void (*eu)(StateSet* result, StateSet* prop_p, StateSet* prop_q, Model* model);
+    void (*au)(StateSet* result, StateSet* prop_p, StateSet* prop_q, Model* model);
+    bool on_quotient;    // Check whole formulas on the bisimulation quotient, then lift the result
+} CtlEngine;
+
+// Temporal operators with the signatures of the CtlEngine entry points
+typedef void (*CtlUnaryOperator)(StateSet* result, StateSet* prop_p, Model* model);
+typedef void (*CtlBinaryOperator)(StateSet* result, StateSet* prop_p, StateSet* prop_q, Model* model);
+
+// Coarsest bisimulation of a model, with the quotient model it induces
+typedef struct Bisimulation {
+    int num_states;                 // States of the original model
+    int num_blocks;                 // Equivalence classes = states of the quotient
+    int block[MAX_STATES];          // Class of each original state
+    int representative[MAX_STATES]; // First original state of each class
+    Model* quotient;
+} Bisimulation;
+
+// Systems of identical processes, built into a Model by interleaving
+#define MAX_PROCESSES 8
+#define MAX_LOCAL_STATES 8
+#define MAX_PROCESS_MOVES 16
+#define MAX_COUNTING_PROPS 8
+
+// A template move between local states, only enabled while no other process
+// is in local state `exclusive` (-1 for an unguarded move)
+typedef struct {
+    int from;
+    int to;
+    int exclusive;
+} ProcessMove;
+
+// Proposition holding where at least `at_least` processes are in `local`
+typedef struct {
+    char name[16];
+    int local;
+    int at_least;
+} CountingProp;
+
+typedef struct {
+    int num_processes;
+    int num_locals;
+    char local_names[MAX_LOCAL_STATES][8];
+    int num_moves;
+    ProcessMove moves[MAX_PROCESS_MOVES];
+    int num_counting_props;
+    CountingProp counting_props[MAX_COUNTING_PROPS];
+    int num_symmetry_classes;
+    int symmetry_class[MAX_PROCESSES];      // Interchangeable processes share a class (-1 for none)
+} ProcessSystem;
+
+// The built model with the global state each model state stands for
+typedef struct {
+    Model* model;
+    int num_processes;
+    int locals[MAX_STATES][MAX_PROCESSES];  // Orbit representative of each model state
+    long num_full_states;                   // Explored states without symmetry reduction
+} ProcessModel;
+
+// Small models (at most 256 states): state sets as 1, 2 or 4 machine words
+#define SMALL_MODEL_MAX_STATES 256
+#define SMALL_DISPATCH_MAX_STATES 64  // The operators use the kernels up to one word per set
+#define SMALL_MODEL_WORDS (SMALL_MODEL_MAX_STATES / 64)
+
+typedef struct {
+    uint64_t words[SMALL_MODEL_WORDS];
+} SmallSet;
+
+typedef struct SmallModel SmallModel;
+
+typedef void (*SmallUnaryKernel)(SmallSet* result, const SmallSet* set, const SmallModel* small);
+typedef void (*SmallBinaryKernel)(SmallSet* result, const SmallSet* prop_p, const SmallSet* prop_q,
+                                  const SmallModel* small);
+
+// Operators specialized for one word count, selected by build_small_model
+typedef struct {
+    SmallUnaryKernel ex;
+    SmallUnaryKernel ax;
+    SmallUnaryKernel ef;
+    SmallUnaryKernel eg;
+    SmallUnaryKernel af;
+    SmallUnaryKernel ag;
+    SmallBinaryKernel eu;
+    SmallBinaryKernel au;
+} SmallKernels;
+
+struct SmallModel {
+    int num_states;
+    int num_props;
+    int num_words;                  // 1, 2 or 4
+    const SmallKernels* kernels;
+    SmallSet all;                   // Every state of the model
+    SmallSet has_succ;              // States with at least one transition
+    SmallSet succ[MAX_STATES];      // Successor mask of each state
+    SmallSet pred[MAX_STATES];      // Predecessor mask of each state
+    SmallSet props[MAX_PROPS];      // States labelled with each proposition
+};
+
 // Model creation and manipulation
 Model* create_model();
 void free_model(Model* model);
@@ -69,6 +203,52 @@ void eval_ag(StateSet* result, StateSet* prop_p, Model* model);             // A
 void eval_eu(StateSet* result, StateSet* prop_p, StateSet* prop_q, Model* model); // EU
 void eval_au(StateSet* result, StateSet* prop_p, StateSet* prop_q, Model* model); // AU
 
+// Small-model kernels (build once, then call small->kernels->ex(...) etc.)
+bool build_small_model(SmallModel* small, Model* model);
+void small_set_from_state_set(SmallSet* dest, StateSet* src, const SmallModel* small);
+void small_set_to_state_set(StateSet* dest, const SmallSet* src, const SmallModel* small);
+void enable_small_kernels(Model* model, bool enabled);
+void invalidate_small_model(Model* model);
+const SmallModel* dispatch_small_model(Model* model);
+void small_unary(StateSet* result, StateSet* set, const SmallModel* small, SmallUnaryKernel kernel);
+void small_binary(StateSet* result, StateSet* prop_p, StateSet* prop_q, const SmallModel* small,
+                  SmallBinaryKernel kernel);
+extern const CtlEngine small_kernels_engine;
+
+// Reachability index (SCC condensation with a co-reachability row per component)
+void enable_reach_index(Model* model, bool enabled);
+void invalidate_reach_index(Model* model);
+bool reach_index_ef(StateSet* result, StateSet* prop_p, Model* model);
+extern const CtlEngine reach_index_engine;
+
+// Bisimulation minimization (check on the quotient, lift results back)
+Bisimulation* compute_bisimulation(Model* model);
+void free_bisimulation(Bisimulation* bisim);
+Bisimulation* get_bisimulation(Model* model);  // Cached in the model until it changes
+void invalidate_bisimulation(Model* model);
+void project_state_set(StateSet* result, StateSet* set, Bisimulation* bisim);
+void lift_state_set(StateSet* result, StateSet* set, Bisimulation* bisim);
+void enable_bisimulation(Model* model, bool enabled);
+Model* formula_model(Model* model);  // The quotient with use_bisimulation, else the model
+void lift_formula_result(StateSet* result, StateSet* set, Model* model);
+void eval_unary_formula(StateSet* result, CtlUnaryOperator op, Model* model, int prop_p);
+void eval_binary_formula(StateSet* result, CtlBinaryOperator op, Model* model, int prop_p, int prop_q);
+extern const CtlEngine bisim_engine;
+
+// Process systems (interleaving of N template copies, optional symmetry reduction)
+void init_process_system(ProcessSystem* system, int num_processes);
+int add_local_state(ProcessSystem* system, const char* name);
+bool add_process_move(ProcessSystem* system, int from, int to, int exclusive);
+bool add_counting_proposition(ProcessSystem* system, const char* name, int local, int at_least);
+bool declare_process_symmetry(ProcessSystem* system, const int* processes, int count);
+void canonicalize_process_state(const ProcessSystem* system, int* locals);
+ProcessModel* build_process_model(const ProcessSystem* system);
+ProcessModel* build_process_model_reduced(const ProcessSystem* system, const bool* observed);
+void free_process_model(ProcessModel* pm);
+int find_process_state(ProcessModel* pm, const ProcessSystem* system, const int* locals);
+void init_mutex_system(ProcessSystem* system, int num_processes);
+bool check_mutex_properties(Model* model);
+
 // Helper functions to access model internals
 int get_num_states(Model* model);
 int get_num_props(Model* model);
@@ -91,9 +271,25 @@ void verify_equation10(Model* model, int prop_p);
 void verify_equation11(Model* model, int prop_p, int prop_q);
 void verify_equation12(Model* model, int prop_p, int prop_q);
 
+// Report writer (per-equation CSV and Markdown files)
+bool report_open(const char* output_dir, Model* model);
+void report_result(int equation, int prop_p, int prop_q, StateSet* computed, StateSet* manual, bool holds);
+void report_write(const EquationResult* result);
+void report_capture(EquationResult* slot);  // Divert this thread's results into slot (NULL to stop)
+void report_close(void);
+
+// Sweep driver (serial or sharded over a worker pool)
+int build_equation_tasks(EquationTask* tasks, int max_tasks, Model* model);
+void run_equation_task(Model* model, const EquationTask* task);
+bool run_equation_sweep(Model* model, const EquationTask* tasks, int num_tasks, int num_threads);
+
+// Differential self-check of the engines on random models
+int run_selfcheck(int iterations, unsigned int seed);
+
 // Utility functions
 void print_model_info(Model* model);
 void print_state_set(StateSet* set, Model* model, const char* label);
+void fprint_state_set(FILE* file, StateSet* set, Model* model, const char* label);
 
 // Create a mutex model
 Model* create_mutex_model();
@@ -2,6 +2,8 @@
 #include "ctl_common.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
 
 typedef enum {
     p1n = 0,
@@ -12,6 +14,11 @@ typedef enum {
     p2c = 5
 } proposition_t;
 
+// Upper bound on the (equation, P, Q) checks of one sweep
+#define MAX_TASKS (MAX_PROPS * 8 + (MAX_PROPS / 2) * (MAX_PROPS / 2) * 4)
+
+static EquationTask tasks[MAX_TASKS];
+
 const char* proposition_names[] = {
     "p1n",
     "p1t",
@@ -21,7 +28,73 @@ const char* proposition_names[] = {
     "p2c"
 };
 
-int main() {
+// Print command line usage
+static void print_usage(const char* program) {
+    printf("Usage: %s [--report <output_dir>] [-j <threads>] [--reach-index] [--bisim]\n", program);
+    printf("       %*s [--processes <n> [--symmetry | --partial-order]]\n", (int)strlen(program), "");
+    printf("       %s --selfcheck <iterations> [--seed <n>]\n", program);
+    printf("  --report <output_dir>  write per-equation CSV and Markdown reports (default: output)\n");
+    printf("  -j <threads>           run the equation checks on a pool of worker threads\n");
+    printf("                         (0 = one per online CPU, default: 1)\n");
+    printf("  --reach-index          answer EF/AG queries from a reachability index of the model\n");
+    printf("  --bisim                check each formula on the bisimulation quotient of the model\n");
+    printf("                         and map its states back to the model\n");
+    printf("  --processes <n>        check an n-process mutex built by interleaving instead of\n");
+    printf("                         the lecture model, and its mutual exclusion properties\n");
+    printf("                         (at most %d processes; the %d-state, %d-proposition model\n",
+           MAX_PROCESSES, MAX_STATES, MAX_PROPS);
+    printf("                         limits allow n <= 5 without --symmetry)\n");
+    printf("  --symmetry             declare the processes interchangeable (one state per orbit)\n");
+    printf("  --partial-order        explore only ample interleavings, observing the critical\n");
+    printf("                         section (sound for CTL without EX/AX over some_c, two_c);\n");
+    printf("                         checks the mutual exclusion properties only, no sweep\n");
+    printf("  --selfcheck <n>        cross-check the engines against a reference on n random models\n");
+    printf("  --seed <n>             random seed of the self-check (default: 1)\n");
+}
+
+int main(int argc, char* argv[]) {
+    const char* report_dir = "output";
+    int num_threads = 1;
+    int selfcheck_iterations = 0;
+    unsigned int selfcheck_seed = 1;
+    bool use_reach_index = false;
+    bool use_bisimulation = false;
+    int num_processes = 0;
+    bool use_symmetry = false;
+    bool use_partial_order = false;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--report") == 0 && i + 1 < argc) {
+            report_dir = argv[++i];
+        } else if (strcmp(argv[i], "--selfcheck") == 0 && i + 1 < argc) {
+            selfcheck_iterations = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            selfcheck_seed = (unsigned int)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--reach-index") == 0) {
+            use_reach_index = true;
+        } else if (strcmp(argv[i], "--bisim") == 0) {
+            use_bisimulation = true;
+        } else if (strcmp(argv[i], "--processes") == 0 && i + 1 < argc) {
+            num_processes = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--symmetry") == 0) {
+            use_symmetry = true;
+        } else if (strcmp(argv[i], "--partial-order") == 0) {
+            use_partial_order = true;
+        } else if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+            num_threads = atoi(argv[++i]);
+            if (num_threads <= 0) {
+                num_threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+            }
+        } else {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (selfcheck_iterations > 0) {
+        return run_selfcheck(selfcheck_iterations, selfcheck_seed) == 0 ? 0 : 1;
+    }
+
     printf("===== CTL Model Checking: Theorem 3 Verification =====\n");
     printf("This program verifies the 12 equations of Theorem 3 from the CTL model checking lecture.\n");
     printf("Theorem 3 (CTL model checking): In computation structures, the set [[φ]] of all states\n");
@@ -40,11 +113,83 @@ int main() {
     printf("12. [[AP UQ]] = μZ.([[Q]] ∪ ([[P]] ∩ τAX(Z)))\n\n");
     
     
-    printf("Creating mutual exclusion model from the lecture...\n");
-    Model* model = create_mutex_model();
+    Model* model;
+    if (num_processes > 0) {
+        ProcessSystem system;
+        int processes[MAX_PROCESSES];
+        if (num_processes > MAX_PROCESSES) {
+            fprintf(stderr, "Error: At most %d processes are supported\n", MAX_PROCESSES);
+            return 1;
+        }
+        printf("Creating %d-process mutual exclusion model%s...\n", num_processes,
+               use_symmetry ? " with symmetry reduction" :
+               use_partial_order ? " with partial-order reduction" : "");
+        init_mutex_system(&system, num_processes);
+        if (use_symmetry) {
+            for (int i = 0; i < num_processes; i++) processes[i] = i;
+            declare_process_symmetry(&system, processes, num_processes);
+        }
+        ProcessModel* pm;
+        if (use_partial_order) {
+            // Observe the counting propositions on the critical section (local
+            // state 2), which follow the per-process ones
+            bool observed[MAX_PROPS] = {false};
+            int first = use_symmetry ? 0 : num_processes * system.num_locals;
+            for (int k = 0; k < system.num_counting_props; k++) {
+                observed[first + k] = (system.counting_props[k].local == 2);
+            }
+            pm = build_process_model_reduced(&system, observed);
+        } else {
+            pm = build_process_model(&system);
+        }
+        if (pm == NULL) {
+            if (!use_symmetry) {
+                fprintf(stderr, "Try --symmetry or fewer processes\n");
+            }
+            return 1;
+        }
+        if (use_partial_order) {
+            printf("%d states explored\n", pm->model->num_states);
+        } else {
+            printf("%d states represent %ld reachable global states\n", pm->model->num_states, pm->num_full_states);
+        }
+        model = pm->model;
+        pm->model = NULL;
+        free_process_model(pm);
+    } else {
+        printf("Creating mutual exclusion model from the lecture...\n");
+        model = create_mutex_model();
+    }
+    enable_reach_index(model, use_reach_index);
+    enable_bisimulation(model, use_bisimulation);
 
     // Print model information
     print_model_info(model);
+    if (use_bisimulation) {
+        Bisimulation* bisim = get_bisimulation(model);
+        if (bisim == NULL) {
+            free_model(model);
+            return 1;
+        }
+        printf("Bisimulation quotient: %d states for the %d of the model\n", bisim->num_blocks, model->num_states);
+    }
+
+    // A partial-order reduced model only keeps the answers of X-free formulas
+    // in its initial state, so the all-state sweep (with EX/AX) does not apply
+    if (use_partial_order) {
+        printf("Partial-order reduction keeps only initial-state answers of formulas without\n");
+        printf("EX/AX; skipping the Theorem 3 sweep.\n");
+        printf("\n===== Checking Mutual Exclusion Properties (initial state) =====\n");
+        bool holds = check_mutex_properties(model);
+        free_model(model);
+        return holds ? 0 : 1;
+    }
+
+    // Stream the per-equation reports while the equations are verified
+    if (!report_open(report_dir, model)) {
+        free_model(model);
+        return 1;
+    }
     
     // Verify all equations
     printf("\n===== Verifying Semantic Equations of Theorem 3 =====\n");
@@ -61,40 +206,28 @@ int main() {
     // verify_equation11(model, 1, 2); // Using p1t and p1c propositions
     // verify_equation12(model, 3, 4); // Using p2t and p2c propositions
 
-    // Loop for equations that use 1 proposition input (from p1n to p2n)
-    for (int i = p1n; i <= p2c; i++) {
-        printf("----------------------------------------\n");
-        verify_equation1(model, i);
-        printf("----------------------------------------\n");
-        verify_equation2(model, i);
-        printf("----------------------------------------\n");
-        verify_equation5(model, i);
-        printf("----------------------------------------\n");
-        verify_equation6(model, i);
-        printf("----------------------------------------\n");
-        verify_equation7(model, i);
-        printf("----------------------------------------\n");
-        verify_equation8(model, i);
-        printf("----------------------------------------\n");
-        verify_equation9(model, i);
-        printf("----------------------------------------\n");
-        verify_equation10(model, i);
+    // Sweep equations 1, 2, 5-10 over every proposition and 3, 4, 11, 12 over
+    // every (p1x, p2x) pair, optionally sharded over a worker pool
+    int num_tasks = build_equation_tasks(tasks, MAX_TASKS, model);
+    if (num_tasks < 0) {
+        fprintf(stderr, "Error: More than %d equation checks for this model\n", MAX_TASKS);
+        report_close();
+        free_model(model);
+        return 1;
     }
-    
-    for (int i = p1n; i <= p1c; i++) {
-        for (int j = p2n; j <= p2c; j++) {
-            printf("----------------------------------------\n");
-            verify_equation3(model, i, j);
-            printf("----------------------------------------\n");
-            verify_equation4(model, i, j);
-            printf("----------------------------------------\n");
-            verify_equation11(model, i, j);
-            printf("----------------------------------------\n");
-            verify_equation12(model, i, j);
-            }
+    if (!run_equation_sweep(model, tasks, num_tasks, num_threads)) {
+        report_close();
+        free_model(model);
+        return 1;
+    }
+
+    // The process model also answers for the system it was built from
+    bool properties_hold = true;
+    if (num_processes > 0) {
+        printf("\n===== Checking Mutual Exclusion Properties (initial state) =====\n");
+        properties_hold = check_mutex_properties(model);
     }
 
-        
     // for (int i = p1n; i <= p2c; i++) {
     //     printf("Test #%d with input proposition is %s ", i, proposition_names[i]);
     //     verify_equation1(model);
@@ -106,8 +239,9 @@ int main() {
     // }
 
     // Clean up
+    report_close();
     free_model(model);
     printf("\n===== Verification Complete =====\n");
     printf("All 12 equations from Theorem 3 have been verified.\n");
-    return 0;
+    return properties_hold ? 0 : 1;
 }
\ No newline at end of file
@@ -6,10 +6,6 @@
 
 /* Model Operations */
 
-// Define the global variables
-int g_num_states        = 0;
-int g_num_props         = 0;
-int g_max_transitions   = 0;
 // Create a new empty model
 Model* create_model() {
     Model* model = (Model*)malloc(sizeof(Model));
@@ -20,27 +16,24 @@ Model* create_model() {
     
     model->num_states = 0;
     model->num_props = 0;
-
-    // Set global dimensions
-    g_num_states    = 0;
-    g_num_props     = 0;
-    g_max_transitions = 0;
+    for (int i = 0; i < PROP_TABLE_SIZE; i++) {
+        model->prop_table[i] = -1;
+    }
+    model->use_reach_index = false;
+    model->reach_index = NULL;
+    model->use_small_kernels = true;
+    model->small_model = NULL;
+    model->use_bisimulation = false;
+    model->bisimulation = NULL;
     return model;
 }
-
-// Update the global model dimensions
-void update_global_dimensions(Model* model) {
-    g_num_states = model->num_states;
-    g_num_props = model->num_props;
-    
-    // Find max transitions
-    g_max_transitions = 0;
-    for (int i = 0; i < model->num_states; i++) {
-        if (model->states[i].num_transitions > g_max_transitions) {
-            g_max_transitions = model->states[i].num_transitions;
-        }
-    }
+// Drop everything derived from the model after a change to it
+static void model_changed(Model* model) {
+    invalidate_reach_index(model);
+    invalidate_small_model(model);
+    invalidate_bisimulation(model);
 }
+
 // Free a model
 void free_model(Model* model) {
     if (model == NULL) return;
@@ -49,6 +42,7 @@ void free_model(Model* model) {
         free(model->prop_names[i]);
     }
     
+    model_changed(model);
     free(model);
 }
 
@@ -69,6 +63,7 @@ int add_state(Model* model) {
     }
     
     model->num_states++;
+    model_changed(model);
     return state_id;
 }
 
@@ -87,26 +82,44 @@ bool add_transition(Model* model, int from_state, int to_state) {
     
     // Add the transition
     model->states[from_state].transitions[model->states[from_state].num_transitions++] = to_state;
+    model_changed(model);
     return true;
 }
 
+// Slot of the name table holding the proposition prop_name, or the empty
+// slot where it would go
+static int* proposition_slot(Model* model, const char* prop_name) {
+    // FNV-1a hash, then linear probing (the table is never more than half full)
+    unsigned int hash = 2166136261u;
+    for (const char* c = prop_name; *c != '\0'; c++) {
+        hash = (hash ^ (unsigned char)*c) * 16777619u;
+    }
+    
+    for (unsigned int slot = hash;; slot++) {
+        int* entry = &model->prop_table[slot & (PROP_TABLE_SIZE - 1)];
+        if (*entry < 0 || strcmp(model->prop_names[*entry], prop_name) == 0) {
+            return entry;
+        }
+    }
+}
+
 // Add a new atomic proposition to the model
 int add_proposition(Model* model, const char* prop_name) {
+    // Check if the proposition already exists
+    int* entry = proposition_slot(model, prop_name);
+    if (*entry >= 0) {
+        return *entry;  // Return existing proposition ID
+    }
+    
     if (model->num_props >= MAX_PROPS) {
         fprintf(stderr, "Error: Maximum number of propositions reached\n");
         return -1;
     }
     
-    // Check if the proposition already exists
-    for (int i = 0; i < model->num_props; i++) {
-        if (strcmp(model->prop_names[i], prop_name) == 0) {
-            return i;  // Return existing proposition ID
-        }
-    }
-    
     // Add the new proposition
     int prop_id = model->num_props;
     model->prop_names[prop_id] = strdup(prop_name);
+    *entry = prop_id;
     
     // Initialize the proposition to false for all existing states
     for (int i = 0; i < model->num_states; i++) {
@@ -114,6 +127,7 @@ int add_proposition(Model* model, const char* prop_name) {
     }
     
     model->num_props++;
+    model_changed(model);
     return prop_id;
 }
 
@@ -126,6 +140,7 @@ void set_proposition_true(Model* model, int state_id, int prop_id) {
     }
     
     model->states[state_id].atomic_props[prop_id] = true;
+    model_changed(model);
 }
 
 // Set a proposition to false for a state
@@ -137,17 +152,12 @@ void set_proposition_false(Model* model, int state_id, int prop_id) {
     }
     
     model->states[state_id].atomic_props[prop_id] = false;
+    model_changed(model);
 }
 
 // Get the ID of a proposition by name
 int get_proposition_id(Model* model, const char* prop_name) {
-    for (int i = 0; i < model->num_props; i++) {
-        if (strcmp(model->prop_names[i], prop_name) == 0) {
-            return i;
-        }
-    }
-    
-    return -1;  // Proposition not found
+    return *proposition_slot(model, prop_name);  // -1 if not found
 }
 
 /* State Set Operations */
@@ -155,6 +165,7 @@ int get_proposition_id(Model* model, const char* prop_name) {
 // Initialize an empty state set
 void init_state_set(StateSet* set, int num_states) {
     set->size = 0;
+    set->num_states = num_states;
     for (int i = 0; i < num_states; i++) {
         set->members[i] = false;
     }
@@ -186,8 +197,9 @@ void complement_state_set(StateSet* result, StateSet* set, int num_states) {
 // Set intersection (X ∩ Y)
 void intersect_state_sets(StateSet* result, StateSet* set1, StateSet* set2) {
     result->size = 0;
+    result->num_states = set1->num_states;
     // for (int i = 0; i < MAX_STATES; i++) { 
-    for (int i = 0; i < g_num_states; i++) { 
+    for (int i = 0; i < set1->num_states; i++) { 
         result->members[i] = set1->members[i] && set2->members[i];
         if (result->members[i]) {
             result->size++;
@@ -198,8 +210,8 @@ void intersect_state_sets(StateSet* result, StateSet* set1, StateSet* set2) {
 // Set union (X ∪ Y)
 void union_state_sets(StateSet* result, StateSet* set1, StateSet* set2) {
     result->size = 0;
-    for (int i = 0; i < MAX_STATES; i++) {
-    // for (int i = 0; i < g_num_states; i++) {
+    result->num_states = set1->num_states;
+    for (int i = 0; i < set1->num_states; i++) {
         result->members[i] = set1->members[i] || set2->members[i];
         if (result->members[i]) {
             result->size++;
@@ -210,15 +222,16 @@ void union_state_sets(StateSet* result, StateSet* set1, StateSet* set2) {
 // Copy state set
 void copy_state_set(StateSet* dest, StateSet* src) {
     dest->size = src->size;
+    dest->num_states = src->num_states;
     // for (int i = 0; i < MAX_STATES; i++) {
-    for (int i = 0; i < g_num_states; i++) {
+    for (int i = 0; i < src->num_states; i++) {
         dest->members[i] = src->members[i];
     }
 }
 
 // Compare two state sets and return true if they are equal
 bool compare_state_sets(StateSet* set1, StateSet* set2) {
-    for (int i = 0; i < g_num_states; i++) {
+    for (int i = 0; i < set1->num_states; i++) {
         if (set1->members[i] != set2->members[i]) {
             return false;
         }
@@ -230,18 +243,23 @@ bool compare_state_sets(StateSet* set1, StateSet* set2) {
 
 // Print the states in a state set
 void print_state_set(StateSet* set, Model* model, const char* label) {
-    printf("%s = {", label);
+    fprint_state_set(stdout, set, model, label);
+}
+
+// Print the states in a state set to the given stream
+void fprint_state_set(FILE* file, StateSet* set, Model* model, const char* label) {
+    fprintf(file, "%s = {", label);
     bool first = true;
     for (int i = 0; i < model->num_states; i++) {
         if (set->members[i]) {
             if (!first) {
-                printf(", ");
+                fprintf(file, ", ");
             }
-            printf("%d", i);
+            fprintf(file, "%d", i);
             first = false;
         }
     }
-    printf("}\n");
+    fprintf(file, "}\n");
 }
 
 // Print information about a model
@@ -418,7 +436,6 @@ Model* create_mutex_model() {
     // From state 8 (tc)
     add_transition(model, 8, 7); // tc -> nc
 
-    update_global_dimensions(model);
     // Print model information
     
     return model;
@@ -5,6 +5,9 @@
 
 /* CTL Operators */
 
+// Every temporal operator first tries the word-set kernels of a small model
+// (ctl_small_kernels.c), then falls back to the StateSet implementation below.
+
 // Evaluate an atomic proposition
 void eval_atomic_prop(StateSet* result, Model* model, int prop_id) {
     init_state_set(result, model->num_states);
@@ -23,6 +26,12 @@ void eval_atomic_prop(StateSet* result, Model* model, int prop_id) {
 
 // Find states that have a successor in the given set (EX)
 void existential_successor(StateSet* result, StateSet* set, Model* model) {
+    const SmallModel* small = dispatch_small_model(model);
+    if (small != NULL) {
+        small_unary(result, set, small, small->kernels->ex);
+        return;
+    }
+
     init_state_set(result, model->num_states);
     
     for (int i = 0; i < model->num_states; i++) {
@@ -41,6 +50,12 @@ void existential_successor(StateSet* result, StateSet* set, Model* model) {
 
 // Find states such that all successors are in the given set (AX)
 void universal_successor(StateSet* result, StateSet* set, Model* model) {
+    const SmallModel* small = dispatch_small_model(model);
+    if (small != NULL) {
+        small_unary(result, set, small, small->kernels->ax);
+        return;
+    }
+
     init_state_set(result, model->num_states);
     
     for (int i = 0; i < model->num_states; i++) {
@@ -66,6 +81,18 @@ void universal_successor(StateSet* result, StateSet* set, Model* model) {
 void eval_ef(StateSet* result, StateSet* prop_p, Model* model) {
     StateSet current, next;
     
+    // Union of precomputed co-reachability rows, if the model keeps an index
+    if (reach_index_ef(result, prop_p, model)) {
+        return;
+    }
+
+    // Word-set kernels on small models
+    const SmallModel* small = dispatch_small_model(model);
+    if (small != NULL) {
+        small_unary(result, prop_p, small, small->kernels->ef);
+        return;
+    }
+    
     // Initialize with states where P is true
     init_state_set(&current, model->num_states); //model.num_states
     copy_state_set(&current, prop_p);
@@ -91,6 +118,12 @@ void eval_ef(StateSet* result, StateSet* prop_p, Model* model) {
 
 // Evaluate EG P (exists globally) - states where there exists a path where P is always true
 void eval_eg(StateSet* result, StateSet* prop_p, Model* model) {
+    const SmallModel* small = dispatch_small_model(model);
+    if (small != NULL) {
+        small_unary(result, prop_p, small, small->kernels->eg);
+        return;
+    }
+
     StateSet current;
     
     // Initialize with all states where P is true
@@ -129,6 +162,12 @@ void eval_eg(StateSet* result, StateSet* prop_p, Model* model) {
 
 // Evaluate AF P (always finally) - states where all paths eventually reach a state where P is true
 void eval_af(StateSet* result, StateSet* prop_p, Model* model) {
+    const SmallModel* small = dispatch_small_model(model);
+    if (small != NULL) {
+        small_unary(result, prop_p, small, small->kernels->af);
+        return;
+    }
+
     StateSet not_p, eg_not_p;
     
     // Calculate ¬P
@@ -143,6 +182,12 @@ void eval_af(StateSet* result, StateSet* prop_p, Model* model) {
 
 // Evaluate AG P (always globally) - states where P is true in all future paths
 void eval_ag(StateSet* result, StateSet* prop_p, Model* model) {
+    const SmallModel* small = dispatch_small_model(model);
+    if (small != NULL && !model->use_reach_index) {
+        small_unary(result, prop_p, small, small->kernels->ag);
+        return;
+    }
+
     StateSet not_p, ef_not_p;
     
     // Calculate ¬P
@@ -157,6 +202,12 @@ void eval_ag(StateSet* result, StateSet* prop_p, Model* model) {
 
 // Evaluate EU P Q (exists until) - states that can reach Q through P states
 void eval_eu(StateSet* result, StateSet* prop_p, StateSet* prop_q, Model* model) {
+    const SmallModel* small = dispatch_small_model(model);
+    if (small != NULL) {
+        small_binary(result, prop_p, prop_q, small, small->kernels->eu);
+        return;
+    }
+
     StateSet current, next, temp;
     
     // Initialize with states where Q is true
@@ -184,6 +235,12 @@ void eval_eu(StateSet* result, StateSet* prop_p, StateSet* prop_q, Model* model)
 
 // Evaluate AU P Q (always until) - states where all paths reach Q through P states
 void eval_au(StateSet* result, StateSet* prop_p, StateSet* prop_q, Model* model) {
+    const SmallModel* small = dispatch_small_model(model);
+    if (small != NULL) {
+        small_binary(result, prop_p, prop_q, small, small->kernels->au);
+        return;
+    }
+
     StateSet not_p, not_q, not_p_and_not_q, eu_result, eg_not_q, temp;
     
     // Initialize all state sets
@@ -0,0 +1,198 @@
+// ctl_parallel.c - Serial and parallel drivers for the sweep of equation checks
+#include "ctl_common.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+
+#define SWEEP_SEPARATOR "----------------------------------------\n"
+
+// Per-task state of a parallel sweep: captured output text and report row
+typedef struct {
+    char* text;
+    size_t text_len;
+    EquationResult result;
+    bool done;
+    bool failed;                // No output buffer, so the task was not run
+} TaskOutput;
+
+// Shared state of a parallel sweep
+typedef struct {
+    Model* model;
+    const EquationTask* tasks;
+    TaskOutput* outputs;
+    int num_tasks;
+    int next_task;              // Next task to hand out to a worker
+    pthread_mutex_t lock;
+    pthread_cond_t task_done;
+} SweepState;
+
+// Fill tasks in the order of the serial sweep: equations 1, 2, 5-10 for every
+// proposition, then equations 3, 4, 11, 12 for every process 1 x process 2 pair
+int build_equation_tasks(EquationTask* tasks, int max_tasks, Model* model) {
+    static const int single_equations[] = {1, 2, 5, 6, 7, 8, 9, 10};
+    static const int pair_equations[] = {3, 4, 11, 12};
+    int num_props = get_num_props(model);
+    int half = num_props / 2;
+    int count = 0;
+
+    for (int i = 0; i < num_props; i++) {
+        for (int e = 0; e < 8; e++) {
+            if (count >= max_tasks) return -1;
+            tasks[count].equation = single_equations[e];
+            tasks[count].prop_p = i;
+            tasks[count].prop_q = -1;
+            count++;
+        }
+    }
+
+    for (int i = 0; i < half; i++) {
+        for (int j = half; j < num_props; j++) {
+            for (int e = 0; e < 4; e++) {
+                if (count >= max_tasks) return -1;
+                tasks[count].equation = pair_equations[e];
+                tasks[count].prop_p = i;
+                tasks[count].prop_q = j;
+                count++;
+            }
+        }
+    }
+
+    return count;
+}
+
+// Run one equation check, preceded by the separator line of the log
+void run_equation_task(Model* model, const EquationTask* task) {
+    FILE* out = g_verify_out != NULL ? g_verify_out : stdout;
+    fprintf(out, SWEEP_SEPARATOR);
+
+    switch (task->equation) {
+        case 1:  verify_equation1(model, task->prop_p); break;
+        case 2:  verify_equation2(model, task->prop_p); break;
+        case 3:  verify_equation3(model, task->prop_p, task->prop_q); break;
+        case 4:  verify_equation4(model, task->prop_p, task->prop_q); break;
+        case 5:  verify_equation5(model, task->prop_p); break;
+        case 6:  verify_equation6(model, task->prop_p); break;
+        case 7:  verify_equation7(model, task->prop_p); break;
+        case 8:  verify_equation8(model, task->prop_p); break;
+        case 9:  verify_equation9(model, task->prop_p); break;
+        case 10: verify_equation10(model, task->prop_p); break;
+        case 11: verify_equation11(model, task->prop_p, task->prop_q); break;
+        case 12: verify_equation12(model, task->prop_p, task->prop_q); break;
+        default:
+            fprintf(stderr, "Error: Invalid equation number %d\n", task->equation);
+    }
+}
+
+// Worker: take the next unclaimed task, run it into a private buffer, publish it
+static void* sweep_worker(void* arg) {
+    SweepState* state = (SweepState*)arg;
+
+    for (;;) {
+        pthread_mutex_lock(&state->lock);
+        int index = state->next_task++;
+        pthread_mutex_unlock(&state->lock);
+
+        if (index >= state->num_tasks) {
+            break;
+        }
+
+        // Without a private buffer the task's log would interleave with the
+        // other workers' on stdout, so it is not run and the sweep fails
+        TaskOutput* output = &state->outputs[index];
+        g_verify_out = open_memstream(&output->text, &output->text_len);
+        if (g_verify_out == NULL) {
+            output->failed = true;
+        } else {
+            report_capture(&output->result);
+            run_equation_task(state->model, &state->tasks[index]);
+            report_capture(NULL);
+            fclose(g_verify_out);
+            g_verify_out = NULL;
+        }
+
+        pthread_mutex_lock(&state->lock);
+        output->done = true;
+        pthread_cond_broadcast(&state->task_done);
+        pthread_mutex_unlock(&state->lock);
+    }
+
+    return NULL;
+}
+
+// Run all tasks. With more than one thread the tasks are sharded over a worker
+// pool and merged back in task order, so the log and reports match a serial run.
+// Returns false if some task could not be run.
+bool run_equation_sweep(Model* model, const EquationTask* tasks, int num_tasks, int num_threads) {
+    if (num_threads <= 1 || num_tasks <= 1) {
+        for (int i = 0; i < num_tasks; i++) {
+            run_equation_task(model, &tasks[i]);
+        }
+        return true;
+    }
+
+    if (num_threads > num_tasks) {
+        num_threads = num_tasks;
+    }
+
+    SweepState state;
+    state.model = model;
+    state.tasks = tasks;
+    state.num_tasks = num_tasks;
+    state.next_task = 0;
+    state.outputs = (TaskOutput*)calloc(num_tasks, sizeof(TaskOutput));
+    pthread_t* workers = (pthread_t*)malloc(num_threads * sizeof(pthread_t));
+    if (state.outputs == NULL || workers == NULL) {
+        fprintf(stderr, "Error: Memory allocation failed for parallel sweep, running serially\n");
+        free(state.outputs);
+        free(workers);
+        return run_equation_sweep(model, tasks, num_tasks, 1);
+    }
+    pthread_mutex_init(&state.lock, NULL);
+    pthread_cond_init(&state.task_done, NULL);
+
+    int started = 0;
+    for (int t = 0; t < num_threads; t++) {
+        if (pthread_create(&workers[t], NULL, sweep_worker, &state) != 0) {
+            fprintf(stderr, "Error: Could not start worker thread %d\n", t);
+            break;
+        }
+        started++;
+    }
+    if (started == 0) {
+        sweep_worker(&state);
+    }
+
+    // Merge: emit each task's output as soon as it and all earlier tasks are done
+    bool ok = true;
+    for (int i = 0; i < num_tasks; i++) {
+        TaskOutput* output = &state.outputs[i];
+
+        pthread_mutex_lock(&state.lock);
+        while (!output->done) {
+            pthread_cond_wait(&state.task_done, &state.lock);
+        }
+        pthread_mutex_unlock(&state.lock);
+
+        if (output->failed) {
+            fprintf(stderr, "Error: Could not allocate output buffer for task %d\n", i);
+            ok = false;
+            continue;
+        }
+        if (output->text != NULL) {
+            fwrite(output->text, 1, output->text_len, stdout);
+            free(output->text);
+            output->text = NULL;
+        }
+        report_write(&output->result);
+    }
+
+    for (int t = 0; t < started; t++) {
+        pthread_join(workers[t], NULL);
+    }
+
+    pthread_cond_destroy(&state.task_done);
+    pthread_mutex_destroy(&state.lock);
+    free(workers);
+    free(state.outputs);
+    return ok;
+}
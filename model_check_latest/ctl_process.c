@@ -0,0 +1,458 @@
+// ctl_process.c - Models built as interleavings of identical processes
+//
+// A ProcessSystem runs N copies of one process template. A global state is
+// the vector of the processes' local states; a step moves one process along
+// a template move. Processes declared symmetric are interchangeable, so a
+// global state and every permutation of it among those processes behave
+// alike: the builder keeps one representative per orbit (the vector sorted
+// within each symmetry class), which cuts the state space by up to N!.
+// Per-process propositions are not invariant under such permutations, so a
+// symmetric system is labelled with counting propositions only.
+#include "ctl_common.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Open-addressing table from encoded global states to model states, kept
+// at most half full so probing always reaches an empty slot
+#define STATE_TABLE_BITS 10
+#define STATE_TABLE_SIZE (1 << STATE_TABLE_BITS)
+
+#if STATE_TABLE_SIZE < 2 * MAX_STATES
+#error "STATE_TABLE_SIZE must be at least twice MAX_STATES"
+#endif
+
+typedef struct {
+    uint64_t key[STATE_TABLE_SIZE];
+    int state[STATE_TABLE_SIZE];     // -1 for an empty slot
+} StateTable;
+
+// Start a system of num_processes copies of an empty template
+void init_process_system(ProcessSystem* system, int num_processes) {
+    memset(system, 0, sizeof(ProcessSystem));
+    system->num_processes = num_processes;
+    system->num_symmetry_classes = 0;
+    for (int i = 0; i < MAX_PROCESSES; i++) {
+        system->symmetry_class[i] = -1;
+    }
+}
+
+int add_local_state(ProcessSystem* system, const char* name) {
+    if (system->num_locals >= MAX_LOCAL_STATES) {
+        fprintf(stderr, "Error: Maximum number of local states reached\n");
+        return -1;
+    }
+    snprintf(system->local_names[system->num_locals], sizeof(system->local_names[0]), "%s", name);
+    return system->num_locals++;
+}
+
+// Add a template move; `exclusive` is a local state no other process may be
+// in while the move is taken (-1 for an unguarded move)
+bool add_process_move(ProcessSystem* system, int from, int to, int exclusive) {
+    if (system->num_moves >= MAX_PROCESS_MOVES) {
+        fprintf(stderr, "Error: Maximum number of process moves reached\n");
+        return false;
+    }
+    system->moves[system->num_moves].from = from;
+    system->moves[system->num_moves].to = to;
+    system->moves[system->num_moves].exclusive = exclusive;
+    system->num_moves++;
+    return true;
+}
+
+// Label the states where at least `at_least` processes are in `local`
+bool add_counting_proposition(ProcessSystem* system, const char* name, int local, int at_least) {
+    if (system->num_counting_props >= MAX_COUNTING_PROPS) {
+        fprintf(stderr, "Error: Maximum number of counting propositions reached\n");
+        return false;
+    }
+    CountingProp* prop = &system->counting_props[system->num_counting_props++];
+    snprintf(prop->name, sizeof(prop->name), "%s", name);
+    prop->local = local;
+    prop->at_least = at_least;
+    return true;
+}
+
+// Declare the given processes interchangeable (the full permutation group over them)
+bool declare_process_symmetry(ProcessSystem* system, const int* processes, int count) {
+    for (int i = 0; i < count; i++) {
+        if (processes[i] < 0 || processes[i] >= system->num_processes ||
+            system->symmetry_class[processes[i]] >= 0) {
+            fprintf(stderr, "Error: Invalid or repeated process %d in symmetry declaration\n", processes[i]);
+            return false;
+        }
+    }
+    for (int i = 0; i < count; i++) {
+        system->symmetry_class[processes[i]] = system->num_symmetry_classes;
+    }
+    system->num_symmetry_classes++;
+    return true;
+}
+
+// Map a global state to its orbit representative: local states sorted within each symmetry class
+void canonicalize_process_state(const ProcessSystem* system, int* locals) {
+    for (int c = 0; c < system->num_symmetry_classes; c++) {
+        // Insertion sort over the positions of the class (N is small)
+        int positions[MAX_PROCESSES];
+        int count = 0;
+        for (int i = 0; i < system->num_processes; i++) {
+            if (system->symmetry_class[i] == c) {
+                positions[count++] = i;
+            }
+        }
+        for (int a = 1; a < count; a++) {
+            int value = locals[positions[a]];
+            int b = a - 1;
+            while (b >= 0 && locals[positions[b]] > value) {
+                locals[positions[b + 1]] = locals[positions[b]];
+                b--;
+            }
+            locals[positions[b + 1]] = value;
+        }
+    }
+}
+
+static uint64_t encode_locals(const ProcessSystem* system, const int* locals) {
+    uint64_t key = 0;
+    for (int i = 0; i < system->num_processes; i++) {
+        key = (key << 4) | (uint64_t)locals[i];
+    }
+    return key;
+}
+
+// Slot holding the key, or the empty slot where it would be inserted
+static unsigned int table_probe(const StateTable* table, uint64_t key) {
+    unsigned int slot = (unsigned int)((key * 0x9E3779B97F4A7C15ULL) >> (64 - STATE_TABLE_BITS));
+    while (table->state[slot] >= 0 && table->key[slot] != key) {
+        slot = (slot + 1) % STATE_TABLE_SIZE;
+    }
+    return slot;
+}
+
+// Model state of an encoded global state, or -1 if not added yet
+static int table_find(const StateTable* table, uint64_t key) {
+    return table->state[table_probe(table, key)];
+}
+
+static void table_insert(StateTable* table, uint64_t key, int state) {
+    unsigned int slot = table_probe(table, key);
+    table->key[slot] = key;
+    table->state[slot] = state;
+}
+
+// Number of global states the representative stands for: a multinomial per symmetry class
+static long orbit_size(const ProcessSystem* system, const int* locals) {
+    long size = 1;
+    for (int c = 0; c < system->num_symmetry_classes; c++) {
+        int per_local[MAX_LOCAL_STATES] = {0};
+        int seen = 0;
+        for (int i = 0; i < system->num_processes; i++) {
+            if (system->symmetry_class[i] != c) continue;
+            seen++;
+            per_local[locals[i]]++;
+            size = size * seen / per_local[locals[i]];
+        }
+    }
+    return size;
+}
+
+// Label a new model state with the propositions of its global state
+static void label_process_state(const ProcessSystem* system, ProcessModel* pm, int state_id, bool per_process) {
+    const int* locals = pm->locals[state_id];
+    int counts[MAX_LOCAL_STATES] = {0};
+    int prop = 0;
+
+    for (int i = 0; i < system->num_processes; i++) {
+        counts[locals[i]]++;
+    }
+    if (per_process) {
+        for (int i = 0; i < system->num_processes; i++) {
+            set_proposition_true(pm->model, state_id, prop + locals[i]);
+            prop += system->num_locals;
+        }
+    }
+    for (int k = 0; k < system->num_counting_props; k++, prop++) {
+        const CountingProp* counting = &system->counting_props[k];
+        if (counts[counting->local] >= counting->at_least) {
+            set_proposition_true(pm->model, state_id, prop);
+        }
+    }
+}
+
+static bool move_enabled(const ProcessMove* move, int local, const int* counts) {
+    return move->from == local &&
+           (move->exclusive < 0 || counts[move->exclusive] - (local == move->exclusive) == 0);
+}
+
+// Does the move change how many processes are in the local state?
+static bool move_touches(const ProcessMove* move, int local) {
+    return local >= 0 && move->from != move->to && (move->from == local || move->to == local);
+}
+
+// Processes only interact through guards, so moves of two different
+// processes are dependent if one enters or leaves the other's guard state
+static bool moves_dependent(const ProcessMove* a, const ProcessMove* b) {
+    return move_touches(a, b->exclusive) || move_touches(b, a->exclusive);
+}
+
+// Can a move of the process change an observed proposition?
+static bool move_visible(const ProcessSystem* system, const ProcessMove* move, int process,
+                         const bool* observed, bool per_process) {
+    int prop = 0;
+    if (move->from == move->to) return false;
+    if (per_process) {
+        int base = process * system->num_locals;
+        if (observed[base + move->from] || observed[base + move->to]) return true;
+        prop = system->num_processes * system->num_locals;
+    }
+    for (int k = 0; k < system->num_counting_props; k++) {
+        if (observed[prop + k] && move_touches(move, system->counting_props[k].local)) return true;
+    }
+    return false;
+}
+
+// Ample set of a state for partial-order reduction: a process whose only move
+// from its local state is enabled (C0), independent of every move another
+// process can ever make (C1), invisible (C2), does not lead back to a state
+// expanded already (C3: states are expanded in discovery order, so every
+// cycle has such an edge, and its source is expanded fully) and is a single
+// transition (C4, for branching time). Returns the process, or -1 to expand
+// state s fully.
+static int find_ample_process(const ProcessSystem* system, int s, const int* locals, const int* counts,
+                              StateTable* table, const bool* observed, bool per_process) {
+    for (int i = 0; i < system->num_processes; i++) {
+        const ProcessMove* only = NULL;
+        int num_moves = 0;
+        for (int m = 0; m < system->num_moves; m++) {
+            if (system->moves[m].from == locals[i]) {
+                only = &system->moves[m];
+                num_moves++;
+            }
+        }
+        if (num_moves != 1 || !move_enabled(only, locals[i], counts) ||
+            move_visible(system, only, i, observed, per_process)) {
+            continue;
+        }
+
+        bool independent = true;
+        for (int m = 0; m < system->num_moves && independent; m++) {
+            independent = !moves_dependent(only, &system->moves[m]);
+        }
+        if (!independent) continue;
+
+        int next[MAX_PROCESSES];
+        memcpy(next, locals, sizeof(next));
+        next[i] = only->to;
+        int target = table_find(table, encode_locals(system, next));
+        if (target < 0 || target > s) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// Add the transition from state s taken by one move of process i, adding
+// the target state if it is new
+static bool add_process_transition(const ProcessSystem* system, ProcessModel* pm, StateTable* table,
+                                   int s, int i, const ProcessMove* move) {
+    int next[MAX_PROCESSES];
+    memcpy(next, pm->locals[s], sizeof(next));
+    next[i] = move->to;
+    canonicalize_process_state(system, next);
+
+    uint64_t key = encode_locals(system, next);
+    int target = table_find(table, key);
+    if (target < 0) {
+        if (pm->model->num_states >= MAX_STATES) {
+            fprintf(stderr, "Error: The %d-process system has more than %d states\n",
+                    system->num_processes, MAX_STATES);
+            return false;
+        }
+        target = add_state(pm->model);
+        memcpy(pm->locals[target], next, sizeof(next));
+        table_insert(table, key, target);
+    }
+
+    // Symmetric moves often lead to the same representative
+    for (int j = 0; j < pm->model->states[s].num_transitions; j++) {
+        if (pm->model->states[s].transitions[j] == target) return true;
+    }
+    return add_transition(pm->model, s, target);
+}
+
+// Explore the reachable part of the system from the state where every
+// process is in local state 0 (model state 0), breadth first, one state per
+// orbit of the declared symmetry. With `observed` (flags over the model's
+// propositions), only an ample subset of the interleavings is explored.
+static ProcessModel* explore_process_system(const ProcessSystem* system, const bool* observed) {
+    ProcessModel* pm = (ProcessModel*)malloc(sizeof(ProcessModel));
+    StateTable* table = (StateTable*)malloc(sizeof(StateTable));
+    if (pm == NULL || table == NULL || (pm->model = create_model()) == NULL) {
+        fprintf(stderr, "Error: Memory allocation failed for process model\n");
+        free(pm);
+        free(table);
+        return NULL;
+    }
+    memset(table, 0, sizeof(StateTable));
+    for (int i = 0; i < STATE_TABLE_SIZE; i++) {
+        table->state[i] = -1;
+    }
+
+    // Per-process propositions p<i><local> are only sound without symmetry
+    bool per_process = (system->num_symmetry_classes == 0);
+    int num_props = (per_process ? system->num_processes * system->num_locals : 0) +
+                    system->num_counting_props;
+    if (num_props > MAX_PROPS) {
+        fprintf(stderr, "Error: The %d-process system needs %d propositions, more than %d\n",
+                system->num_processes, num_props, MAX_PROPS);
+        free_process_model(pm);
+        free(table);
+        return NULL;
+    }
+    char name[32];
+    if (per_process) {
+        for (int i = 0; i < system->num_processes; i++) {
+            for (int l = 0; l < system->num_locals; l++) {
+                snprintf(name, sizeof(name), "p%d%s", i + 1, system->local_names[l]);
+                add_proposition(pm->model, name);
+            }
+        }
+    }
+    for (int k = 0; k < system->num_counting_props; k++) {
+        add_proposition(pm->model, system->counting_props[k].name);
+    }
+
+    pm->num_processes = system->num_processes;
+    pm->num_full_states = 0;
+    int start[MAX_PROCESSES] = {0};
+    add_state(pm->model);
+    memcpy(pm->locals[0], start, sizeof(start));
+    table_insert(table, encode_locals(system, start), 0);
+
+    bool ok = true;
+    for (int s = 0; s < pm->model->num_states && ok; s++) {
+        int counts[MAX_LOCAL_STATES] = {0};
+        for (int i = 0; i < system->num_processes; i++) {
+            counts[pm->locals[s][i]]++;
+        }
+        label_process_state(system, pm, s, per_process);
+        pm->num_full_states += orbit_size(system, pm->locals[s]);
+
+        int ample = (observed != NULL)
+            ? find_ample_process(system, s, pm->locals[s], counts, table, observed, per_process)
+            : -1;
+        for (int i = 0; i < system->num_processes && ok; i++) {
+            if (ample >= 0 && i != ample) continue;
+            for (int m = 0; m < system->num_moves && ok; m++) {
+                if (move_enabled(&system->moves[m], pm->locals[s][i], counts)) {
+                    ok = add_process_transition(system, pm, table, s, i, &system->moves[m]);
+                }
+            }
+        }
+    }
+
+    free(table);
+    if (!ok) {
+        free_process_model(pm);
+        return NULL;
+    }
+    return pm;
+}
+
+// Build the full interleaving of the system (up to the declared symmetry).
+// Returns NULL if the model limits are exceeded.
+ProcessModel* build_process_model(const ProcessSystem* system) {
+    return explore_process_system(system, NULL);
+}
+
+// Build the system with ample-set partial-order reduction: the interleavings
+// left out cannot be told apart by CTL formulas without EX/AX over the
+// observed propositions (a flag per model proposition, as numbered by
+// build_process_model). The initial state keeps its answers; other states are
+// only those the reduced exploration reaches. Not combined with symmetry.
+ProcessModel* build_process_model_reduced(const ProcessSystem* system, const bool* observed) {
+    if (system->num_symmetry_classes > 0) {
+        fprintf(stderr, "Error: Partial-order reduction is not supported together with symmetry\n");
+        return NULL;
+    }
+    return explore_process_system(system, observed);
+}
+
+void free_process_model(ProcessModel* pm) {
+    if (pm == NULL) return;
+    free_model(pm->model);
+    free(pm);
+}
+
+// Model state of a global state (canonicalized first), or -1 if unreachable
+int find_process_state(ProcessModel* pm, const ProcessSystem* system, const int* locals) {
+    int canonical[MAX_PROCESSES];
+    memcpy(canonical, locals, system->num_processes * sizeof(int));
+    canonicalize_process_state(system, canonical);
+    for (int s = 0; s < pm->model->num_states; s++) {
+        if (memcmp(pm->locals[s], canonical, system->num_processes * sizeof(int)) == 0) {
+            return s;
+        }
+    }
+    return -1;
+}
+
+// N processes competing for one critical section: n -> t -> c -> n, where
+// entering c requires that no other process is in c
+void init_mutex_system(ProcessSystem* system, int num_processes) {
+    init_process_system(system, num_processes);
+    int n = add_local_state(system, "n");
+    int t = add_local_state(system, "t");
+    int c = add_local_state(system, "c");
+    add_process_move(system, n, t, -1);
+    add_process_move(system, t, c, c);
+    add_process_move(system, c, n, -1);
+    add_counting_proposition(system, "some_t", t, 1);
+    add_counting_proposition(system, "some_c", c, 1);
+    add_counting_proposition(system, "two_c", c, 2);
+}
+
+// Print whether the initial state (model state 0) is in the formula's states
+static bool report_initial(const char* formula, const char* meaning, StateSet* result) {
+    bool holds = is_in_state_set(result, 0);
+    printf("  %-14s %-30s %s\n", formula, meaning, holds ? "holds" : "FAILS");
+    return holds;
+}
+
+// Check the mutex system's properties in its initial state: AG !two_c
+// (mutual exclusion), AG EF some_c and AG AF some_c (the critical section
+// stays reachable, and is entered again on every path). All are X-free over
+// some_c and two_c, so the answers also hold on a partial-order reduced
+// model observing those. Returns false if a property fails.
+bool check_mutex_properties(Model* model) {
+    int some_c = get_proposition_id(model, "some_c");
+    int two_c = get_proposition_id(model, "two_c");
+    if (some_c < 0 || two_c < 0) {
+        fprintf(stderr, "Error: The model has no some_c/two_c propositions\n");
+        return false;
+    }
+
+    // Each formula is evaluated on the bisimulation quotient with --bisim
+    Model* target = formula_model(model);
+    StateSet prop, not_two_c, inner, target_result, result;
+    bool all_hold = true;
+
+    eval_atomic_prop(&prop, target, two_c);
+    complement_state_set(&not_two_c, &prop, target->num_states);
+    eval_ag(&target_result, &not_two_c, target);
+    lift_formula_result(&result, &target_result, model);
+    all_hold &= report_initial("AG !two_c", "(mutual exclusion)", &result);
+
+    eval_atomic_prop(&prop, target, some_c);
+    eval_ef(&inner, &prop, target);
+    eval_ag(&target_result, &inner, target);
+    lift_formula_result(&result, &target_result, model);
+    all_hold &= report_initial("AG EF some_c", "(critical section reachable)", &result);
+
+    eval_af(&inner, &prop, target);
+    eval_ag(&target_result, &inner, target);
+    lift_formula_result(&result, &target_result, model);
+    all_hold &= report_initial("AG AF some_c", "(critical section recurs)", &result);
+
+    return all_hold;
+}
@@ -0,0 +1,192 @@
+// ctl_reach_index.c - Reachability index for repeated EF queries on one model
+//
+// The transition graph is condensed into its strongly connected components
+// (Tarjan). Every component gets a row holding the states that can reach it,
+// so [[EF P]] is the union of the rows of the components containing P states.
+// The index is built on the first EF query of a model that enabled it and is
+// kept until the model's graph changes or the model is freed.
+#include "ctl_common.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+
+struct ReachIndex {
+    int num_states;
+    int num_components;
+    int component[MAX_STATES];       // Component of each state
+    StateSet coreach[MAX_STATES];    // States that can reach each component
+};
+
+// Lazy builds may race when the sweep runs on a worker pool
+static pthread_mutex_t reach_index_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// Working state of Tarjan's algorithm
+typedef struct {
+    Model* model;
+    struct ReachIndex* index;
+    int next_order;
+    int order[MAX_STATES];           // Discovery order, -1 if unvisited
+    int low[MAX_STATES];
+    bool on_stack[MAX_STATES];
+    int stack[MAX_STATES];
+    int stack_top;
+} SccSearch;
+
+static void scc_visit(SccSearch* search, int state) {
+    State* current_state = &search->model->states[state];
+
+    search->order[state] = search->low[state] = search->next_order++;
+    search->stack[search->stack_top++] = state;
+    search->on_stack[state] = true;
+
+    for (int j = 0; j < current_state->num_transitions; j++) {
+        int successor_id = current_state->transitions[j];
+        if (search->order[successor_id] < 0) {
+            scc_visit(search, successor_id);
+            if (search->low[successor_id] < search->low[state]) {
+                search->low[state] = search->low[successor_id];
+            }
+        } else if (search->on_stack[successor_id] && search->order[successor_id] < search->low[state]) {
+            search->low[state] = search->order[successor_id];
+        }
+    }
+
+    // Root of a component: pop it. Components are numbered in reverse
+    // topological order, so every edge leaving a component points to a lower number.
+    if (search->low[state] == search->order[state]) {
+        int id = search->index->num_components++;
+        int member;
+        do {
+            member = search->stack[--search->stack_top];
+            search->on_stack[member] = false;
+            search->index->component[member] = id;
+        } while (member != state);
+    }
+}
+
+static struct ReachIndex* build_reach_index(Model* model) {
+    struct ReachIndex* index = (struct ReachIndex*)malloc(sizeof(struct ReachIndex));
+    SccSearch* search = (SccSearch*)malloc(sizeof(SccSearch));
+    if (index == NULL || search == NULL) {
+        fprintf(stderr, "Error: Memory allocation failed for reachability index\n");
+        free(index);
+        free(search);
+        return NULL;
+    }
+
+    index->num_states = model->num_states;
+    index->num_components = 0;
+    search->model = model;
+    search->index = index;
+    search->next_order = 0;
+    search->stack_top = 0;
+    for (int i = 0; i < model->num_states; i++) {
+        search->order[i] = -1;
+        search->on_stack[i] = false;
+    }
+    for (int i = 0; i < model->num_states; i++) {
+        if (search->order[i] < 0) {
+            scc_visit(search, i);
+        }
+    }
+    free(search);
+
+    // A component is reached from its own states and from everything that
+    // reaches a predecessor component; predecessors have higher numbers, so
+    // filling the rows from the highest number down sees them complete
+    for (int c = 0; c < index->num_components; c++) {
+        init_state_set(&index->coreach[c], model->num_states);
+    }
+    for (int i = 0; i < model->num_states; i++) {
+        add_to_state_set(&index->coreach[index->component[i]], i);
+    }
+    for (int c = index->num_components - 1; c >= 0; c--) {
+        for (int i = 0; i < model->num_states; i++) {
+            State* current_state = &model->states[i];
+            int from = index->component[i];
+            if (from == c) continue;
+            for (int j = 0; j < current_state->num_transitions; j++) {
+                if (index->component[current_state->transitions[j]] == c) {
+                    for (int s = 0; s < model->num_states; s++) {
+                        if (index->coreach[from].members[s]) {
+                            add_to_state_set(&index->coreach[c], s);
+                        }
+                    }
+                    break;
+                }
+            }
+        }
+    }
+
+    return index;
+}
+
+// Answer EF queries of this model from the index (built lazily on first use)
+void enable_reach_index(Model* model, bool enabled) {
+    model->use_reach_index = enabled;
+}
+
+// Drop the index after a change to the transition graph
+void invalidate_reach_index(Model* model) {
+    free(model->reach_index);
+    model->reach_index = NULL;
+}
+
+// [[EF P]] as the union of the rows of all components holding a P state.
+// Returns false (result untouched) if the model does not use the index.
+bool reach_index_ef(StateSet* result, StateSet* prop_p, Model* model) {
+    if (!model->use_reach_index) {
+        return false;
+    }
+
+    pthread_mutex_lock(&reach_index_lock);
+    if (model->reach_index == NULL) {
+        model->reach_index = build_reach_index(model);
+    }
+    struct ReachIndex* index = model->reach_index;
+    pthread_mutex_unlock(&reach_index_lock);
+
+    if (index == NULL) {
+        return false;
+    }
+
+    bool row_used[MAX_STATES] = {false};
+    init_state_set(result, model->num_states);
+    for (int i = 0; i < model->num_states; i++) {
+        int c = index->component[i];
+        if (!prop_p->members[i] || row_used[c]) continue;
+        row_used[c] = true;
+        for (int s = 0; s < model->num_states; s++) {
+            if (index->coreach[c].members[s]) {
+                add_to_state_set(result, s);
+            }
+        }
+    }
+    return true;
+}
+
+/* The operators with EF (and AG = ¬EF ¬) answered from the index. The index
+   is switched on for the one call only, so other engines that run on the
+   same model keep their own kernels. */
+
+static void indexed_ef(StateSet* result, StateSet* prop_p, Model* model) {
+    bool enabled = model->use_reach_index;
+    enable_reach_index(model, true);
+    eval_ef(result, prop_p, model);
+    enable_reach_index(model, enabled);
+}
+
+static void indexed_ag(StateSet* result, StateSet* prop_p, Model* model) {
+    bool enabled = model->use_reach_index;
+    enable_reach_index(model, true);
+    eval_ag(result, prop_p, model);
+    enable_reach_index(model, enabled);
+}
+
+const CtlEngine reach_index_engine = {
+    "reach_index",
+    existential_successor, universal_successor,
+    indexed_ef, eval_eg, eval_af, indexed_ag,
+    eval_eu, eval_au,
+    false
+};
@@ -0,0 +1,218 @@
+// ctl_report.c - Streaming CSV and Markdown report writer for the equation checks
+#include "ctl_common.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/stat.h>
+
+#define NUM_EQUATIONS 12
+#define REPORT_PATH_LEN 512
+
+// Equation text and explanation, matching the headers printed by the verifier
+static const char* equation_formulas[NUM_EQUATIONS] = {
+    "[[p]] = {s ∈ W : v(s)(p) = true}",
+    "[[¬P]] = W \\ [[P]]",
+    "[[P ∧ Q]] = [[P]] ∩ [[Q]]",
+    "[[P ∨ Q]] = [[P]] ∪ [[Q]]",
+    "[[EX P]] = τEX([[P]])",
+    "[[AX P]] = τAX([[P]])",
+    "[[EF P]] = μZ.([[P]] ∪ τEX(Z))",
+    "[[EG P]] = νZ.([[P]] ∩ τEX(Z))",
+    "[[AF P]] = μZ.([[P]] ∪ τAX(Z))",
+    "[[AG P]] = νZ.([[P]] ∩ τAX(Z))",
+    "[[EP UQ]] = μZ.([[Q]] ∪ ([[P]] ∩ τEX(Z)))",
+    "[[AP UQ]] = μZ.([[Q]] ∪ ([[P]] ∩ τAX(Z)))"
+};
+
+static const char* equation_explanations[NUM_EQUATIONS] = {
+    "This equation defines the semantics of atomic propositions in CTL.",
+    "This equation defines the semantics of negation in CTL.",
+    "This equation defines the semantics of conjunction in CTL.",
+    "This equation defines the semantics of disjunction in CTL.",
+    "This equation defines the semantics of the existential next operator in CTL.",
+    "This equation defines the semantics of the universal next operator in CTL.",
+    "This equation defines the semantics of the existential finally operator using a least fixpoint.",
+    "This equation defines the semantics of the existential globally operator using a greatest fixpoint.",
+    "This equation defines the semantics of the always finally operator using a least fixpoint.",
+    "This equation defines the semantics of the always globally operator using a greatest fixpoint.",
+    "This equation defines the semantics of the existential until operator using a least fixpoint.",
+    "This equation defines the semantics of the universal until operator using a least fixpoint."
+};
+
+// Open report state: one CSV and one Markdown stream per equation
+static Model* report_model = NULL;
+static char report_dir[REPORT_PATH_LEN];
+static FILE* csv_files[NUM_EQUATIONS];
+static FILE* md_files[NUM_EQUATIONS];
+
+// Create a directory, accepting one that already exists
+static bool make_directory(const char* path) {
+    if (mkdir(path, 0755) != 0 && errno != EEXIST) {
+        fprintf(stderr, "Error: Could not create directory %s\n", path);
+        return false;
+    }
+    return true;
+}
+
+// Write a state set in the same {a, b, c} form used by print_state_set
+static void write_state_set(FILE* file, const StateSet* set) {
+    fprintf(file, "{");
+    bool first = true;
+    for (int i = 0; i < report_model->num_states; i++) {
+        if (set->members[i]) {
+            if (!first) {
+                fprintf(file, ", ");
+            }
+            fprintf(file, "%d", i);
+            first = false;
+        }
+    }
+    fprintf(file, "}");
+}
+
+// Write the Markdown header of one equation report
+static void write_markdown_header(FILE* file, int equation) {
+    fprintf(file, "# Equation %d Verification Results\n\n", equation);
+    fprintf(file, "## Equation:\n");
+    fprintf(file, "%s\n\n", equation_formulas[equation - 1]);
+    fprintf(file, "%s\n\n", equation_explanations[equation - 1]);
+    fprintf(file, "## Results:\n\n");
+    fprintf(file, "| P | Q | Computed | Manually Computed | Holds |\n");
+    fprintf(file, "|:---|:---|:---------|:-----------------|:------|\n");
+}
+
+// Open the per-equation CSV and Markdown files under output_dir
+bool report_open(const char* output_dir, Model* model) {
+    char path[REPORT_PATH_LEN + 32];
+
+    snprintf(report_dir, sizeof(report_dir), "%s", output_dir);
+    report_model = model;
+
+    snprintf(path, sizeof(path), "%s/csv", report_dir);
+    if (!make_directory(report_dir) || !make_directory(path)) {
+        return false;
+    }
+    snprintf(path, sizeof(path), "%s/markdown", report_dir);
+    if (!make_directory(path)) {
+        return false;
+    }
+
+    for (int n = 1; n <= NUM_EQUATIONS; n++) {
+        snprintf(path, sizeof(path), "%s/csv/Equation%d_clean.csv", report_dir, n);
+        csv_files[n - 1] = fopen(path, "w");
+        snprintf(path, sizeof(path), "%s/markdown/Equation%d.md", report_dir, n);
+        md_files[n - 1] = fopen(path, "w");
+
+        if (csv_files[n - 1] == NULL || md_files[n - 1] == NULL) {
+            fprintf(stderr, "Error: Could not open report files for equation %d in %s\n", n, report_dir);
+            report_close();
+            return false;
+        }
+
+        fprintf(csv_files[n - 1], "P,Q,computed,manually computed,holds\n");
+        write_markdown_header(md_files[n - 1], n);
+    }
+
+    return true;
+}
+
+// Results of the current thread go to this slot instead of the files when set
+static _Thread_local EquationResult* capture_slot = NULL;
+
+// Divert the results reported on this thread into slot (NULL writes them again)
+void report_capture(EquationResult* slot) {
+    capture_slot = slot;
+}
+
+// Record one verification result (written, or captured for a later in-order write)
+void report_result(int equation, int prop_p, int prop_q, StateSet* computed, StateSet* manual, bool holds) {
+    EquationResult local;
+    EquationResult* result = capture_slot != NULL ? capture_slot : &local;
+
+    result->equation = equation;
+    result->prop_p = prop_p;
+    result->prop_q = prop_q;
+    copy_state_set(&result->computed, computed);
+    copy_state_set(&result->manual, manual);
+    result->holds = holds;
+
+    if (capture_slot == NULL) {
+        report_write(result);
+    }
+}
+
+// Append one verification result to its equation's CSV and Markdown tables
+void report_write(const EquationResult* result) {
+    if (report_model == NULL || result->equation < 1 || result->equation > NUM_EQUATIONS) {
+        return;
+    }
+
+    const char* p_name = get_prop_name(report_model, result->prop_p);
+    const char* q_name = result->prop_q >= 0 ? get_prop_name(report_model, result->prop_q) : "";
+    const char* verdict = result->holds ? "YES" : "NO";
+
+    // Sets contain commas, so they are quoted in the CSV
+    FILE* csv = csv_files[result->equation - 1];
+    fprintf(csv, "%s,%s,\"", p_name, q_name);
+    write_state_set(csv, &result->computed);
+    fprintf(csv, "\",\"");
+    write_state_set(csv, &result->manual);
+    fprintf(csv, "\",%s\n", verdict);
+
+    FILE* md = md_files[result->equation - 1];
+    fprintf(md, "| %s | %s | `", p_name, q_name);
+    write_state_set(md, &result->computed);
+    fprintf(md, "` | `");
+    write_state_set(md, &result->manual);
+    fprintf(md, "` | %s |\n", verdict);
+}
+
+// Close all report files and concatenate the Markdown reports into summary.md
+void report_close(void) {
+    char path[REPORT_PATH_LEN + 32];
+    char buffer[4096];
+    FILE* summary = NULL;
+
+    if (report_model == NULL) {
+        return;
+    }
+
+    snprintf(path, sizeof(path), "%s/markdown/summary.md", report_dir);
+    summary = fopen(path, "w");
+    if (summary == NULL) {
+        fprintf(stderr, "Error: Could not open file %s for writing\n", path);
+    }
+
+    for (int n = 1; n <= NUM_EQUATIONS; n++) {
+        if (csv_files[n - 1] != NULL) {
+            fclose(csv_files[n - 1]);
+            csv_files[n - 1] = NULL;
+        }
+        if (md_files[n - 1] == NULL) {
+            continue;
+        }
+        fprintf(md_files[n - 1], "\n---\n");
+        fclose(md_files[n - 1]);
+        md_files[n - 1] = NULL;
+
+        if (summary == NULL) {
+            continue;
+        }
+        snprintf(path, sizeof(path), "%s/markdown/Equation%d.md", report_dir, n);
+        FILE* md = fopen(path, "r");
+        if (md == NULL) {
+            continue;
+        }
+        size_t bytes;
+        while ((bytes = fread(buffer, 1, sizeof(buffer), md)) > 0) {
+            fwrite(buffer, 1, bytes, summary);
+        }
+        fclose(md);
+    }
+
+    if (summary != NULL) {
+        fclose(summary);
+    }
+    report_model = NULL;
+}
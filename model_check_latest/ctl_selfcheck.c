@@ -0,0 +1,636 @@
+// ctl_selfcheck.c - Differential fuzzing of the CTL engines on random models
+//
+// Random Kripke structures and random CTL formulas are evaluated by every
+// registered engine and by an independent reference evaluator that iterates
+// the fixpoint equations of Theorem 3 directly. Any disagreement is shrunk to
+// a minimal model and formula before it is reported.
+//
+// Most models are small, which keeps counterexamples readable; the rest range
+// up to MAX_STATES states, so that the 2- and 4-word small-model kernels run
+// too. Some models have deadlock states (no successors), where the engines
+// follow maximal-path semantics: a deadlock state has no next state, so EX
+// and AX are false there, and a path that ends in it satisfies G P if P
+// held all along and F P only if P was reached.
+//
+// Each iteration also builds a random process system with and without
+// ample-set partial-order reduction and compares the initial-state answers
+// of a random formula without EX/AX over the observed propositions, which
+// the reduction must preserve.
+#include "ctl_common.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_FORMULA_NODES 64
+#define SELFCHECK_MAX_STATES 12        // Bound of the small models
+#define SELFCHECK_LARGE_PERCENT 25     // Models drawn from SELFCHECK_MAX_STATES + 1 .. MAX_STATES
+#define SELFCHECK_DEADLOCK_PERCENT 30  // Models with deadlock states
+#define SELFCHECK_MAX_PROPS 3
+#define SELFCHECK_MAX_DEPTH 4
+#define SELFCHECK_MAX_PROCESSES 3      // Process systems of the partial-order check
+#define SELFCHECK_MAX_LOCALS 4
+#define SELFCHECK_EXTRA_MOVES 3        // Random moves besides the cycle through the local states
+#define SELFCHECK_MAX_COUNTING 3
+
+// Operators of the random formulas
+typedef enum {
+    F_PROP, F_NOT, F_AND, F_OR,
+    F_EX, F_AX, F_EF, F_AF, F_EG, F_AG, F_EU, F_AU
+} FormulaOp;
+
+// A formula node; children are indices into the owning formula
+typedef struct {
+    FormulaOp op;
+    int prop;
+    int left;
+    int right;
+} FormulaNode;
+
+typedef struct {
+    FormulaNode nodes[MAX_FORMULA_NODES];
+    int num_nodes;
+    int root;
+} Formula;
+
+// Plain description of a test model, easy to mutate while shrinking
+typedef struct {
+    int num_states;
+    int num_props;
+    bool labels[MAX_STATES][MAX_PROPS];
+    int num_succ[MAX_STATES];
+    int succ[MAX_STATES][MAX_TRANSITIONS];
+} TestModel;
+
+/* Engines under test */
+
+// The operators in ctl_operators.c
+static const CtlEngine operators_engine = {
+    "ctl_operators",
+    existential_successor, universal_successor,
+    eval_ef, eval_eg, eval_af, eval_ag,
+    eval_eu, eval_au,
+    false
+};
+
+// Every engine that is cross-validated against the reference
+static const CtlEngine* selfcheck_engines[] = {
+    &operators_engine,
+    &small_kernels_engine,
+    &reach_index_engine,
+    &bisim_engine
+};
+
+#define NUM_ENGINES ((int)(sizeof(selfcheck_engines) / sizeof(selfcheck_engines[0])))
+
+/* Random generation */
+
+// xorshift32, so a seed reproduces a run on every platform
+static unsigned int next_random(unsigned int* state) {
+    unsigned int x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+static int random_below(unsigned int* state, int bound) {
+    return (int)(next_random(state) % (unsigned int)bound);
+}
+
+// Random model: mostly small and total (every state has a successor, as in a
+// Kripke structure), some large, and some with about one deadlock state in five
+static void random_test_model(TestModel* tm, unsigned int* rng) {
+    memset(tm, 0, sizeof(*tm));
+    if (random_below(rng, 100) < SELFCHECK_LARGE_PERCENT) {
+        tm->num_states = SELFCHECK_MAX_STATES + 1 + random_below(rng, MAX_STATES - SELFCHECK_MAX_STATES);
+    } else {
+        tm->num_states = 1 + random_below(rng, SELFCHECK_MAX_STATES);
+    }
+    tm->num_props = 1 + random_below(rng, SELFCHECK_MAX_PROPS);
+    bool deadlocks = random_below(rng, 100) < SELFCHECK_DEADLOCK_PERCENT;
+
+    for (int s = 0; s < tm->num_states; s++) {
+        for (int p = 0; p < tm->num_props; p++) {
+            tm->labels[s][p] = random_below(rng, 2) == 1;
+        }
+        if (deadlocks && random_below(rng, 5) == 0) {
+            continue;
+        }
+        tm->num_succ[s] = 1 + random_below(rng, 3);
+        for (int j = 0; j < tm->num_succ[s]; j++) {
+            tm->succ[s][j] = random_below(rng, tm->num_states);
+        }
+    }
+}
+
+static int add_node(Formula* f, FormulaOp op, int prop, int left, int right) {
+    FormulaNode* node = &f->nodes[f->num_nodes];
+    node->op = op;
+    node->prop = prop;
+    node->left = left;
+    node->right = right;
+    return f->num_nodes++;
+}
+
+static bool is_binary(FormulaOp op) {
+    return op == F_AND || op == F_OR || op == F_EU || op == F_AU;
+}
+
+// Random formula of at most the given depth over num_props propositions
+static int random_formula(Formula* f, int depth, int num_props, unsigned int* rng) {
+    // Leave room for the two children of a binary node
+    if (depth == 0 || f->num_nodes + 3 >= MAX_FORMULA_NODES || random_below(rng, 4) == 0) {
+        return add_node(f, F_PROP, random_below(rng, num_props), -1, -1);
+    }
+
+    FormulaOp op = (FormulaOp)(1 + random_below(rng, F_AU));
+    int left = random_formula(f, depth - 1, num_props, rng);
+    int right = is_binary(op) ? random_formula(f, depth - 1, num_props, rng) : -1;
+    return add_node(f, op, 0, left, right);
+}
+
+/* Formula printing (in the syntax of the ver1 formula parser) */
+
+static void print_formula_node(FILE* file, const Formula* f, int index) {
+    static const char* names[] = {
+        "", "!", "&", "|", "EX", "AX", "EF", "AF", "EG", "AG", "EU", "AU"
+    };
+    const FormulaNode* node = &f->nodes[index];
+
+    switch (node->op) {
+        case F_PROP:
+            fprintf(file, "p%d", node->prop);
+            break;
+        case F_AND:
+        case F_OR:
+            fprintf(file, "(");
+            print_formula_node(file, f, node->left);
+            fprintf(file, " %s ", names[node->op]);
+            print_formula_node(file, f, node->right);
+            fprintf(file, ")");
+            break;
+        case F_EU:
+        case F_AU:
+            fprintf(file, "%s(", names[node->op]);
+            print_formula_node(file, f, node->left);
+            fprintf(file, ", ");
+            print_formula_node(file, f, node->right);
+            fprintf(file, ")");
+            break;
+        default:
+            fprintf(file, "%s ", names[node->op]);
+            print_formula_node(file, f, node->left);
+            break;
+    }
+}
+
+static int formula_size(const Formula* f, int index) {
+    const FormulaNode* node = &f->nodes[index];
+    int size = 1;
+    if (node->left >= 0) size += formula_size(f, node->left);
+    if (node->right >= 0) size += formula_size(f, node->right);
+    return size;
+}
+
+/* Model construction */
+
+static Model* build_model(const TestModel* tm) {
+    char name[16];
+    Model* model = create_model();
+    if (model == NULL) return NULL;
+
+    for (int s = 0; s < tm->num_states; s++) {
+        add_state(model);
+    }
+    for (int p = 0; p < tm->num_props; p++) {
+        snprintf(name, sizeof(name), "p%d", p);
+        add_proposition(model, name);
+    }
+    for (int s = 0; s < tm->num_states; s++) {
+        for (int p = 0; p < tm->num_props; p++) {
+            if (tm->labels[s][p]) {
+                set_proposition_true(model, s, p);
+            }
+        }
+        for (int j = 0; j < tm->num_succ[s]; j++) {
+            add_transition(model, s, tm->succ[s][j]);
+        }
+    }
+
+    // The operators engine stands for the StateSet implementations
+    enable_small_kernels(model, false);
+    return model;
+}
+
+/* Evaluation */
+
+// Evaluate a formula with an engine; boolean connectives use the state set operations
+static void engine_eval(StateSet* result, const Formula* f, int index, Model* model, const CtlEngine* engine) {
+    const FormulaNode* node = &f->nodes[index];
+    StateSet left, right;
+
+    if (node->op == F_PROP) {
+        eval_atomic_prop(result, model, node->prop);
+        return;
+    }
+
+    engine_eval(&left, f, node->left, model, engine);
+    if (is_binary(node->op)) {
+        engine_eval(&right, f, node->right, model, engine);
+    }
+
+    init_state_set(result, model->num_states);
+    switch (node->op) {
+        case F_NOT: complement_state_set(result, &left, model->num_states); break;
+        case F_AND: intersect_state_sets(result, &left, &right); break;
+        case F_OR:  union_state_sets(result, &left, &right); break;
+        case F_EX:  engine->ex(result, &left, model); break;
+        case F_AX:  engine->ax(result, &left, model); break;
+        case F_EF:  engine->ef(result, &left, model); break;
+        case F_AF:  engine->af(result, &left, model); break;
+        case F_EG:  engine->eg(result, &left, model); break;
+        case F_AG:  engine->ag(result, &left, model); break;
+        case F_EU:  engine->eu(result, &left, &right, model); break;
+        case F_AU:  engine->au(result, &left, &right, model); break;
+        default: break;
+    }
+}
+
+// τEX / τAX of the reference evaluator, straight from the definitions. At a
+// deadlock state the step is `deadlock`: false for EX, AX, AF and AU (no
+// next state, no path reaching P), true for EG and AG (the path that ends
+// there stays in P).
+static void reference_tau(bool* result, const bool* z, const TestModel* tm, bool universal, bool deadlock) {
+    for (int s = 0; s < tm->num_states; s++) {
+        bool any = false, all = true;
+        for (int j = 0; j < tm->num_succ[s]; j++) {
+            if (z[tm->succ[s][j]]) any = true;
+            else all = false;
+        }
+        result[s] = (tm->num_succ[s] == 0) ? deadlock : universal ? all : any;
+    }
+}
+
+// Iterate Z := outer ∪/∩ (inner ∩ τ(Z)) from ∅ (least) or W (greatest) until stable.
+// inner == NULL stands for W. Greatest fixpoints take deadlock states as
+// staying in Z, least ones as never reaching outer.
+static void reference_fixpoint(bool* z, const bool* outer, const bool* inner, const TestModel* tm,
+                               bool universal, bool greatest) {
+    bool tau[MAX_STATES];
+    bool changed = true;
+
+    for (int s = 0; s < tm->num_states; s++) {
+        z[s] = greatest;
+    }
+    while (changed) {
+        changed = false;
+        reference_tau(tau, z, tm, universal, greatest);
+        for (int s = 0; s < tm->num_states; s++) {
+            bool step = (inner == NULL || inner[s]) && tau[s];
+            bool next = greatest ? (outer[s] && step) : (outer[s] || step);
+            if (next != z[s]) {
+                z[s] = next;
+                changed = true;
+            }
+        }
+    }
+}
+
+// Independent reference semantics of Theorem 3 (no code shared with the engines)
+static void reference_eval(bool* result, const Formula* f, int index, const TestModel* tm) {
+    const FormulaNode* node = &f->nodes[index];
+    bool left[MAX_STATES], right[MAX_STATES];
+
+    if (node->op == F_PROP) {
+        for (int s = 0; s < tm->num_states; s++) {
+            result[s] = tm->labels[s][node->prop];
+        }
+        return;
+    }
+
+    reference_eval(left, f, node->left, tm);
+    if (is_binary(node->op)) {
+        reference_eval(right, f, node->right, tm);
+    }
+
+    switch (node->op) {
+        case F_NOT:
+            for (int s = 0; s < tm->num_states; s++) result[s] = !left[s];
+            break;
+        case F_AND:
+            for (int s = 0; s < tm->num_states; s++) result[s] = left[s] && right[s];
+            break;
+        case F_OR:
+            for (int s = 0; s < tm->num_states; s++) result[s] = left[s] || right[s];
+            break;
+        case F_EX: reference_tau(result, left, tm, false, false); break;
+        case F_AX: reference_tau(result, left, tm, true, false); break;
+        case F_EF: reference_fixpoint(result, left, NULL, tm, false, false); break;   // μZ.(P ∪ τEX(Z))
+        case F_EG: reference_fixpoint(result, left, NULL, tm, false, true); break;    // νZ.(P ∩ τEX(Z))
+        case F_AF: reference_fixpoint(result, left, NULL, tm, true, false); break;    // μZ.(P ∪ τAX(Z))
+        case F_AG: reference_fixpoint(result, left, NULL, tm, true, true); break;     // νZ.(P ∩ τAX(Z))
+        case F_EU: reference_fixpoint(result, right, left, tm, false, false); break;  // μZ.(Q ∪ (P ∩ τEX(Z)))
+        case F_AU: reference_fixpoint(result, right, left, tm, true, false); break;   // μZ.(Q ∪ (P ∩ τAX(Z)))
+        default: break;
+    }
+}
+
+// Evaluate a whole formula with an engine, on the bisimulation quotient if the
+// engine asks for it (the path --bisim takes)
+static void engine_eval_formula(StateSet* result, const Formula* f, Model* model, const CtlEngine* engine) {
+    StateSet target_result;
+
+    enable_bisimulation(model, engine->on_quotient);
+    engine_eval(&target_result, f, f->root, formula_model(model), engine);
+    lift_formula_result(result, &target_result, model);
+}
+
+// Evaluate with engine and reference; true if they disagree on some state
+static bool engine_mismatch(const TestModel* tm, const Formula* f, const CtlEngine* engine,
+                            StateSet* got, bool* expected) {
+    Model* model = build_model(tm);
+    if (model == NULL) return false;
+
+    engine_eval_formula(got, f, model, engine);
+    reference_eval(expected, f, f->root, tm);
+    free_model(model);
+
+    for (int s = 0; s < tm->num_states; s++) {
+        if (got->members[s] != expected[s]) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/* Shrinking */
+
+static bool still_fails(const TestModel* tm, const Formula* f, const CtlEngine* engine) {
+    StateSet got;
+    bool expected[MAX_STATES];
+    return engine_mismatch(tm, f, engine, &got, expected);
+}
+
+// Replace subformulas by one of their children or by a proposition while the mismatch persists
+static bool shrink_formula(const TestModel* tm, Formula* f, const CtlEngine* engine) {
+    bool progress = false;
+
+    for (int i = 0; i < f->num_nodes; i++) {
+        FormulaNode original = f->nodes[i];
+        if (original.op == F_PROP) continue;
+
+        int children[2] = {original.left, original.right};
+        bool replaced = false;
+        for (int c = 0; c < 2 && !replaced; c++) {
+            if (children[c] < 0) continue;
+            f->nodes[i] = f->nodes[children[c]];
+            replaced = still_fails(tm, f, engine);
+            if (!replaced) {
+                f->nodes[i] = original;
+            }
+        }
+
+        for (int p = 0; p < tm->num_props && !replaced; p++) {
+            f->nodes[i].op = F_PROP;
+            f->nodes[i].prop = p;
+            f->nodes[i].left = f->nodes[i].right = -1;
+            replaced = still_fails(tm, f, engine);
+            if (!replaced) {
+                f->nodes[i] = original;
+            }
+        }
+        progress = progress || replaced;
+    }
+
+    return progress;
+}
+
+// Remove state victim and the edges into it
+static void remove_state(TestModel* dst, const TestModel* src, int victim) {
+    memset(dst, 0, sizeof(*dst));
+    dst->num_states = src->num_states - 1;
+    dst->num_props = src->num_props;
+
+    for (int s = 0, d = 0; s < src->num_states; s++) {
+        if (s == victim) continue;
+        memcpy(dst->labels[d], src->labels[s], sizeof(src->labels[s]));
+        for (int j = 0; j < src->num_succ[s]; j++) {
+            int t = src->succ[s][j];
+            if (t == victim) continue;
+            dst->succ[d][dst->num_succ[d]++] = t > victim ? t - 1 : t;
+        }
+        d++;
+    }
+}
+
+// Drop states, transitions and labels while the mismatch persists
+static bool shrink_model(TestModel* tm, const Formula* f, const CtlEngine* engine) {
+    TestModel candidate;
+    bool progress = false;
+
+    for (int s = tm->num_states - 1; s >= 0 && tm->num_states > 1; s--) {
+        remove_state(&candidate, tm, s);
+        if (still_fails(&candidate, f, engine)) {
+            *tm = candidate;
+            progress = true;
+        }
+    }
+
+    for (int s = 0; s < tm->num_states; s++) {
+        for (int j = tm->num_succ[s] - 1; j >= 0; j--) {
+            candidate = *tm;
+            candidate.succ[s][j] = candidate.succ[s][--candidate.num_succ[s]];
+            if (still_fails(&candidate, f, engine)) {
+                *tm = candidate;
+                progress = true;
+            }
+        }
+        for (int p = 0; p < tm->num_props; p++) {
+            if (!tm->labels[s][p]) continue;
+            candidate = *tm;
+            candidate.labels[s][p] = false;
+            if (still_fails(&candidate, f, engine)) {
+                *tm = candidate;
+                progress = true;
+            }
+        }
+    }
+
+    return progress;
+}
+
+static void print_counterexample(const TestModel* tm, const Formula* f, const CtlEngine* engine) {
+    StateSet got;
+    bool expected[MAX_STATES];
+    engine_mismatch(tm, f, engine, &got, expected);
+
+    printf("  Minimal counterexample for engine %s:\n", engine->name);
+    printf("  Formula: ");
+    print_formula_node(stdout, f, f->root);
+    printf("\n");
+    for (int s = 0; s < tm->num_states; s++) {
+        printf("    State %d: {", s);
+        bool first = true;
+        for (int p = 0; p < tm->num_props; p++) {
+            if (tm->labels[s][p]) {
+                printf("%sp%d", first ? "" : ", ", p);
+                first = false;
+            }
+        }
+        printf("} -> {");
+        for (int j = 0; j < tm->num_succ[s]; j++) {
+            printf("%s%d", j > 0 ? ", " : "", tm->succ[s][j]);
+        }
+        printf("}  engine: %s, reference: %s\n",
+               got.members[s] ? "true" : "false", expected[s] ? "true" : "false");
+    }
+}
+
+/* Partial-order reduction */
+
+// Random template: a cycle through the local states (local states with a
+// single move are the ones the reduction can pick) and a few random moves,
+// some guarded by a local state no other process may be in, and counting
+// propositions
+static void random_process_system(ProcessSystem* system, unsigned int* rng) {
+    char name[16];
+    init_process_system(system, 2 + random_below(rng, SELFCHECK_MAX_PROCESSES - 1));
+    int num_locals = 2 + random_below(rng, SELFCHECK_MAX_LOCALS - 1);
+    for (int l = 0; l < num_locals; l++) {
+        snprintf(name, sizeof(name), "l%d", l);
+        add_local_state(system, name);
+    }
+    for (int l = 0; l < num_locals; l++) {
+        int exclusive = random_below(rng, 3) == 0 ? random_below(rng, num_locals) : -1;
+        add_process_move(system, l, (l + 1) % num_locals, exclusive);
+    }
+    int num_extra = random_below(rng, SELFCHECK_EXTRA_MOVES + 1);
+    for (int m = 0; m < num_extra; m++) {
+        int exclusive = random_below(rng, 3) == 0 ? random_below(rng, num_locals) : -1;
+        add_process_move(system, random_below(rng, num_locals), random_below(rng, num_locals), exclusive);
+    }
+    int num_counting = random_below(rng, SELFCHECK_MAX_COUNTING + 1);
+    for (int k = 0; k < num_counting; k++) {
+        snprintf(name, sizeof(name), "count%d", k);
+        add_counting_proposition(system, name, random_below(rng, num_locals),
+                                 1 + random_below(rng, system->num_processes));
+    }
+}
+
+static void print_process_system(const ProcessSystem* system) {
+    printf("  %d processes, local states 0..%d, moves:", system->num_processes, system->num_locals - 1);
+    for (int m = 0; m < system->num_moves; m++) {
+        printf(" %d->%d", system->moves[m].from, system->moves[m].to);
+        if (system->moves[m].exclusive >= 0) printf(" (none in %d)", system->moves[m].exclusive);
+    }
+    printf("\n");
+    for (int k = 0; k < system->num_counting_props; k++) {
+        printf("  %s: at least %d in %d\n", system->counting_props[k].name,
+               system->counting_props[k].at_least, system->counting_props[k].local);
+    }
+}
+
+// Build a random process system fully and with partial-order reduction, and
+// compare the initial-state answers of a random X-free formula over the
+// observed propositions. Returns false on a mismatch.
+static bool check_partial_order(int iteration, unsigned int* rng) {
+    ProcessSystem system;
+    bool observed[MAX_PROPS] = {false};
+    int observed_props[MAX_PROPS];
+    int num_observed = 0;
+    Formula f;
+
+    random_process_system(&system, rng);
+    ProcessModel* full = build_process_model(&system);
+    if (full == NULL) return true;
+    for (int p = 0; p < full->model->num_props; p++) {
+        if (random_below(rng, 4) == 0) {
+            observed[p] = true;
+            observed_props[num_observed++] = p;
+        }
+    }
+    if (num_observed == 0) {
+        observed[0] = true;
+        observed_props[num_observed++] = 0;
+    }
+    ProcessModel* reduced = build_process_model_reduced(&system, observed);
+    if (reduced == NULL) {
+        free_process_model(full);
+        return true;
+    }
+
+    // EX/AX can count the interleavings the reduction leaves out
+    f.num_nodes = 0;
+    f.root = random_formula(&f, 1 + random_below(rng, SELFCHECK_MAX_DEPTH), num_observed, rng);
+    for (int i = 0; i < f.num_nodes; i++) {
+        FormulaNode* node = &f.nodes[i];
+        if (node->op == F_PROP) node->prop = observed_props[node->prop];
+        else if (node->op == F_EX) node->op = F_EF;
+        else if (node->op == F_AX) node->op = F_AF;
+    }
+
+    StateSet full_result, reduced_result;
+    engine_eval(&full_result, &f, f.root, full->model, &operators_engine);
+    engine_eval(&reduced_result, &f, f.root, reduced->model, &operators_engine);
+    bool full_holds = is_in_state_set(&full_result, 0);
+    bool reduced_holds = is_in_state_set(&reduced_result, 0);
+    if (full_holds != reduced_holds) {
+        printf("[ERROR] Iteration %d: partial-order reduction changes an initial-state answer\n", iteration);
+        print_process_system(&system);
+        printf("  Formula: ");
+        print_formula_node(stdout, &f, f.root);
+        printf("\n  Observed:");
+        for (int k = 0; k < num_observed; k++) {
+            printf(" p%d = %s", observed_props[k], full->model->prop_names[observed_props[k]]);
+        }
+        printf("\n  Full model (%d states): %s, reduced model (%d states): %s\n",
+               full->model->num_states, full_holds ? "true" : "false",
+               reduced->model->num_states, reduced_holds ? "true" : "false");
+    }
+
+    free_process_model(full);
+    free_process_model(reduced);
+    return full_holds == reduced_holds;
+}
+
+// Run the differential test; returns the number of mismatches found
+int run_selfcheck(int iterations, unsigned int seed) {
+    unsigned int rng = seed != 0 ? seed : 1;
+    int failures = 0;
+
+    printf("===== CTL Self-Check: differential testing of %d engine(s) =====\n", NUM_ENGINES);
+    printf("Iterations: %d, seed: %u\n", iterations, seed);
+
+    for (int it = 0; it < iterations; it++) {
+        TestModel tm;
+        Formula f;
+
+        random_test_model(&tm, &rng);
+        f.num_nodes = 0;
+        f.root = random_formula(&f, 1 + random_below(&rng, SELFCHECK_MAX_DEPTH), tm.num_props, &rng);
+
+        for (int e = 0; e < NUM_ENGINES; e++) {
+            const CtlEngine* engine = selfcheck_engines[e];
+            if (!still_fails(&tm, &f, engine)) continue;
+
+            printf("[ERROR] Iteration %d: engine %s disagrees with the reference\n", it, engine->name);
+            TestModel small = tm;
+            Formula small_f = f;
+            while (shrink_formula(&small, &small_f, engine) || shrink_model(&small, &small_f, engine)) {
+            }
+            printf("  Shrunk from %d states / %d formula nodes to %d states / %d formula nodes\n",
+                   tm.num_states, formula_size(&f, f.root),
+                   small.num_states, formula_size(&small_f, small_f.root));
+            print_counterexample(&small, &small_f, engine);
+            failures++;
+        }
+        if (!check_partial_order(it, &rng)) {
+            failures++;
+        }
+    }
+
+    printf("Self-check %s: %d mismatch(es) in %d iterations\n",
+           failures == 0 ? "passed" : "FAILED", failures, iterations);
+    return failures;
+}
@@ -0,0 +1,327 @@
+// ctl_small_kernels.c - Bit-parallel CTL operators for models of at most 256 states
+//
+// A small model keeps, for every state, its successor and predecessor sets as
+// bit masks of one, two or four 64-bit words. Every operator is written once
+// against a word count W and instantiated for W = 1, 2 and 4, so the compiler
+// sees a constant trip count and emits straight-line word operations.
+//
+// The small model of a Model is built on its first operator call and kept
+// until the model changes; the operators in ctl_operators.c run on it for
+// models whose state sets fit in one word.
+#include "ctl_common.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#define ALWAYS_INLINE static inline __attribute__((always_inline))
+
+/* Word-level set helpers */
+
+ALWAYS_INLINE bool set_test(const SmallSet* set, int state) {
+    return (set->words[state >> 6] >> (state & 63)) & 1;
+}
+
+ALWAYS_INLINE void set_add(SmallSet* set, int state) {
+    set->words[state >> 6] |= (uint64_t)1 << (state & 63);
+}
+
+ALWAYS_INLINE bool set_equal(const SmallSet* a, const SmallSet* b, const int W) {
+    uint64_t diff = 0;
+    for (int k = 0; k < W; k++) diff |= a->words[k] ^ b->words[k];
+    return diff == 0;
+}
+
+ALWAYS_INLINE bool set_is_empty(const SmallSet* a, const int W) {
+    uint64_t any = 0;
+    for (int k = 0; k < W; k++) any |= a->words[k];
+    return any == 0;
+}
+
+/* Operator templates, instantiated below for W = 1, 2, 4 */
+
+// τEX(Z): states with a successor in Z
+ALWAYS_INLINE void ex_kernel(SmallSet* result, const SmallSet* z, const SmallModel* m, const int W) {
+    SmallSet r = {{0}};
+    for (int s = 0; s < m->num_states; s++) {
+        uint64_t hit = 0;
+        for (int k = 0; k < W; k++) hit |= m->succ[s].words[k] & z->words[k];
+        r.words[s >> 6] |= (uint64_t)(hit != 0) << (s & 63);
+    }
+    *result = r;
+}
+
+// τAX(Z): states with at least one successor, all of them in Z
+ALWAYS_INLINE void ax_kernel(SmallSet* result, const SmallSet* z, const SmallModel* m, const int W) {
+    SmallSet r = {{0}};
+    for (int s = 0; s < m->num_states; s++) {
+        uint64_t miss = 0;
+        for (int k = 0; k < W; k++) miss |= m->succ[s].words[k] & ~z->words[k];
+        r.words[s >> 6] |= (uint64_t)(miss == 0) << (s & 63);
+    }
+    for (int k = 0; k < W; k++) r.words[k] &= m->has_succ.words[k];
+    *result = r;
+}
+
+// E[P U Q] by backward frontier expansion over predecessor masks (P = NULL for EF)
+ALWAYS_INLINE void eu_kernel(SmallSet* result, const SmallSet* p, const SmallSet* q,
+                             const SmallModel* m, const int W) {
+    SmallSet z = *q, frontier = *q;
+
+    while (!set_is_empty(&frontier, W)) {
+        SmallSet next = {{0}};
+        for (int k = 0; k < W; k++) {
+            uint64_t bits = frontier.words[k];
+            while (bits != 0) {
+                int t = (k << 6) + __builtin_ctzll(bits);
+                bits &= bits - 1;
+                for (int j = 0; j < W; j++) next.words[j] |= m->pred[t].words[j];
+            }
+        }
+        for (int k = 0; k < W; k++) {
+            next.words[k] &= ~z.words[k];
+            if (p != NULL) next.words[k] &= p->words[k];
+            z.words[k] |= next.words[k];
+        }
+        frontier = next;
+    }
+    *result = z;
+}
+
+// EG P = νZ.(P ∩ τEX(Z)); states without successors are kept, as in eval_eg
+ALWAYS_INLINE void eg_kernel(SmallSet* result, const SmallSet* p, const SmallModel* m, const int W) {
+    SmallSet z = *p, ex;
+    for (;;) {
+        SmallSet next = {{0}};
+        ex_kernel(&ex, &z, m, W);
+        for (int k = 0; k < W; k++) {
+            next.words[k] = p->words[k] & (ex.words[k] | ~m->has_succ.words[k]);
+        }
+        if (set_equal(&next, &z, W)) break;
+        z = next;
+    }
+    *result = z;
+}
+
+// A[P U Q] = μZ.(Q ∪ (P ∩ τAX(Z)))
+ALWAYS_INLINE void au_kernel(SmallSet* result, const SmallSet* p, const SmallSet* q,
+                             const SmallModel* m, const int W) {
+    SmallSet z = *q, ax;
+    for (;;) {
+        SmallSet next = {{0}};
+        ax_kernel(&ax, &z, m, W);
+        for (int k = 0; k < W; k++) {
+            next.words[k] = q->words[k] | (p->words[k] & ax.words[k]);
+        }
+        if (set_equal(&next, &z, W)) break;
+        z = next;
+    }
+    *result = z;
+}
+
+ALWAYS_INLINE void complement_kernel(SmallSet* result, const SmallSet* set, const SmallModel* m, const int W) {
+    for (int k = 0; k < W; k++) result->words[k] = ~set->words[k] & m->all.words[k];
+}
+
+// AF P = ¬EG ¬P
+ALWAYS_INLINE void af_kernel(SmallSet* result, const SmallSet* p, const SmallModel* m, const int W) {
+    SmallSet not_p, eg_not_p;
+    complement_kernel(&not_p, p, m, W);
+    eg_kernel(&eg_not_p, &not_p, m, W);
+    complement_kernel(result, &eg_not_p, m, W);
+}
+
+// AG P = ¬EF ¬P
+ALWAYS_INLINE void ag_kernel(SmallSet* result, const SmallSet* p, const SmallModel* m, const int W) {
+    SmallSet not_p, ef_not_p;
+    complement_kernel(&not_p, p, m, W);
+    eu_kernel(&ef_not_p, NULL, &not_p, m, W);
+    complement_kernel(result, &ef_not_p, m, W);
+}
+
+// Instantiate the operator set for a fixed word count
+#define SMALL_KERNELS(W)                                                                              \
+    static void ex_##W(SmallSet* r, const SmallSet* z, const SmallModel* m) { ex_kernel(r, z, m, W); } \
+    static void ax_##W(SmallSet* r, const SmallSet* z, const SmallModel* m) { ax_kernel(r, z, m, W); } \
+    static void ef_##W(SmallSet* r, const SmallSet* p, const SmallModel* m) { eu_kernel(r, NULL, p, m, W); } \
+    static void eg_##W(SmallSet* r, const SmallSet* p, const SmallModel* m) { eg_kernel(r, p, m, W); } \
+    static void af_##W(SmallSet* r, const SmallSet* p, const SmallModel* m) { af_kernel(r, p, m, W); } \
+    static void ag_##W(SmallSet* r, const SmallSet* p, const SmallModel* m) { ag_kernel(r, p, m, W); } \
+    static void eu_##W(SmallSet* r, const SmallSet* p, const SmallSet* q, const SmallModel* m) {     \
+        eu_kernel(r, p, q, m, W);                                                                     \
+    }                                                                                                 \
+    static void au_##W(SmallSet* r, const SmallSet* p, const SmallSet* q, const SmallModel* m) {     \
+        au_kernel(r, p, q, m, W);                                                                     \
+    }                                                                                                 \
+    static const SmallKernels small_kernels_##W = {                                                   \
+        ex_##W, ax_##W, ef_##W, eg_##W, af_##W, ag_##W, eu_##W, au_##W                                \
+    };
+
+SMALL_KERNELS(1)
+SMALL_KERNELS(2)
+SMALL_KERNELS(4)
+
+/* Small model construction and conversion */
+
+// Precompute successor/predecessor masks; fails for models above SMALL_MODEL_MAX_STATES
+bool build_small_model(SmallModel* small, Model* model) {
+    if (model->num_states > SMALL_MODEL_MAX_STATES) {
+        fprintf(stderr, "Error: Model has %d states, small kernels support at most %d\n",
+                model->num_states, SMALL_MODEL_MAX_STATES);
+        return false;
+    }
+
+    memset(small, 0, sizeof(*small));
+    small->num_states = model->num_states;
+    small->num_props = model->num_props;
+
+    if (model->num_states <= 64) {
+        small->num_words = 1;
+        small->kernels = &small_kernels_1;
+    } else if (model->num_states <= 128) {
+        small->num_words = 2;
+        small->kernels = &small_kernels_2;
+    } else {
+        small->num_words = 4;
+        small->kernels = &small_kernels_4;
+    }
+
+    for (int s = 0; s < model->num_states; s++) {
+        State* state = &model->states[s];
+        set_add(&small->all, s);
+        if (state->num_transitions > 0) {
+            set_add(&small->has_succ, s);
+        }
+        for (int j = 0; j < state->num_transitions; j++) {
+            int t = state->transitions[j];
+            set_add(&small->succ[s], t);
+            set_add(&small->pred[t], s);
+        }
+        for (int p = 0; p < model->num_props; p++) {
+            if (state->atomic_props[p]) {
+                set_add(&small->props[p], s);
+            }
+        }
+    }
+
+    return true;
+}
+
+void small_set_from_state_set(SmallSet* dest, StateSet* src, const SmallModel* small) {
+    memset(dest, 0, sizeof(*dest));
+    for (int s = 0; s < small->num_states; s++) {
+        if (src->members[s]) {
+            set_add(dest, s);
+        }
+    }
+}
+
+void small_set_to_state_set(StateSet* dest, const SmallSet* src, const SmallModel* small) {
+    init_state_set(dest, small->num_states);
+    for (int s = 0; s < small->num_states; s++) {
+        if (set_test(src, s)) {
+            add_to_state_set(dest, s);
+        }
+    }
+}
+
+/* Cached small models and operator dispatch */
+
+// Lazy builds may race when the sweep runs on a worker pool
+static pthread_mutex_t small_model_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// The small model of a model, built on first use (NULL if it cannot be built)
+static const SmallModel* cached_small_model(Model* model) {
+    pthread_mutex_lock(&small_model_lock);
+    if (model->small_model == NULL) {
+        SmallModel* small = (SmallModel*)malloc(sizeof(SmallModel));
+        if (small == NULL) {
+            fprintf(stderr, "Error: Memory allocation failed for small model\n");
+        } else if (!build_small_model(small, model)) {
+            free(small);
+            small = NULL;
+        }
+        model->small_model = small;
+    }
+    const SmallModel* small = model->small_model;
+    pthread_mutex_unlock(&small_model_lock);
+    return small;
+}
+
+// Let the operators of this model run on the small kernels (the default)
+void enable_small_kernels(Model* model, bool enabled) {
+    model->use_small_kernels = enabled;
+}
+
+// Drop the small model after a change to the model
+void invalidate_small_model(Model* model) {
+    free(model->small_model);
+    model->small_model = NULL;
+}
+
+// The small model the operators should run on, or NULL to use the StateSet
+// implementations (kernels disabled, or state sets of more than one word)
+const SmallModel* dispatch_small_model(Model* model) {
+    if (!model->use_small_kernels || model->num_states > SMALL_DISPATCH_MAX_STATES) {
+        return NULL;
+    }
+    return cached_small_model(model);
+}
+
+void small_unary(StateSet* result, StateSet* set, const SmallModel* small, SmallUnaryKernel kernel) {
+    SmallSet in, out;
+    small_set_from_state_set(&in, set, small);
+    kernel(&out, &in, small);
+    small_set_to_state_set(result, &out, small);
+}
+
+void small_binary(StateSet* result, StateSet* prop_p, StateSet* prop_q, const SmallModel* small,
+                  SmallBinaryKernel kernel) {
+    SmallSet p, q, out;
+    small_set_from_state_set(&p, prop_p, small);
+    small_set_from_state_set(&q, prop_q, small);
+    kernel(&out, &p, &q, small);
+    small_set_to_state_set(result, &out, small);
+}
+
+/* StateSet adapters, so the small kernels can run as a CtlEngine at any word count */
+
+// Dispatch through the kernel table the cached small model selected
+#define SMALL_UNARY_ADAPTER(NAME)                                                     \
+    static void small_##NAME##_adapter(StateSet* result, StateSet* set, Model* model) { \
+        const SmallModel* small = cached_small_model(model);                          \
+        if (small == NULL) {                                                          \
+            init_state_set(result, model->num_states);                                \
+            return;                                                                   \
+        }                                                                             \
+        small_unary(result, set, small, small->kernels->NAME);                        \
+    }
+
+#define SMALL_BINARY_ADAPTER(NAME)                                                    \
+    static void small_##NAME##_adapter(StateSet* result, StateSet* prop_p,            \
+                                       StateSet* prop_q, Model* model) {              \
+        const SmallModel* small = cached_small_model(model);                          \
+        if (small == NULL) {                                                          \
+            init_state_set(result, model->num_states);                                \
+            return;                                                                   \
+        }                                                                             \
+        small_binary(result, prop_p, prop_q, small, small->kernels->NAME);            \
+    }
+
+SMALL_UNARY_ADAPTER(ex)
+SMALL_UNARY_ADAPTER(ax)
+SMALL_UNARY_ADAPTER(ef)
+SMALL_UNARY_ADAPTER(eg)
+SMALL_UNARY_ADAPTER(af)
+SMALL_UNARY_ADAPTER(ag)
+SMALL_BINARY_ADAPTER(eu)
+SMALL_BINARY_ADAPTER(au)
+
+// Small kernels as an engine, for cross-checking every word count
+const CtlEngine small_kernels_engine = {
+    "small_kernels",
+    small_ex_adapter, small_ax_adapter,
+    small_ef_adapter, small_eg_adapter, small_af_adapter, small_ag_adapter,
+    small_eu_adapter, small_au_adapter,
+    false
+};
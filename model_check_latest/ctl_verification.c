@@ -4,12 +4,19 @@
 #include <stdlib.h>
 
 /* Equation Verification Functions */
-char* msg_tag = " CTL Model Checking ";
+_Thread_local char* msg_tag = " CTL Model Checking ";
+
+// Stream the verification output of this thread goes to (stdout unless redirected)
+_Thread_local FILE* g_verify_out = NULL;
+
+static FILE* verify_out(void) {
+    return g_verify_out != NULL ? g_verify_out : stdout;
+}
 
 // Function to verify equation 1: [[p]] = {s ∈ W : v(s)(p) = true}
 void verify_equation1(Model* model, int prop_p) {
-    printf("\nEquation 1. Verifying [[p]] = [s ∈ W : v(s)(p) = true] where P =%s:\n", model->prop_names[prop_p]);
-    printf("   This equation defines the semantics of atomic propositions in CTL.\n");
+    fprintf(verify_out(), "\nEquation 1. Verifying [[p]] = [s ∈ W : v(s)(p) = true] where P = %s:\n", model->prop_names[prop_p]);
+    fprintf(verify_out(), "   This equation defines the semantics of atomic propositions in CTL.\n");
     msg_tag = "Equation 1";
     // Get p
     StateSet p_result;
@@ -27,19 +34,20 @@ void verify_equation1(Model* model, int prop_p) {
     
     // Compare results
     bool equal = compare_state_sets(&p_result, &manual_result);
-    // printf("  API result [[%s]] = ", model->prop_names[p]);
-    printf("  Computed [[p]] = ");
-    print_state_set(&p_result, model, "p");
-    printf("  Manually computed [s ∈ W : v(s)(%s) = true] = ", model->prop_names[prop_p]);
-    print_state_set(&manual_result, model, "manual result");
-    printf("  Equation holds: %s\n\n", equal ? "YES" : "NO");
+    // fprintf(verify_out(), "  API result [[%s]] = ", model->prop_names[p]);
+    fprintf(verify_out(), "  Computed [[p]] = ");
+    fprint_state_set(verify_out(), &p_result, model, "p");
+    fprintf(verify_out(), "  Manually computed [s ∈ W : v(s)(%s) = true] = ", model->prop_names[prop_p]);
+    fprint_state_set(verify_out(), &manual_result, model, "manual result");
+    fprintf(verify_out(), "  Equation holds: %s\n\n", equal ? "YES" : "NO");
+    report_result(1, prop_p, -1, &p_result, &manual_result, equal);
 
 }
 
 // Function to verify equation 2: [[¬P]] = W \ [[P]]
 void verify_equation2(Model* model, int prop_p) {
-    printf("\nEquation 2. Verifying [[¬P]] = W \\ [[P]] where P = %s:\n", model->prop_names[prop_p]);
-    printf("   This equation defines the semantics of negation in CTL.\n");
+    fprintf(verify_out(), "\nEquation 2. Verifying [[¬P]] = W \\ [[P]] where P = %s:\n", model->prop_names[prop_p]);
+    fprintf(verify_out(), "   This equation defines the semantics of negation in CTL.\n");
     msg_tag = "Equation 2";
     // Get [[P]]
     StateSet p_result;
@@ -61,21 +69,22 @@ void verify_equation2(Model* model, int prop_p) {
     
     // Compare results
     bool equal = compare_state_sets(&not_p_result, &complement_result);
-    printf("  Computed [[¬P]] = ");
-    print_state_set(&not_p_result, model, "not P");
-    printf("  Manually computed W \\ [[P]] = ");
-    print_state_set(&complement_result, model, "complement");
-    printf("  Equation holds: %s\n", equal ? "YES" : "NO");
+    fprintf(verify_out(), "  Computed [[¬P]] = ");
+    fprint_state_set(verify_out(), &not_p_result, model, "not P");
+    fprintf(verify_out(), "  Manually computed W \\ [[P]] = ");
+    fprint_state_set(verify_out(), &complement_result, model, "complement");
+    fprintf(verify_out(), "  Equation holds: %s\n", equal ? "YES" : "NO");
+    report_result(2, prop_p, -1, &not_p_result, &complement_result, equal);
     if (!equal) {
-        printf(" [ERROR] %s not holds\n", msg_tag);
+        fprintf(verify_out(), " [ERROR] %s not holds\n", msg_tag);
     }
 }
 
 // Function to verify equation 3: [[P ∧ Q]] = [[P]] ∩ [[Q]]
 void verify_equation3(Model* model, int prop_p, int prop_q) {
-    printf("\nEquation 3. Verifying [[P ∧ Q]] = [[P]] ∩ [[Q]] where P = %s, Q = %s:\n", 
+    fprintf(verify_out(), "\nEquation 3. Verifying [[P ∧ Q]] = [[P]] ∩ [[Q]] where P = %s, Q = %s:\n", 
            model->prop_names[prop_p], model->prop_names[prop_q]);
-    printf("   This equation defines the semantics of conjunction in CTL.\n");
+    fprintf(verify_out(), "   This equation defines the semantics of conjunction in CTL.\n");
     msg_tag = "Equation 3";
     // Get [[P]]
     StateSet p_result;
@@ -102,21 +111,22 @@ void verify_equation3(Model* model, int prop_p, int prop_q) {
     
     // Compare results
     bool equal = compare_state_sets(&intersection_api, &intersection_manual);
-    printf("  Computed [[P ∧ Q]] = ");
-    print_state_set(&intersection_api, model, "P ∧ Q");
-    printf("  Manually computed [[P]] ∩ [[Q]] = ");
-    print_state_set(&intersection_manual, model, "intersection");
-    printf("  Equation holds: %s\n", equal ? "YES" : "NO");
+    fprintf(verify_out(), "  Computed [[P ∧ Q]] = ");
+    fprint_state_set(verify_out(), &intersection_api, model, "P ∧ Q");
+    fprintf(verify_out(), "  Manually computed [[P]] ∩ [[Q]] = ");
+    fprint_state_set(verify_out(), &intersection_manual, model, "intersection");
+    fprintf(verify_out(), "  Equation holds: %s\n", equal ? "YES" : "NO");
+    report_result(3, prop_p, prop_q, &intersection_api, &intersection_manual, equal);
     if (!equal) {
-        printf(" [ERROR] %s not holds\n", msg_tag);
+        fprintf(verify_out(), " [ERROR] %s not holds\n", msg_tag);
     }
 }
 
 // Function to verify equation 4: [[P ∨ Q]] = [[P]] ∪ [[Q]]
 void verify_equation4(Model* model, int prop_p, int prop_q) {
-    printf("\nEquation 4. Verifying [[P ∨ Q]] = [[P]] ∪ [[Q]] where P = %s, Q = %s:\n", 
+    fprintf(verify_out(), "\nEquation 4. Verifying [[P ∨ Q]] = [[P]] ∪ [[Q]] where P = %s, Q = %s:\n", 
            model->prop_names[prop_p], model->prop_names[prop_q]);
-    printf("   This equation defines the semantics of disjunction in CTL.\n");
+    fprintf(verify_out(), "   This equation defines the semantics of disjunction in CTL.\n");
     msg_tag = "Equation 4";
     // Get [[P]]
     StateSet p_result;
@@ -143,37 +153,37 @@ void verify_equation4(Model* model, int prop_p, int prop_q) {
     
     // Compare results
     bool equal = compare_state_sets(&union_api, &union_manual);
-    printf("  Computed [[P ∨ Q]] = ");
-    print_state_set(&union_api, model, "P ∨ Q");
-    printf("  Manually computed [[P]] ∪ [[Q]] = ");
-    print_state_set(&union_manual, model, "union");
-    printf("  Equation holds: %s\n", equal ? "YES" : "NO");
+    fprintf(verify_out(), "  Computed [[P ∨ Q]] = ");
+    fprint_state_set(verify_out(), &union_api, model, "P ∨ Q");
+    fprintf(verify_out(), "  Manually computed [[P]] ∪ [[Q]] = ");
+    fprint_state_set(verify_out(), &union_manual, model, "union");
+    fprintf(verify_out(), "  Equation holds: %s\n", equal ? "YES" : "NO");
+    report_result(4, prop_p, prop_q, &union_api, &union_manual, equal);
     if (!equal) {
-        printf(" [ERROR] %s not holds\n", msg_tag);
+        fprintf(verify_out(), " [ERROR] %s not holds\n", msg_tag);
     }
 }
 
 // Function to verify equation 5: [[EX P]] = τEX([[P]])
 void verify_equation5(Model* model, int prop_p) {
-    printf("\nEquation 5. Verifying [[EX P]] = τEX([[P]]) where P = %s:\n", model->prop_names[prop_p]);
-    printf("   This equation defines the semantics of the existential next operator in CTL.\n");
-    printf("   τEX(Z) = {s ∈ W : t ∈ Z for some state t with s y t}\n");
+    fprintf(verify_out(), "\nEquation 5. Verifying [[EX P]] = τEX([[P]]) where P = %s:\n", model->prop_names[prop_p]);
+    fprintf(verify_out(), "   This equation defines the semantics of the existential next operator in CTL.\n");
+    fprintf(verify_out(), "   τEX(Z) = {s ∈ W : t ∈ Z for some state t with s y t}\n");
     msg_tag = "Equation 5";
 
     // Get [[P]]
     StateSet p_result;
     eval_atomic_prop(&p_result, model, prop_p);
     
-    // Calculate [[EX P]] using existential_successor
+    // Calculate [[EX P]] using existential_successor (on the quotient with --bisim)
     StateSet ex_p_api;
-    init_state_set(&ex_p_api, model->num_states);
-    existential_successor(&ex_p_api, &p_result, model);
+    eval_unary_formula(&ex_p_api, existential_successor, model, prop_p);
     
     // Calculate τEX([[P]]) manually
     StateSet tau_ex_manual;
     init_state_set(&tau_ex_manual, model->num_states);
     
-    printf("  Computing τEX manually:\n");
+    fprintf(verify_out(), "  Computing τEX manually:\n");
     
     for (int i = 0; i < model->num_states; i++) {
         State* current_state = &model->states[i];
@@ -190,37 +200,37 @@ void verify_equation5(Model* model, int prop_p) {
     
     // Compare results
     bool equal = compare_state_sets(&ex_p_api, &tau_ex_manual);
-    printf("  Computed [[EX P]] = ");
-    print_state_set(&ex_p_api, model, "EX P");
-    printf("  Manually computed τEX([[P]]) = ");
-    print_state_set(&tau_ex_manual, model, "τEX");
-    printf("  Equation holds: %s\n", equal ? "YES" : "NO");
+    fprintf(verify_out(), "  Computed [[EX P]] = ");
+    fprint_state_set(verify_out(), &ex_p_api, model, "EX P");
+    fprintf(verify_out(), "  Manually computed τEX([[P]]) = ");
+    fprint_state_set(verify_out(), &tau_ex_manual, model, "τEX");
+    fprintf(verify_out(), "  Equation holds: %s\n", equal ? "YES" : "NO");
+    report_result(5, prop_p, -1, &ex_p_api, &tau_ex_manual, equal);
     if (!equal) {
-        printf(" [ERROR] %s not holds\n", msg_tag);
+        fprintf(verify_out(), " [ERROR] %s not holds\n", msg_tag);
     }
 }
 
 // Function to verify equation 6: [[AX P]] = τAX([[P]])
 void verify_equation6(Model* model, int prop_p) {
-    printf("\nEquation 6. Verifying [[AX P]] = τAX([[P]]) where P = %s:\n", model->prop_names[prop_p]);
-    printf("   This equation defines the semantics of the universal next operator in CTL.\n");
-    printf("   τAX(Z) = {s ∈ W : t ∈ Z for all states t with s y t}\n");
+    fprintf(verify_out(), "\nEquation 6. Verifying [[AX P]] = τAX([[P]]) where P = %s:\n", model->prop_names[prop_p]);
+    fprintf(verify_out(), "   This equation defines the semantics of the universal next operator in CTL.\n");
+    fprintf(verify_out(), "   τAX(Z) = {s ∈ W : t ∈ Z for all states t with s y t}\n");
     msg_tag = "Equation 6";
 
     // Get [[P]]
     StateSet p_result;
     eval_atomic_prop(&p_result, model, prop_p);
     
-    // Calculate [[AX P]] using universal_successor
+    // Calculate [[AX P]] using universal_successor (on the quotient with --bisim)
     StateSet ax_p_api;
-    init_state_set(&ax_p_api, model->num_states);
-    universal_successor(&ax_p_api, &p_result, model);
+    eval_unary_formula(&ax_p_api, universal_successor, model, prop_p);
     
     // Calculate τAX([[P]]) manually
     StateSet tau_ax_manual;
     init_state_set(&tau_ax_manual, model->num_states);
     
-    printf("  Computing τAX manually:\n");
+    fprintf(verify_out(), "  Computing τAX manually:\n");
     
     for (int i = 0; i < model->num_states; i++) {
         State* current_state = &model->states[i];
@@ -245,31 +255,31 @@ void verify_equation6(Model* model, int prop_p) {
     
     // Compare results
     bool equal = compare_state_sets(&ax_p_api, &tau_ax_manual);
-    printf("  Computed [[AX P]] = ");
-    print_state_set(&ax_p_api, model, "AX P");
-    printf("  Manually computed τAX([[P]]) = ");
-    print_state_set(&tau_ax_manual, model, "τAX");
-    printf("  Equation holds: %s\n", equal ? "YES" : "NO");
+    fprintf(verify_out(), "  Computed [[AX P]] = ");
+    fprint_state_set(verify_out(), &ax_p_api, model, "AX P");
+    fprintf(verify_out(), "  Manually computed τAX([[P]]) = ");
+    fprint_state_set(verify_out(), &tau_ax_manual, model, "τAX");
+    fprintf(verify_out(), "  Equation holds: %s\n", equal ? "YES" : "NO");
+    report_result(6, prop_p, -1, &ax_p_api, &tau_ax_manual, equal);
     if (!equal) {
-        printf(" [ERROR] %s not holds\n", msg_tag);
+        fprintf(verify_out(), " [ERROR] %s not holds\n", msg_tag);
     }
 }
 
 // Function to verify equation 7: [[EF P]] = μZ.([[P]] ∪ τEX(Z))
 void verify_equation7(Model* model, int prop_p) {
-    printf("\nEquation 7. Verifying [[EF P]] = μZ.([[P]] ∪ τEX(Z)) where P = %s:\n", model->prop_names[prop_p]);
-    printf("   This equation defines the semantics of the existential finally operator using a least fixpoint.\n");
-    printf("   μZ.f(Z) denotes the least fixpoint of the operation f(Z).\n");
+    fprintf(verify_out(), "\nEquation 7. Verifying [[EF P]] = μZ.([[P]] ∪ τEX(Z)) where P = %s:\n", model->prop_names[prop_p]);
+    fprintf(verify_out(), "   This equation defines the semantics of the existential finally operator using a least fixpoint.\n");
+    fprintf(verify_out(), "   μZ.f(Z) denotes the least fixpoint of the operation f(Z).\n");
     msg_tag = "Equation 7";
 
     // Get [[P]]
     StateSet p_result;
     eval_atomic_prop(&p_result, model, prop_p);
     
-    // Calculate [[EF P]] using eval_ef
+    // Calculate [[EF P]] using eval_ef (on the quotient with --bisim)
     StateSet ef_p_api;
-    init_state_set(&ef_p_api, model->num_states);
-    eval_ef(&ef_p_api, &p_result, model);
+    eval_unary_formula(&ef_p_api, eval_ef, model, prop_p);
     
     // Calculate μZ.([[P]] ∪ τEX(Z)) manually using fixed-point iteration
     StateSet z_current, z_next, tau_ex_result;
@@ -278,12 +288,12 @@ void verify_equation7(Model* model, int prop_p) {
     bool changed = true;
     int iteration = 0;
     
-    printf("  Computing μZ.([[P]] ∪ τEX(Z)) as a least fixpoint:\n");
-    printf("  Starting with Z₀ = ∅ (empty set) and iterating:\n");
+    fprintf(verify_out(), "  Computing μZ.([[P]] ∪ τEX(Z)) as a least fixpoint:\n");
+    fprintf(verify_out(), "  Starting with Z₀ = ∅ (empty set) and iterating:\n");
     
     while (changed) {
-        printf("    Iteration %d: Z_%d = ", iteration, iteration);
-        print_state_set(&z_current, model, "current Z");
+        fprintf(verify_out(), "    Iteration %d: Z_%d = ", iteration, iteration);
+        fprint_state_set(verify_out(), &z_current, model, "current Z");
         
         // Calculate τEX(Z_current)
         existential_successor(&tau_ex_result, &z_current, model);
@@ -294,8 +304,8 @@ void verify_equation7(Model* model, int prop_p) {
         // Check if fixed point is reached
         changed = !compare_state_sets(&z_current, &z_next);
         if (!changed) {
-            printf("    Next Iteration %d: Z_%d = ", iteration, iteration);
-            print_state_set(&z_next, model, "next Z");
+            fprintf(verify_out(), "    Next Iteration %d: Z_%d = ", iteration, iteration);
+            fprint_state_set(verify_out(), &z_next, model, "next Z");
         }
         
         // Update Z for next iteration
@@ -303,34 +313,34 @@ void verify_equation7(Model* model, int prop_p) {
         iteration++;
     }
     
-    printf("    Fixed point reached at iteration %d\n", iteration-1);
+    fprintf(verify_out(), "    Fixed point reached at iteration %d\n", iteration-1);
     
     // Compare results
     bool equal = compare_state_sets(&ef_p_api, &z_current);
-    printf("  Computed [[EF P]] = ");
-    print_state_set(&ef_p_api, model, "EF P");
-    printf("  Manually computed μZ.([[P]] ∪ τEX(Z)) = ");
-    print_state_set(&z_current, model, "fixed point");
-    printf("  Equation holds: %s\n", equal ? "YES" : "NO");
+    fprintf(verify_out(), "  Computed [[EF P]] = ");
+    fprint_state_set(verify_out(), &ef_p_api, model, "EF P");
+    fprintf(verify_out(), "  Manually computed μZ.([[P]] ∪ τEX(Z)) = ");
+    fprint_state_set(verify_out(), &z_current, model, "fixed point");
+    fprintf(verify_out(), "  Equation holds: %s\n", equal ? "YES" : "NO");
+    report_result(7, prop_p, -1, &ef_p_api, &z_current, equal);
     if (!equal) {
-        printf(" [ERROR] %s not holds\n", msg_tag);
+        fprintf(verify_out(), " [ERROR] %s not holds\n", msg_tag);
     }
 }
 
 // Function to verify equation 8: [[EG P]] = νZ.([[P]] ∩ τEX(Z))
 void verify_equation8(Model* model, int prop_p) {
-    printf("\nEquation 8. Verifying [[EG P]] = νZ.([[P]] ∩ τEX(Z)) where P = %s:\n", model->prop_names[prop_p]);
-    printf("   This equation defines the semantics of the existential globally operator using a greatest fixpoint.\n");
-    printf("   νZ.f(Z) denotes the greatest fixpoint of the operation f(Z).\n");
+    fprintf(verify_out(), "\nEquation 8. Verifying [[EG P]] = νZ.([[P]] ∩ τEX(Z)) where P = %s:\n", model->prop_names[prop_p]);
+    fprintf(verify_out(), "   This equation defines the semantics of the existential globally operator using a greatest fixpoint.\n");
+    fprintf(verify_out(), "   νZ.f(Z) denotes the greatest fixpoint of the operation f(Z).\n");
     msg_tag = "Equation 8";
     // Get [[P]]
     StateSet p_result;
     eval_atomic_prop(&p_result, model, prop_p);
     
-    // Calculate [[EG P]] using eval_eg
+    // Calculate [[EG P]] using eval_eg (on the quotient with --bisim)
     StateSet eg_p_api;
-    init_state_set(&eg_p_api, model->num_states);
-    eval_eg(&eg_p_api, &p_result, model);
+    eval_unary_formula(&eg_p_api, eval_eg, model, prop_p);
     
     // Calculate νZ.([[P]] ∩ τEX(Z)) manually using fixed-point iteration
     StateSet z_current, z_next, tau_ex_result;
@@ -341,12 +351,12 @@ void verify_equation8(Model* model, int prop_p) {
     bool changed = true;
     int iteration = 0;
     
-    printf("  Computing νZ.([[P]] ∩ τEX(Z)) as a greatest fixpoint:\n");
-    printf("  Starting with Z₀ = [[P]] and iterating:\n");
+    fprintf(verify_out(), "  Computing νZ.([[P]] ∩ τEX(Z)) as a greatest fixpoint:\n");
+    fprintf(verify_out(), "  Starting with Z₀ = [[P]] and iterating:\n");
     
     while (changed) {
-        printf("    Iteration %d: Z_%d = ", iteration, iteration);
-        print_state_set(&z_current, model, "current Z");
+        fprintf(verify_out(), "    Iteration %d: Z_%d = ", iteration, iteration);
+        fprint_state_set(verify_out(), &z_current, model, "current Z");
         
         // Calculate τEX(Z_current)
         existential_successor(&tau_ex_result, &z_current, model);
@@ -357,8 +367,8 @@ void verify_equation8(Model* model, int prop_p) {
         // Check if fixed point is reached
         changed = !compare_state_sets(&z_current, &z_next);
         if (!changed) {
-            printf("    Next Iteration %d: Z_%d = ", iteration, iteration);
-            print_state_set(&z_next, model, "next Z");
+            fprintf(verify_out(), "    Next Iteration %d: Z_%d = ", iteration, iteration);
+            fprint_state_set(verify_out(), &z_next, model, "next Z");
         }
         
         // Update Z for next iteration
@@ -366,35 +376,35 @@ void verify_equation8(Model* model, int prop_p) {
         iteration++;
     }
     
-    printf("    Fixed point reached at iteration %d\n", iteration-1);
+    fprintf(verify_out(), "    Fixed point reached at iteration %d\n", iteration-1);
     
     // Compare results
     bool equal = compare_state_sets(&eg_p_api, &z_current);
-    printf("  Computed [[EG P]] = ");
-    print_state_set(&eg_p_api, model, "EG P");
-    printf("  Manually computed νZ.([[P]] ∩ τEX(Z)) = ");
-    print_state_set(&z_current, model, "fixed point");
-    printf("  Equation holds: %s\n", equal ? "YES" : "NO");
+    fprintf(verify_out(), "  Computed [[EG P]] = ");
+    fprint_state_set(verify_out(), &eg_p_api, model, "EG P");
+    fprintf(verify_out(), "  Manually computed νZ.([[P]] ∩ τEX(Z)) = ");
+    fprint_state_set(verify_out(), &z_current, model, "fixed point");
+    fprintf(verify_out(), "  Equation holds: %s\n", equal ? "YES" : "NO");
+    report_result(8, prop_p, -1, &eg_p_api, &z_current, equal);
     if (!equal) {
-        printf(" [ERROR] %s not holds\n", msg_tag);
+        fprintf(verify_out(), " [ERROR] %s not holds\n", msg_tag);
     }
 }
 
 // Function to verify equation 9: [[AF P]] = μZ.([[P]] ∪ τAX(Z))
 void verify_equation9(Model* model, int prop_p) {
-    printf("\nEquation 9. Verifying [[AF P]] = μZ.([[P]] ∪ τAX(Z)) where P = %s:\n", model->prop_names[prop_p]);
-    printf("   This equation defines the semantics of the always finally operator using a least fixpoint.\n");
-    printf("   μZ.f(Z) denotes the least fixpoint of the operation f(Z).\n");
+    fprintf(verify_out(), "\nEquation 9. Verifying [[AF P]] = μZ.([[P]] ∪ τAX(Z)) where P = %s:\n", model->prop_names[prop_p]);
+    fprintf(verify_out(), "   This equation defines the semantics of the always finally operator using a least fixpoint.\n");
+    fprintf(verify_out(), "   μZ.f(Z) denotes the least fixpoint of the operation f(Z).\n");
     msg_tag = "Equation 9";
 
     // Get [[P]]
     StateSet p_result;
     eval_atomic_prop(&p_result, model, prop_p);
     
-    // Calculate [[AF P]] using eval_af
+    // Calculate [[AF P]] using eval_af (on the quotient with --bisim)
     StateSet af_p_api;
-    init_state_set(&af_p_api, model->num_states);
-    eval_af(&af_p_api, &p_result, model);
+    eval_unary_formula(&af_p_api, eval_af, model, prop_p);
     
     // Calculate μZ.([[P]] ∪ τAX(Z)) manually using fixed-point iteration
     StateSet z_current, z_next, tau_ax_result;
@@ -403,12 +413,12 @@ void verify_equation9(Model* model, int prop_p) {
     bool changed = true;
     int iteration = 0;
     
-    printf("  Computing μZ.([[P]] ∪ τAX(Z)) as a least fixpoint:\n");
-    printf("  Starting with Z₀ = ∅ (empty set) and iterating:\n");
+    fprintf(verify_out(), "  Computing μZ.([[P]] ∪ τAX(Z)) as a least fixpoint:\n");
+    fprintf(verify_out(), "  Starting with Z₀ = ∅ (empty set) and iterating:\n");
     
     while (changed) {
-        printf("    Iteration %d: Z_%d = ", iteration, iteration);
-        print_state_set(&z_current, model, "current Z");
+        fprintf(verify_out(), "    Iteration %d: Z_%d = ", iteration, iteration);
+        fprint_state_set(verify_out(), &z_current, model, "current Z");
         
         // Calculate τAX(Z_current)
         universal_successor(&tau_ax_result, &z_current, model);
@@ -419,8 +429,8 @@ void verify_equation9(Model* model, int prop_p) {
         // Check if fixed point is reached
         changed = !compare_state_sets(&z_current, &z_next);
         if (!changed) {
-            printf("    Next Iteration %d: Z_%d = ", iteration, iteration);
-            print_state_set(&z_next, model, "next Z");
+            fprintf(verify_out(), "    Next Iteration %d: Z_%d = ", iteration, iteration);
+            fprint_state_set(verify_out(), &z_next, model, "next Z");
         }
         
         // Update Z for next iteration
@@ -428,10 +438,10 @@ void verify_equation9(Model* model, int prop_p) {
         iteration++;
     }
     
-    printf("    Fixed point reached at iteration %d\n", iteration-1);
+    fprintf(verify_out(), "    Fixed point reached at iteration %d\n", iteration-1);
     
     // Alternative calculation: AF P = ¬EG ¬P
-    printf("  Alternative calculation: AF P = ¬EG ¬P\n");
+    fprintf(verify_out(), "  Alternative calculation: AF P = ¬EG ¬P\n");
     
     // Calculate ¬P
     StateSet not_p;
@@ -447,35 +457,35 @@ void verify_equation9(Model* model, int prop_p) {
     
     // Compare with AF P calculated using fixpoint
     bool dual_equal = compare_state_sets(&not_eg_not_p, &z_current);
-    printf("  AF P = ¬EG ¬P: %s\n", dual_equal ? "YES" : "NO");
+    fprintf(verify_out(), "  AF P = ¬EG ¬P: %s\n", dual_equal ? "YES" : "NO");
     
     // Compare results with API
     bool equal = compare_state_sets(&af_p_api, &z_current);
-    printf("  Computed [[AF P]] = ");
-    print_state_set(&af_p_api, model, "AF P");
-    printf("  Manually computed μZ.([[P]] ∪ τAX(Z)) = ");
-    print_state_set(&z_current, model, "fixed point");
-    printf("  Equation holds: %s\n", equal ? "YES" : "NO");
+    fprintf(verify_out(), "  Computed [[AF P]] = ");
+    fprint_state_set(verify_out(), &af_p_api, model, "AF P");
+    fprintf(verify_out(), "  Manually computed μZ.([[P]] ∪ τAX(Z)) = ");
+    fprint_state_set(verify_out(), &z_current, model, "fixed point");
+    fprintf(verify_out(), "  Equation holds: %s\n", equal ? "YES" : "NO");
+    report_result(9, prop_p, -1, &af_p_api, &z_current, equal);
     if (!equal) {
-        printf(" [ERROR] %s not holds\n", msg_tag);
+        fprintf(verify_out(), " [ERROR] %s not holds\n", msg_tag);
     }
 }
 
 // Function to verify equation 10: [[AG P]] = νZ.([[P]] ∩ τAX(Z))
 void verify_equation10(Model* model, int prop_p) {
-    printf("\nEquation 10. Verifying [[AG P]] = νZ.([[P]] ∩ τAX(Z)) where P = %s:\n", model->prop_names[prop_p]);
-    printf("    This equation defines the semantics of the always globally operator using a greatest fixpoint.\n");
-    printf("    νZ.f(Z) denotes the greatest fixpoint of the operation f(Z).\n");
+    fprintf(verify_out(), "\nEquation 10. Verifying [[AG P]] = νZ.([[P]] ∩ τAX(Z)) where P = %s:\n", model->prop_names[prop_p]);
+    fprintf(verify_out(), "    This equation defines the semantics of the always globally operator using a greatest fixpoint.\n");
+    fprintf(verify_out(), "    νZ.f(Z) denotes the greatest fixpoint of the operation f(Z).\n");
     msg_tag = "Equation 10";
 
     // Get [[P]]
     StateSet p_result;
     eval_atomic_prop(&p_result, model, prop_p);
     
-    // Calculate [[AG P]] using eval_ag
+    // Calculate [[AG P]] using eval_ag (on the quotient with --bisim)
     StateSet ag_p_api;
-    init_state_set(&ag_p_api, model->num_states);
-    eval_ag(&ag_p_api, &p_result, model);
+    eval_unary_formula(&ag_p_api, eval_ag, model, prop_p);
     
     // Calculate νZ.([[P]] ∩ τAX(Z)) manually using fixed-point iteration
     StateSet z_current, z_next, tau_ax_result;
@@ -486,12 +496,12 @@ void verify_equation10(Model* model, int prop_p) {
     bool changed = true;
     int iteration = 0;
     
-    printf("  Computing νZ.([[P]] ∩ τAX(Z)) as a greatest fixpoint:\n");
-    printf("  Starting with Z₀ = [[P]] and iterating:\n");
+    fprintf(verify_out(), "  Computing νZ.([[P]] ∩ τAX(Z)) as a greatest fixpoint:\n");
+    fprintf(verify_out(), "  Starting with Z₀ = [[P]] and iterating:\n");
     
     while (changed) {
-        printf("    Iteration %d: Z_%d = ", iteration, iteration);
-        print_state_set(&z_current, model, "current Z");
+        fprintf(verify_out(), "    Iteration %d: Z_%d = ", iteration, iteration);
+        fprint_state_set(verify_out(), &z_current, model, "current Z");
         
         // Calculate τAX(Z_current)
         universal_successor(&tau_ax_result, &z_current, model);
@@ -502,8 +512,8 @@ void verify_equation10(Model* model, int prop_p) {
         // Check if fixed point is reached
         changed = !compare_state_sets(&z_current, &z_next);
         if (!changed) {
-            printf("    Next Iteration %d: Z_%d = ", iteration, iteration);
-            print_state_set(&z_next, model, "next Z");
+            fprintf(verify_out(), "    Next Iteration %d: Z_%d = ", iteration, iteration);
+            fprint_state_set(verify_out(), &z_next, model, "next Z");
         }
         
         // Update Z for next iteration
@@ -511,10 +521,10 @@ void verify_equation10(Model* model, int prop_p) {
         iteration++;
     }
     
-    printf("    Fixed point reached at iteration %d\n", iteration-1);
+    fprintf(verify_out(), "    Fixed point reached at iteration %d\n", iteration-1);
     
     // Alternative calculation: AG P = ¬EF ¬P
-    printf("  Alternative calculation: AG P = ¬EF ¬P\n");
+    fprintf(verify_out(), "  Alternative calculation: AG P = ¬EF ¬P\n");
     
     // Calculate ¬P
     StateSet not_p;
@@ -530,26 +540,27 @@ void verify_equation10(Model* model, int prop_p) {
     
     // Compare with AG P calculated using fixpoint
     bool dual_equal = compare_state_sets(&not_ef_not_p, &z_current);
-    printf("  AG P = ¬EF ¬P: %s\n", dual_equal ? "YES" : "NO");
+    fprintf(verify_out(), "  AG P = ¬EF ¬P: %s\n", dual_equal ? "YES" : "NO");
     
     // Compare results
     bool equal = compare_state_sets(&ag_p_api, &z_current);
-    printf("  Computed [[AG P]] = ");
-    print_state_set(&ag_p_api, model, "AG P");
-    printf("  Manually computed νZ.([[P]] ∩ τAX(Z)) = ");
-    print_state_set(&z_current, model, "fixed point");
-    printf("  Equation holds: %s\n", equal ? "YES" : "NO");
+    fprintf(verify_out(), "  Computed [[AG P]] = ");
+    fprint_state_set(verify_out(), &ag_p_api, model, "AG P");
+    fprintf(verify_out(), "  Manually computed νZ.([[P]] ∩ τAX(Z)) = ");
+    fprint_state_set(verify_out(), &z_current, model, "fixed point");
+    fprintf(verify_out(), "  Equation holds: %s\n", equal ? "YES" : "NO");
+    report_result(10, prop_p, -1, &ag_p_api, &z_current, equal);
     if (!equal) {
-        printf(" [ERROR] %s not holds\n", msg_tag);
+        fprintf(verify_out(), " [ERROR] %s not holds\n", msg_tag);
     }
 }
 
 // Function to verify equation 11: [[EP UQ]] = μZ.([[Q]] ∪ ([[P]] ∩ τEX(Z)))
 void verify_equation11(Model* model, int prop_p, int prop_q) {
-    printf("\nEquation 11. Verifying [[EP UQ]] = μZ.([[Q]] ∪ ([[P]] ∩ τEX(Z))) where P = %s, Q = %s:\n", 
+    fprintf(verify_out(), "\nEquation 11. Verifying [[EP UQ]] = μZ.([[Q]] ∪ ([[P]] ∩ τEX(Z))) where P = %s, Q = %s:\n", 
            model->prop_names[prop_p], model->prop_names[prop_q]);
-    printf("    This equation defines the semantics of the existential until operator using a least fixpoint.\n");
-    printf("    μZ.f(Z) denotes the least fixpoint of the operation f(Z).\n");
+    fprintf(verify_out(), "    This equation defines the semantics of the existential until operator using a least fixpoint.\n");
+    fprintf(verify_out(), "    μZ.f(Z) denotes the least fixpoint of the operation f(Z).\n");
     msg_tag = "Equation 11";
 
     // Get [[P]]
@@ -560,10 +571,9 @@ void verify_equation11(Model* model, int prop_p, int prop_q) {
     StateSet q_result;
     eval_atomic_prop(&q_result, model, prop_q);
     
-    // Calculate [[EP UQ]] using eval_eu
+    // Calculate [[EP UQ]] using eval_eu (on the quotient with --bisim)
     StateSet eu_api;
-    init_state_set(&eu_api, model->num_states);
-    eval_eu(&eu_api, &p_result, &q_result, model);
+    eval_binary_formula(&eu_api, eval_eu, model, prop_p, prop_q);
     
     // Calculate μZ.([[Q]] ∪ ([[P]] ∩ τEX(Z))) manually using fixed-point iteration
     StateSet z_current, z_next, tau_ex_result, p_and_tau;
@@ -574,12 +584,12 @@ void verify_equation11(Model* model, int prop_p, int prop_q) {
     bool changed = true;
     int iteration = 0;
     
-    printf("  Computing μZ.([[Q]] ∪ ([[P]] ∩ τEX(Z))) as a least fixpoint:\n");
-    printf("  Starting with Z₀ = [[Q]] and iterating:\n");
+    fprintf(verify_out(), "  Computing μZ.([[Q]] ∪ ([[P]] ∩ τEX(Z))) as a least fixpoint:\n");
+    fprintf(verify_out(), "  Starting with Z₀ = [[Q]] and iterating:\n");
     
     while (changed) {
-        printf("    Iteration %d: Z_%d = ", iteration, iteration);
-        print_state_set(&z_current, model, "current Z");
+        fprintf(verify_out(), "    Iteration %d: Z_%d = ", iteration, iteration);
+        fprint_state_set(verify_out(), &z_current, model, "current Z");
         
         // Calculate τEX(Z_current)
         existential_successor(&tau_ex_result, &z_current, model);
@@ -589,12 +599,12 @@ void verify_equation11(Model* model, int prop_p, int prop_q) {
         
         // Calculate Z_next = [[Q]] ∪ ([[P]] ∩ τAX(Z_current))
         union_state_sets(&z_next, &q_result, &p_and_tau);
-        print_state_set(&z_next, model, "next Z");
+        fprint_state_set(verify_out(), &z_next, model, "next Z");
         // Check if fixed point is reached
         changed = !compare_state_sets(&z_current, &z_next);
         if (!changed) {
-            printf("    Next Iteration %d: Z_%d = ", iteration, iteration);
-            print_state_set(&z_next, model, "next Z");
+            fprintf(verify_out(), "    Next Iteration %d: Z_%d = ", iteration, iteration);
+            fprint_state_set(verify_out(), &z_next, model, "next Z");
         }
         
         // Update Z for next iteration
@@ -602,27 +612,28 @@ void verify_equation11(Model* model, int prop_p, int prop_q) {
         iteration++;
     }
     
-    printf("    Fixed point reached at iteration %d\n", iteration-1);
+    fprintf(verify_out(), "    Fixed point reached at iteration %d\n", iteration-1);
     
     // Compare results
     bool equal = compare_state_sets(&eu_api, &z_current);
-    printf("  Computed [[EP UQ]] = ");
-    print_state_set(&eu_api, model, "EU");
-    printf("  Manually computed μZ.([[Q]] ∪ ([[P]] ∩ τEX(Z))) = ");
-    print_state_set(&z_current, model, "fixed point");
-    printf("  Equation holds: %s\n", equal ? "YES" : "NO");
+    fprintf(verify_out(), "  Computed [[EP UQ]] = ");
+    fprint_state_set(verify_out(), &eu_api, model, "EU");
+    fprintf(verify_out(), "  Manually computed μZ.([[Q]] ∪ ([[P]] ∩ τEX(Z))) = ");
+    fprint_state_set(verify_out(), &z_current, model, "fixed point");
+    fprintf(verify_out(), "  Equation holds: %s\n", equal ? "YES" : "NO");
+    report_result(11, prop_p, prop_q, &eu_api, &z_current, equal);
     if (!equal) {
-        printf(" [ERROR] %s not holds\n", msg_tag);
+        fprintf(verify_out(), " [ERROR] %s not holds\n", msg_tag);
     }
 }
 
 // Function to verify equation 12: [[AP UQ]] = μZ.([[Q]] ∪ ([[P]] ∩ τAX(Z)))
 // Default takes P = p1n and Q = p2n
 void verify_equation12(Model* model, int prop_p, int prop_q) {
-    printf("\nEquation 12. Verifying [[AP UQ]] = μZ.([[Q]] ∪ ([[P]] ∩ τAX(Z))) where P = %s, Q = %s:\n", 
+    fprintf(verify_out(), "\nEquation 12. Verifying [[AP UQ]] = μZ.([[Q]] ∪ ([[P]] ∩ τAX(Z))) where P = %s, Q = %s:\n", 
            model->prop_names[prop_p], model->prop_names[prop_q]);
-    printf("    This equation defines the semantics of the universal until operator using a least fixpoint.\n");
-    printf("    μZ.f(Z) denotes the least fixpoint of the operation f(Z).\n");
+    fprintf(verify_out(), "    This equation defines the semantics of the universal until operator using a least fixpoint.\n");
+    fprintf(verify_out(), "    μZ.f(Z) denotes the least fixpoint of the operation f(Z).\n");
     msg_tag = "Equation 12";
 
     // Get [[P]]
@@ -633,10 +644,9 @@ void verify_equation12(Model* model, int prop_p, int prop_q) {
     StateSet q_result;
     eval_atomic_prop(&q_result, model, prop_q);
     
-    // Calculate [[AP UQ]] using eval_au
+    // Calculate [[AP UQ]] using eval_au (on the quotient with --bisim)
     StateSet au_api;
-    init_state_set(&au_api, model->num_states);
-    eval_au(&au_api, &p_result, &q_result, model);
+    eval_binary_formula(&au_api, eval_au, model, prop_p, prop_q);
     
     // Calculate μZ.([[Q]] ∪ ([[P]] ∩ τAX(Z))) manually using fixed-point iteration
     StateSet z_current, z_next, tau_ax_result, p_and_tau;
@@ -647,12 +657,12 @@ void verify_equation12(Model* model, int prop_p, int prop_q) {
     bool changed = true;
     int iteration = 0;
     
-    printf("  Computing μZ.([[Q]] ∪ ([[P]] ∩ τAX(Z))) as a least fixpoint:\n");
-    printf("  Starting with Z₀ = [[Q]] and iterating:\n");
+    fprintf(verify_out(), "  Computing μZ.([[Q]] ∪ ([[P]] ∩ τAX(Z))) as a least fixpoint:\n");
+    fprintf(verify_out(), "  Starting with Z₀ = [[Q]] and iterating:\n");
     
     while (changed) {
-        printf("    Iteration %d: Z_%d = ", iteration, iteration);
-        print_state_set(&z_current, model, "current Z");
+        fprintf(verify_out(), "    Iteration %d: Z_%d = ", iteration, iteration);
+        fprint_state_set(verify_out(), &z_current, model, "current Z");
         
         // Calculate τAX(Z_current)
         universal_successor(&tau_ax_result, &z_current, model);
@@ -666,8 +676,8 @@ void verify_equation12(Model* model, int prop_p, int prop_q) {
         // Check if fixed point is reached
         changed = !compare_state_sets(&z_current, &z_next);
         if (!changed) {
-            printf("    Next Iteration %d: Z_%d = ", iteration, iteration);
-            print_state_set(&z_next, model, "next Z");
+            fprintf(verify_out(), "    Next Iteration %d: Z_%d = ", iteration, iteration);
+            fprint_state_set(verify_out(), &z_next, model, "next Z");
         }
         
         // Update Z for next iteration
@@ -675,10 +685,10 @@ void verify_equation12(Model* model, int prop_p, int prop_q) {
         iteration++;
     }
     
-    printf("    Fixed point reached at iteration %d\n", iteration-1);
+    fprintf(verify_out(), "    Fixed point reached at iteration %d\n", iteration-1);
     
     // Alternative calculation: A[P U Q] = ¬(E[¬Q U (¬P ∧ ¬Q)] ∨ EG ¬Q)
-    printf("  Alternative calculation: A[P U Q] = ¬(E[¬Q U (¬P ∧ ¬Q)] ∨ EG ¬Q)\n");
+    fprintf(verify_out(), "  Alternative calculation: A[P U Q] = ¬(E[¬Q U (¬P ∧ ¬Q)] ∨ EG ¬Q)\n");
     
     // Calculate ¬P and ¬Q
     StateSet not_p, not_q;
@@ -707,16 +717,17 @@ void verify_equation12(Model* model, int prop_p, int prop_q) {
     
     // Compare with AU P Q calculated using fixpoint
     bool dual_equal = compare_state_sets(&not_disjunction, &z_current);
-    printf("  A[P U Q] = ¬(E[¬Q U (¬P ∧ ¬Q)] ∨ EG ¬Q): %s\n", dual_equal ? "YES" : "NO");
+    fprintf(verify_out(), "  A[P U Q] = ¬(E[¬Q U (¬P ∧ ¬Q)] ∨ EG ¬Q): %s\n", dual_equal ? "YES" : "NO");
     
     // Compare results with API
     bool equal = compare_state_sets(&au_api, &z_current);
-    printf("  Computed [[AP UQ]] = ");
-    print_state_set(&au_api, model, "AU");
-    printf("  Manually computed μZ.([[Q]] ∪ ([[P]] ∩ τAX(Z))) = ");
-    print_state_set(&z_current, model, "fixed point");
-    printf("  Equation holds: %s\n", equal ? "YES" : "NO");
+    fprintf(verify_out(), "  Computed [[AP UQ]] = ");
+    fprint_state_set(verify_out(), &au_api, model, "AU");
+    fprintf(verify_out(), "  Manually computed μZ.([[Q]] ∪ ([[P]] ∩ τAX(Z))) = ");
+    fprint_state_set(verify_out(), &z_current, model, "fixed point");
+    fprintf(verify_out(), "  Equation holds: %s\n", equal ? "YES" : "NO");
+    report_result(12, prop_p, prop_q, &au_api, &z_current, equal);
     if (!equal) {
-        printf(" [ERROR] %s not holds\n", msg_tag);
+        fprintf(verify_out(), " [ERROR] %s not holds\n", msg_tag);
     }
 }
@@ -2,13 +2,15 @@
 #define CTL_API_H
 
 #include <stdbool.h>
+#include <stdio.h>
 
 // Maximum number of states and atomic propositions
 #define MAX_STATES 1000
 #define MAX_PROPS 100
 #define MAX_TRANSITIONS 50
 #define MAX_FORMULA_LEN 1024
-#define MAX_TOKEN_LEN 64
+#define MAX_FAIRNESS 8
+#define PROP_TABLE_SIZE 256   // Slots of the proposition name table: a power of two above 2 * MAX_PROPS
 
 // Structure for representing a state
 typedef struct {
@@ -18,19 +20,225 @@ typedef struct {
     int transitions[MAX_TRANSITIONS];  // IDs of successor states
 } state;
 
+// Structure for representing a set of states
+typedef struct {
+    bool members[MAX_STATES];
+    int size;
+} state_set;
+
+// Containers of a compact state set
+typedef enum {
+    CTL_SET_ARRAY,                    // Sorted state IDs
+    CTL_SET_RUNS,                     // First and last ID of each run of consecutive states
+    CTL_SET_BITMAP                    // One bit per state
+} ctl_container;
+
+// State set in whichever container is smallest (ctl_compact.c); one
+// allocation, freed with free()
+typedef struct {
+    ctl_container container;
+    int size;                         // Number of states in the set
+    int length;                       // IDs (array), runs or 64-bit words (bitmap)
+    unsigned short* ids;              // Array and runs
+    unsigned long long* words;        // Bitmap
+} ctl_compact_set;
+
 // Structure for representing a Kripke structure (model)
 typedef struct {
     state states[MAX_STATES];
     int num_states;
     int num_props;
     char* prop_names[MAX_PROPS];  // Names of atomic propositions
+    int prop_table[PROP_TABLE_SIZE]; // Name hash table (open addressing): proposition ID or -1
+    bool initial[MAX_STATES];     // Initial states (state 0 if none is declared)
+    int* pred_start;              // Predecessor index: predecessors of s are
+    int* pred_list;               //   pred_list[pred_start[s] .. pred_start[s + 1] - 1]
+    int num_fairness;             // Fair paths visit every fairness set infinitely often
+    state_set fairness[MAX_FAIRNESS];
+    long edges_scanned;           // Work counters the kernels add to: transitions looked at,
+    long iterations;              //   sweep rounds and states taken off worklists
 } model;
 
-// Structure for representing a set of states
+// Cone-of-influence reduction of a model for a set of formulas
 typedef struct {
-    bool members[MAX_STATES];
-    int size;
-} state_set;
+    model* reduced;                   // Reachable states and used propositions only (NULL if
+                                      //   every state is reachable)
+    int num_original_states;
+    int original_state[MAX_STATES];   // Original ID of each reduced state
+    int reduced_state[MAX_STATES];    // Reduced ID of each original state (-1 if dropped)
+} ctl_reduction;
+
+// Per-state record of a fixpoint computation, for witness extraction
+typedef struct {
+    int num_states;
+    bool complete;                    // Every state with a path has it (not just the states an
+                                      //   early-exit search got to)
+    int layer[MAX_STATES];            // Round in which the state was added (-1 if never)
+    int next[MAX_STATES];             // Successor toward the target or along the cycle (-1 if none)
+} ctl_trace;
+
+// A witness or counterexample path; a lasso if loop_start >= 0
+typedef struct {
+    int length;
+    int states[MAX_STATES];
+    int loop_start;                   // Index the last state loops back to
+} ctl_path;
+
+// Bounded model checking: temporal operators a witness can be searched for
+typedef enum {
+    CTL_BMC_EF,
+    CTL_BMC_EU,
+    CTL_BMC_EG
+} ctl_bmc_operator;
+
+typedef enum {
+    CTL_BMC_WITNESS,                  // A witness path was found
+    CTL_BMC_NO_WITNESS,               // The bound covered every path: none exists
+    CTL_BMC_UNKNOWN,                  // No witness up to a bound below completeness
+    CTL_BMC_UNSUPPORTED               // Not a query the bounded engine handles
+} ctl_bmc_result;
+
+// Engines for initial-state checks
+typedef enum {
+    CTL_ENGINE_EXPLICIT,              // Fixpoint computation over state sets
+    CTL_ENGINE_BMC,                   // SAT-based bounded model checking
+    CTL_ENGINE_IC3                    // IC3 / property-directed reachability (AG only)
+} ctl_engine;
+
+// IC3 answers for AG P
+typedef enum {
+    CTL_IC3_HOLDS,
+    CTL_IC3_VIOLATED,
+    CTL_IC3_FAILED
+} ctl_ic3_result;
+
+typedef struct {
+    int num_frames;                   // Frames opened
+    int num_clauses;                  // Clauses of the inductive invariant (holds)
+    state_set invariant;              // States admitted by the invariant (holds)
+    ctl_path counterexample;          // Initial state to a ¬P state (violated)
+} ctl_ic3_report;
+
+// Operators of a compiled formula
+typedef enum {
+    CTL_OP_TRUE,
+    CTL_OP_FALSE,
+    CTL_OP_PROP,
+    CTL_OP_NOT,
+    CTL_OP_AND,
+    CTL_OP_OR,
+    CTL_OP_IMPLIES,
+    CTL_OP_IFF,
+    CTL_OP_EX,
+    CTL_OP_AX,
+    CTL_OP_EF,
+    CTL_OP_AF,
+    CTL_OP_EG,
+    CTL_OP_AG,
+    CTL_OP_EU,
+    CTL_OP_AU,
+    CTL_OP_EW,
+    CTL_OP_AW,
+    CTL_OP_ER,
+    CTL_OP_AR
+} ctl_op;
+
+// Algorithms the planner chooses between for a node
+typedef enum {
+    CTL_ALG_DIRECT,                   // The operator's only kernel
+    CTL_ALG_SWEEP,                    // Rounds over all transitions until nothing changes
+    CTL_ALG_WORKLIST,                 // One backward pass over the predecessor index
+    CTL_ALG_DUAL_SWEEP,               // Complement of the dual operator, by rounds
+    CTL_ALG_DUAL_WORKLIST,            // Complement of the dual operator, by a backward pass
+    CTL_ALG_FAIR                      // Fair kernel (the model has fairness constraints)
+} ctl_algorithm;
+
+// A node of a compiled formula; operands are earlier nodes of the same plan
+typedef struct {
+    ctl_op op;
+    int prop_id;                      // Proposition (CTL_OP_PROP)
+    int left;                         // Operands (-1 if unused)
+    int right;
+    ctl_algorithm algorithm;          // Chosen by the planner when the node is added
+    double density;                   // Estimated fraction of states satisfying the node
+    double cost;                      // Estimated work of the node's own kernel
+    int depth;                        // Nodes on the longest operand chain down to a leaf
+} ctl_plan_node;
+
+// What evaluating a node took, for EXPLAIN ANALYZE
+typedef struct {
+    double seconds;                   // The node's own kernel, operands excluded
+    long iterations;                  // Sweep rounds and worklist states (model counters)
+    long edges_scanned;
+    bool from_cache;                  // Read from the result cache instead of evaluated
+} ctl_node_stats;
+
+// A cached satisfaction set and its canonical formula
+typedef struct {
+    char* formula;
+    ctl_compact_set* set;
+} ctl_cache_entry;
+
+// Satisfaction sets of one model kept on disk between runs (ctl_cache.c)
+typedef struct {
+    char* path;                       // <directory>/<model fingerprint>.cache
+    int num_states;
+    int num_entries;
+    int num_loaded;                   // Entries read from the file; the rest are new
+    int capacity;
+    ctl_cache_entry* entries;
+    int* table;                       // Hash table of entry IDs by formula (-1 if empty)
+    int table_size;
+    int hits;
+    int misses;
+} ctl_cache;
+
+// Formulas compiled against one model. Identical subformulas share a node,
+// also across formulas, and each node's satisfaction set is computed once;
+// the model must not change while the plan holds results.
+typedef struct {
+    model* model;
+    bool simplify;                    // Rewrite nodes with CTL identities as they are added
+    int num_fixpoints;                // Fixpoints computed so far (EF, AF, EG, AG and the untils)
+    int num_edges;                    // Model statistics for the planner
+    int depth;                        // Rounds of a breadth-first search from the initial states
+    bool index_planned;               // A chosen algorithm already builds the predecessor index
+    int num_nodes;
+    int capacity;
+    ctl_plan_node* nodes;
+    ctl_compact_set** results;        // Satisfaction set of each node (NULL until evaluated)
+    ctl_node_stats* stats;            // Filled in when the node is evaluated
+    int* table;                       // Hash table of node IDs (-1 if empty)
+    int table_size;
+    ctl_cache* cache;                 // Fixpoint results across runs (NULL for none)
+    bool keep_traces;                 // Keep the paths initial-state checks come across
+    ctl_trace** traces;               // Path trace of each EF, EU, EG, AF, AG node (NULL if none yet)
+} ctl_plan;
+
+// Deepest operator nesting (and longest operand chain) a formula may have,
+// which bounds the recursion of the parser and of everything walking a plan
+#define CTL_MAX_FORMULA_DEPTH 1000
+
+// Why a formula did not compile
+typedef struct {
+    int position;                     // Offset of the offending token in the formula (-1 if none)
+    char message[128];
+} ctl_parse_error;
+
+// A named property of a property file
+typedef struct {
+    char* name;
+    char* formula;
+    int line;                         // Line where the property starts
+    int root;                         // Compiled formula (plan node), -1 if invalid
+    ctl_parse_error error;            // Why the formula is invalid
+} ctl_property;
+
+typedef struct {
+    int num_properties;
+    int capacity;
+    ctl_property* properties;
+} ctl_property_list;
 
 // API Functions
 
@@ -43,6 +251,7 @@ int ctl_add_proposition(model* model, const char* prop_name);
 void ctl_set_proposition_true(model* model, int state_id, int prop_id);
 void ctl_set_proposition_false(model* model, int state_id, int prop_id);
 int ctl_get_proposition_id(model* model, const char* prop_name);
+void ctl_set_initial_state(model* model, int state_id);
 
 // State set operations
 void ctl_init_state_set(state_set* set, int num_states);
@@ -53,6 +262,18 @@ void ctl_intersect_state_sets(state_set* result, state_set* set1, state_set* set
 void ctl_union_state_sets(state_set* result, state_set* set1, state_set* set2);
 void ctl_copy_state_set(state_set* dest, state_set* src);
 
+// Compact state sets (results are new sets)
+ctl_compact_set* ctl_compress_state_set(state_set* set, int num_states);
+void ctl_decompress_state_set(state_set* result, ctl_compact_set* set, int num_states);
+ctl_compact_set* ctl_compact_set_from_runs(const unsigned short* runs, int num_runs, int num_states);
+int ctl_compact_set_runs(ctl_compact_set* set, int num_states, unsigned short* runs);
+ctl_compact_set* ctl_copy_compact_set(ctl_compact_set* set);
+size_t ctl_compact_set_bytes(ctl_compact_set* set);
+bool ctl_compact_set_contains(ctl_compact_set* set, int state_id);
+ctl_compact_set* ctl_compact_complement(ctl_compact_set* set, int num_states);
+ctl_compact_set* ctl_compact_union(ctl_compact_set* set1, ctl_compact_set* set2, int num_states);
+ctl_compact_set* ctl_compact_intersect(ctl_compact_set* set1, ctl_compact_set* set2, int num_states);
+
 // Basic CTL operators
 void ctl_eval_atomic_prop(state_set* result, model* model, int prop_id);
 void ctl_eval_atomic_prop_by_name(state_set* result, model* model, const char* prop_name);
@@ -64,11 +285,92 @@ void ctl_eval_eg(state_set* result, state_set* prop_p, model* model);
 void ctl_eval_ag(state_set* result, state_set* prop_p, model* model);             // AG
 void ctl_eval_eu(state_set* result, state_set* prop_p, state_set* prop_q, model* model); // EU
 void ctl_eval_au(state_set* result, state_set* prop_p, state_set* prop_q, model* model); // AU
+void ctl_eval_ew(state_set* result, state_set* prop_p, state_set* prop_q, model* model); // EW (weak until)
+void ctl_eval_aw(state_set* result, state_set* prop_p, state_set* prop_q, model* model); // AW
+void ctl_eval_er(state_set* result, state_set* prop_p, state_set* prop_q, model* model); // ER (release)
+void ctl_eval_ar(state_set* result, state_set* prop_p, state_set* prop_q, model* model); // AR
+void ctl_eval_eu_backward(state_set* result, state_set* prop_p, state_set* prop_q, model* model); // EU via predecessors
+void ctl_eval_eu_traced(state_set* result, state_set* prop_p, state_set* prop_q, model* model, ctl_trace* trace);
+void ctl_eval_eg_traced(state_set* result, state_set* prop_p, model* model, ctl_trace* trace);
+
+// Fairness constraints and fair CTL operators (identical to the plain
+// operators while the model has no fairness constraints)
+int ctl_add_fairness_constraint(model* model, state_set* states);
+int ctl_add_fairness_formula(model* model, const char* formula);
+void ctl_clear_fairness_constraints(model* model);
+void ctl_eval_fair_states(state_set* result, model* model);
+void ctl_eval_fair_ex(state_set* result, state_set* prop_p, model* model);
+void ctl_eval_fair_ax(state_set* result, state_set* prop_p, model* model);
+void ctl_eval_fair_ef(state_set* result, state_set* prop_p, model* model);
+void ctl_eval_fair_af(state_set* result, state_set* prop_p, model* model);
+void ctl_eval_fair_eg(state_set* result, state_set* prop_p, model* model);
+void ctl_eval_fair_ag(state_set* result, state_set* prop_p, model* model);
+void ctl_eval_fair_eu(state_set* result, state_set* prop_p, state_set* prop_q, model* model);
+void ctl_eval_fair_au(state_set* result, state_set* prop_p, state_set* prop_q, model* model);
+void ctl_eval_fair_ew(state_set* result, state_set* prop_p, state_set* prop_q, model* model);
+void ctl_eval_fair_aw(state_set* result, state_set* prop_p, state_set* prop_q, model* model);
+void ctl_eval_fair_er(state_set* result, state_set* prop_p, state_set* prop_q, model* model);
+void ctl_eval_fair_ar(state_set* result, state_set* prop_p, state_set* prop_q, model* model);
 
 // Formula parsing
-void ctl_parse_formula(const char* formula, state_set* result, model* model);
+bool ctl_parse_formula(const char* formula, state_set* result, model* model);
 bool ctl_check_formula_at_state(const char* formula, model* model, int state_id);
 bool ctl_check_state_in_set(int state_id, state_set* set);
+bool ctl_check_formula_initial(const char* formula, model* model);
+
+// Compiled formulas (shared subformulas, memoized satisfaction sets)
+ctl_plan* ctl_create_plan(model* model);
+void ctl_free_plan(ctl_plan* plan);
+int ctl_plan_add_node(ctl_plan* plan, ctl_op op, int left, int right, int prop_id);
+int ctl_plan_make_node(ctl_plan* plan, ctl_op op, int left, int right, int prop_id);
+bool ctl_is_fixpoint_op(ctl_op op);
+void ctl_explain_plan(ctl_plan* plan, int node, FILE* out);
+void ctl_analyze_plan(ctl_plan* plan, int node, FILE* out);
+int ctl_compile_formula(ctl_plan* plan, const char* formula, ctl_parse_error* error);
+void ctl_print_parse_error(const char* formula, ctl_parse_error* error, FILE* out);
+ctl_compact_set* ctl_eval_plan_node(ctl_plan* plan, int node);
+bool ctl_plan_holds_initially(ctl_plan* plan, int node, int* failing_state);
+char* ctl_canonical_formula(ctl_plan* plan, int node);
+
+// Persistent result cache, keyed by model fingerprint and canonical formula
+unsigned long long ctl_model_fingerprint(model* model);
+ctl_cache* ctl_open_cache(const char* directory, model* model);
+bool ctl_close_cache(ctl_cache* cache);
+ctl_compact_set* ctl_cache_lookup(ctl_cache* cache, const char* formula);
+void ctl_cache_store(ctl_cache* cache, const char* formula, ctl_compact_set* set);
+
+// Model and property files, and batch checking of a property list
+model* ctl_load_model(const char* path);
+bool ctl_load_properties(ctl_property_list* list, const char* path);
+void ctl_free_properties(ctl_property_list* list);
+bool ctl_reduce_for_properties(ctl_reduction* reduction, ctl_property_list* list, model* model);
+int ctl_check_properties(ctl_property_list* list, ctl_plan* plan, ctl_reduction* reduction, FILE* out,
+                         int* num_invalid);
+
+// Witnesses (EF, EU, EG) and counterexamples (AG, AF) as paths from a state
+bool ctl_extract_path(ctl_trace* trace, int state_id, ctl_path* path);
+bool ctl_plan_find_path(ctl_plan* plan, int node, int state_id, ctl_path* path, bool counterexample);
+bool ctl_find_witness(const char* formula, model* model, int state_id, ctl_path* path);
+bool ctl_find_counterexample(const char* formula, model* model, int state_id, ctl_path* path);
+void ctl_print_path(ctl_path* path, model* model);
+
+// Bounded model checking (max_bound >= num_states - 1 makes the answer definite)
+ctl_bmc_result ctl_bmc_search(model* model, ctl_bmc_operator op, state_set* prop_p, state_set* prop_q,
+                              int state_id, int max_bound, ctl_path* path);
+bool ctl_check_formula_initial_engine(const char* formula, model* model, ctl_engine engine);
+
+// IC3 / property-directed reachability for AG P (report may be NULL)
+ctl_ic3_result ctl_ic3_check(model* model, state_set* prop_p, ctl_ic3_report* report);
+
+// Cone-of-influence reduction (from_state < 0 starts from the initial states)
+void ctl_formula_propositions(const char* formula, model* model, bool* used);
+bool ctl_reduce_model(ctl_reduction* reduction, model* model, const bool* used_props, int from_state);
+void ctl_free_reduction(ctl_reduction* reduction);
+void ctl_expand_state_set(state_set* result, state_set* set, ctl_reduction* reduction);
+void ctl_parse_formula_reduced(const char* formula, state_set* result, model* model, int from_state);
+
+// Differential self-check of the evaluation paths on random models (returns the mismatches)
+int ctl_run_selfcheck(int iterations, unsigned int seed);
 
 // Utility functions
 void ctl_print_model_info(model* model);
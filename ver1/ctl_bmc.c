@@ -0,0 +1,293 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "ctl_api.h"
+#include "ctl_sat.h"
+
+/*
+ * Bounded model checking of EF, EU and EG from one state.
+ *
+ * Step t of a path is encoded in binary (bit variables) plus one indicator
+ * variable per model state, tied to the bits so that exactly one indicator
+ * holds. The transition relation links the indicators of consecutive steps.
+ * A state set S (the evaluated operand of the formula) becomes one variable
+ * per step that holds iff the state at that step is in S. The unrolling
+ * grows one step at a time in a single incremental solver; the formula at
+ * bound k is posed as assumptions, so nothing is retracted.
+ *
+ * A shortest EF/EU witness visits no state twice, and a shortest EG lasso
+ * closes on step k + 1 with k <= n - 1, so searching up to bound n - 1
+ * decides the formula on an n-state model.
+ */
+
+typedef struct {
+    sat_solver* solver;
+    model* model;
+    int num_bits;
+    int max_steps;
+    int num_steps;                // Steps encoded so far
+    int* bit_var;                 // bit_var[t * num_bits + b]
+    int* state_var;               // state_var[t * num_states + s]
+    state_set* sets[2];           // Operand sets
+    int* set_var[2];              // set_var[i][t], 0 until defined
+    int* loop_var;                // loop_var[k]: step k + 1 repeats an earlier step
+} bmc_unrolling;
+
+static bool bmc_init(bmc_unrolling* u, model* model, int max_steps, state_set* first, state_set* second) {
+    u->solver = sat_new();
+    u->model = model;
+    u->num_bits = 1;
+    while ((1 << u->num_bits) < model->num_states) u->num_bits++;
+    u->max_steps = max_steps;
+    u->num_steps = 0;
+    u->bit_var = malloc((size_t)max_steps * u->num_bits * sizeof(int));
+    u->state_var = malloc((size_t)max_steps * model->num_states * sizeof(int));
+    u->sets[0] = first;
+    u->sets[1] = second;
+    u->set_var[0] = calloc(max_steps, sizeof(int));
+    u->set_var[1] = calloc(max_steps, sizeof(int));
+    u->loop_var = calloc(max_steps, sizeof(int));
+
+    if (u->solver == NULL || u->bit_var == NULL || u->state_var == NULL ||
+        u->set_var[0] == NULL || u->set_var[1] == NULL || u->loop_var == NULL) {
+        fprintf(stderr, "Error: Memory allocation failed for bounded model checking\n");
+        return false;
+    }
+    return true;
+}
+
+static void bmc_free(bmc_unrolling* u) {
+    sat_free(u->solver);
+    free(u->bit_var);
+    free(u->state_var);
+    free(u->set_var[0]);
+    free(u->set_var[1]);
+    free(u->loop_var);
+}
+
+// Encode one more step: its state variables and the transition into it
+static void bmc_add_step(bmc_unrolling* u) {
+    int t = u->num_steps++;
+    int n = u->model->num_states;
+    int* bits = &u->bit_var[t * u->num_bits];
+    int* states = &u->state_var[t * n];
+    int clause[MAX_TRANSITIONS + 64];
+
+    for (int b = 0; b < u->num_bits; b++) {
+        bits[b] = sat_new_var(u->solver);
+    }
+
+    // states[s] <-> (bits == s)
+    for (int s = 0; s < n; s++) {
+        states[s] = sat_new_var(u->solver);
+        for (int b = 0; b < u->num_bits; b++) {
+            clause[0] = -states[s];
+            clause[1] = ((s >> b) & 1) ? bits[b] : -bits[b];
+            sat_add_clause(u->solver, clause, 2);
+        }
+        for (int b = 0; b < u->num_bits; b++) {
+            clause[b] = ((s >> b) & 1) ? -bits[b] : bits[b];
+        }
+        clause[u->num_bits] = states[s];
+        sat_add_clause(u->solver, clause, u->num_bits + 1);
+    }
+
+    // Codes beyond the last state are not states
+    for (int code = n; code < (1 << u->num_bits); code++) {
+        for (int b = 0; b < u->num_bits; b++) {
+            clause[b] = ((code >> b) & 1) ? -bits[b] : bits[b];
+        }
+        sat_add_clause(u->solver, clause, u->num_bits);
+    }
+
+    // The state at step t - 1 moves to one of its successors; a deadlock
+    // state stutters, which is harmless for EF/EU and makes a maximal finite
+    // path a lasso for EG (deadlocks satisfy EG P when they satisfy P)
+    if (t > 0) {
+        int* previous = &u->state_var[(t - 1) * n];
+        for (int s = 0; s < n; s++) {
+            state* current_state = &u->model->states[s];
+            clause[0] = -previous[s];
+            if (current_state->num_transitions == 0) {
+                clause[1] = states[s];
+                sat_add_clause(u->solver, clause, 2);
+                continue;
+            }
+            for (int j = 0; j < current_state->num_transitions; j++) {
+                clause[j + 1] = states[current_state->transitions[j]];
+            }
+            sat_add_clause(u->solver, clause, current_state->num_transitions + 1);
+        }
+    }
+}
+
+static void bmc_ensure_steps(bmc_unrolling* u, int steps) {
+    while (u->num_steps < steps) {
+        bmc_add_step(u);
+    }
+}
+
+// Define v <-> (l1 ∨ ... ∨ ln)
+static int define_or(sat_solver* solver, const int* lits, int num_lits) {
+    int v = sat_new_var(solver);
+    int* clause = malloc((num_lits + 1) * sizeof(int));
+    if (clause == NULL) {
+        fprintf(stderr, "Error: Memory allocation failed for bounded model checking\n");
+        exit(1);
+    }
+
+    for (int i = 0; i < num_lits; i++) {
+        int pair[2] = { -lits[i], v };
+        sat_add_clause(solver, pair, 2);
+        clause[i] = lits[i];
+    }
+    clause[num_lits] = -v;
+    sat_add_clause(solver, clause, num_lits + 1);
+    free(clause);
+    return v;
+}
+
+// Variable that holds iff the state at step t is in operand set `which`
+static int bmc_set_var(bmc_unrolling* u, int which, int t) {
+    if (u->set_var[which][t] != 0) {
+        return u->set_var[which][t];
+    }
+
+    int n = u->model->num_states;
+    int* members = malloc(n * sizeof(int));
+    int count = 0;
+    for (int s = 0; s < n; s++) {
+        if (u->sets[which]->members[s]) {
+            members[count++] = u->state_var[t * n + s];
+        }
+    }
+    u->set_var[which][t] = define_or(u->solver, members, count);
+    free(members);
+    return u->set_var[which][t];
+}
+
+// Variable that holds iff the state at step k + 1 equals the state at some
+// step l <= k (the path closes a lasso)
+static int bmc_loop_var(bmc_unrolling* u, int k) {
+    if (u->loop_var[k] != 0) {
+        return u->loop_var[k];
+    }
+
+    int nb = u->num_bits;
+    int* options = malloc((k + 1) * sizeof(int));
+    int* equal_bits = malloc(nb * sizeof(int));
+    int count = 0;
+
+    for (int l = 0; l <= k; l++) {
+        for (int b = 0; b < nb; b++) {
+            int x = u->bit_var[(k + 1) * nb + b];
+            int y = u->bit_var[l * nb + b];
+            int e = sat_new_var(u->solver);
+            int c1[3] = { -e, -x, y }, c2[3] = { -e, x, -y };
+            int c3[3] = { e, x, y }, c4[3] = { e, -x, -y };
+            sat_add_clause(u->solver, c1, 3);
+            sat_add_clause(u->solver, c2, 3);
+            sat_add_clause(u->solver, c3, 3);
+            sat_add_clause(u->solver, c4, 3);
+            equal_bits[b] = -e;
+        }
+        // same <-> all bits equal, i.e. ¬same <-> some bit differs
+        options[count++] = -define_or(u->solver, equal_bits, nb);
+    }
+
+    u->loop_var[k] = define_or(u->solver, options, count);
+    free(options);
+    free(equal_bits);
+    return u->loop_var[k];
+}
+
+// State at step t in the satisfying assignment
+static int bmc_state_at(bmc_unrolling* u, int t) {
+    int n = u->model->num_states;
+    for (int s = 0; s < n; s++) {
+        if (sat_value(u->solver, u->state_var[t * n + s])) {
+            return s;
+        }
+    }
+    return -1;
+}
+
+// Search for a witness of EF Q (prop_p NULL), E[P U Q] or EG P (op CTL_BMC_EG,
+// prop_q unused) starting at state_id, with paths of up to max_bound steps
+ctl_bmc_result ctl_bmc_search(model* model, ctl_bmc_operator op, state_set* prop_p, state_set* prop_q,
+                              int state_id, int max_bound, ctl_path* path) {
+    bmc_unrolling u;
+    ctl_bmc_result result = CTL_BMC_UNKNOWN;
+
+    path->length = 0;
+    path->loop_start = -1;
+    if (state_id < 0 || state_id >= model->num_states || model->num_states == 0) {
+        return CTL_BMC_UNSUPPORTED;
+    }
+    if (max_bound > model->num_states - 1) {
+        max_bound = model->num_states - 1;
+    }
+
+    state_set* first = (op == CTL_BMC_EG) ? prop_p : prop_q;
+    state_set* second = (op == CTL_BMC_EU) ? prop_p : NULL;
+    if (!bmc_init(&u, model, max_bound + 2, first, second)) {
+        bmc_free(&u);
+        return CTL_BMC_UNSUPPORTED;
+    }
+
+    int* assumptions = malloc((max_bound + 3) * sizeof(int));
+    if (assumptions == NULL) {
+        bmc_free(&u);
+        return CTL_BMC_UNSUPPORTED;
+    }
+
+    for (int k = 0; k <= max_bound; k++) {
+        int count = 0;
+        bmc_ensure_steps(&u, op == CTL_BMC_EG ? k + 2 : k + 1);
+        assumptions[count++] = u.state_var[state_id];
+
+        switch (op) {
+            case CTL_BMC_EF:
+                assumptions[count++] = bmc_set_var(&u, 0, k);
+                break;
+            case CTL_BMC_EU:
+                for (int t = 0; t < k; t++) {
+                    assumptions[count++] = bmc_set_var(&u, 1, t);
+                }
+                assumptions[count++] = bmc_set_var(&u, 0, k);
+                break;
+            case CTL_BMC_EG:
+                for (int t = 0; t <= k; t++) {
+                    assumptions[count++] = bmc_set_var(&u, 0, t);
+                }
+                assumptions[count++] = bmc_loop_var(&u, k);
+                break;
+        }
+
+        if (sat_solve(u.solver, assumptions, count) == SAT_SATISFIABLE) {
+            for (int t = 0; t <= k; t++) {
+                path->states[path->length++] = bmc_state_at(&u, t);
+            }
+            if (op == CTL_BMC_EG && model->states[path->states[k]].num_transitions > 0) {
+                // Close the lasso at the first step equal to step k + 1
+                int repeated = bmc_state_at(&u, k + 1);
+                for (int l = 0; l <= k; l++) {
+                    if (path->states[l] == repeated) {
+                        path->loop_start = l;
+                        break;
+                    }
+                }
+            }
+            result = CTL_BMC_WITNESS;
+            break;
+        }
+    }
+
+    // Bound n - 1 covers every shortest witness, so no witness up to it is a definite answer
+    if (result != CTL_BMC_WITNESS && max_bound >= model->num_states - 1) {
+        result = CTL_BMC_NO_WITNESS;
+    }
+
+    free(assumptions);
+    bmc_free(&u);
+    return result;
+}
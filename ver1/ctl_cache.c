@@ -0,0 +1,343 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "ctl_api.h"
+
+/*
+ * Persistent result cache.
+ *
+ * Satisfaction sets are stored per model, in a file of the cache directory
+ * named after the model's fingerprint: a hash of its transitions (in CSR
+ * order), its labels and proposition names, and its fairness constraints.
+ * Any change to the model therefore selects a different file, and entries
+ * never need invalidating. Inside the file each line maps a canonical
+ * formula (ctl_canonical_formula) to its satisfaction set as runs of state
+ * IDs, followed by a checksum of the line so far:
+ *
+ *     # ctl result cache
+ *     states 9
+ *     EF(p1c)<TAB>0-3,5,7-8<TAB>1c2b9e04
+ *
+ * The file is read whole when the cache is opened, into compact sets, so a
+ * large cache mostly costs a few bytes per entry besides its formula text.
+ * Lines that are cut short or damaged are dropped. If the run added
+ * entries, the whole file is written anew when the cache is closed, to a
+ * temporary file that then replaces it, so a crash or a concurrent run
+ * never leaves a partly written file behind.
+ */
+
+#define CACHE_INITIAL_CAPACITY 64
+
+typedef unsigned long long fingerprint;
+
+static fingerprint hash_bytes(fingerprint hash, const void* data, size_t length) {
+    const unsigned char* bytes = data;
+    for (size_t i = 0; i < length; i++) {
+        hash = (hash ^ bytes[i]) * 1099511628211ull;
+    }
+    return hash;
+}
+
+static fingerprint hash_int(fingerprint hash, int value) {
+    return hash_bytes(hash, &value, sizeof(value));
+}
+
+// Fingerprint of everything a satisfaction set depends on (the initial
+// states do not matter)
+unsigned long long ctl_model_fingerprint(model* model) {
+    fingerprint hash = 14695981039346656037ull;
+
+    hash = hash_int(hash, model->num_states);
+    hash = hash_int(hash, model->num_props);
+    for (int i = 0; i < model->num_props; i++) {
+        hash = hash_bytes(hash, model->prop_names[i], strlen(model->prop_names[i]) + 1);
+    }
+    for (int i = 0; i < model->num_states; i++) {
+        state* current_state = &model->states[i];
+        hash = hash_int(hash, current_state->num_transitions);
+        hash = hash_bytes(hash, current_state->transitions, current_state->num_transitions * sizeof(int));
+        hash = hash_bytes(hash, current_state->atomic_props, model->num_props * sizeof(bool));
+    }
+    hash = hash_int(hash, model->num_fairness);
+    for (int c = 0; c < model->num_fairness; c++) {
+        hash = hash_bytes(hash, model->fairness[c].members, model->num_states * sizeof(bool));
+    }
+    return hash;
+}
+
+static unsigned int hash_key(const char* key) {
+    unsigned int hash = 2166136261u;
+    for (; *key != '\0'; key++) {
+        hash = (hash ^ (unsigned char)*key) * 16777619u;
+    }
+    return hash;
+}
+
+// Slot of the entry for a formula, or the empty slot where it would go
+static int* entry_slot(ctl_cache* cache, const char* formula) {
+    for (unsigned int slot = hash_key(formula);; slot++) {
+        int* entry = &cache->table[slot & (cache->table_size - 1)];
+        if (*entry < 0 || strcmp(cache->entries[*entry].formula, formula) == 0) {
+            return entry;
+        }
+    }
+}
+
+static bool add_entry(ctl_cache* cache, char* formula, ctl_compact_set* set) {
+    if (cache->num_entries == cache->capacity) {
+        int capacity = 2 * cache->capacity;
+        ctl_cache_entry* entries = realloc(cache->entries, capacity * sizeof(ctl_cache_entry));
+        int* table = malloc(2 * capacity * sizeof(int));
+        if (entries != NULL) cache->entries = entries;
+        if (entries == NULL || table == NULL) {
+            free(table);
+            return false;
+        }
+        free(cache->table);
+        cache->table = table;
+        cache->table_size = 2 * capacity;
+        cache->capacity = capacity;
+        for (int i = 0; i < cache->table_size; i++) {
+            cache->table[i] = -1;
+        }
+        for (int i = 0; i < cache->num_entries; i++) {
+            *entry_slot(cache, cache->entries[i].formula) = i;
+        }
+    }
+
+    int* slot = entry_slot(cache, formula);
+    if (*slot >= 0) {
+        return false;
+    }
+    *slot = cache->num_entries;
+    cache->entries[cache->num_entries].formula = formula;
+    cache->entries[cache->num_entries].set = set;
+    cache->num_entries++;
+    return true;
+}
+
+// Longest text of write_runs: at most (MAX_STATES + 1) / 2 runs "a-b,"
+#define RUNS_TEXT_SIZE (4 * MAX_STATES + 16)
+
+// Write a set as runs "a-b" or "a", separated by commas (nothing if empty)
+static void write_runs(char* text, ctl_compact_set* set, int num_states) {
+    unsigned short runs[MAX_STATES + 1];
+    int num_runs = ctl_compact_set_runs(set, num_states, runs);
+    *text = '\0';
+    for (int r = 0; r < num_runs; r++) {
+        if (runs[2 * r + 1] > runs[2 * r]) {
+            text += sprintf(text, "%s%d-%d", (r > 0) ? "," : "", runs[2 * r], runs[2 * r + 1]);
+        } else {
+            text += sprintf(text, "%s%d", (r > 0) ? "," : "", runs[2 * r]);
+        }
+    }
+}
+
+// Parse runs written by write_runs; NULL unless they are ascending, apart
+// and within the model
+static ctl_compact_set* read_runs(const char* text, int num_states) {
+    unsigned short runs[MAX_STATES + 1];
+    int num_runs = 0;
+    long next = 0;
+    while (*text != '\0') {
+        char* end;
+        long first = strtol(text, &end, 10);
+        long last = first;
+        if (*end == '-') {
+            last = strtol(end + 1, &end, 10);
+        }
+        if (end == text || first < next || last < first || last >= num_states || (*end != ',' && *end != '\0')) {
+            return NULL;
+        }
+        runs[2 * num_runs] = (unsigned short)first;
+        runs[2 * num_runs + 1] = (unsigned short)last;
+        num_runs++;
+        next = last + 2;
+        text = (*end == ',') ? end + 1 : end;
+    }
+    return ctl_compact_set_from_runs(runs, num_runs, num_states);
+}
+
+// Checksum of an entry line, over "<formula><TAB><runs>"
+static unsigned int line_checksum(const char* formula, const char* runs) {
+    unsigned int hash = hash_key(formula);
+    hash = (hash ^ (unsigned char)'\t') * 16777619u;
+    for (; *runs != '\0'; runs++) {
+        hash = (hash ^ (unsigned char)*runs) * 16777619u;
+    }
+    return hash;
+}
+
+// Read the model's cache file, if there is one; entries that do not parse,
+// fail their checksum or lack the final newline are dropped
+static void load_entries(ctl_cache* cache) {
+    FILE* file = fopen(cache->path, "r");
+    if (file == NULL) {
+        return;
+    }
+
+    char* line = NULL;
+    size_t capacity = 0;
+    int length;
+    int states = -1;
+    while ((length = (int)getline(&line, &capacity, file)) > 0) {
+        // A line without a newline was cut short while being written
+        if (line[length - 1] != '\n') break;
+        line[--length] = '\0';
+        if (line[0] == '#' || line[0] == '\0') continue;
+        if (states < 0) {
+            // The header guards against a fingerprint collision in size
+            if (sscanf(line, "states %d", &states) != 1 || states != cache->num_states) break;
+            continue;
+        }
+
+        char* tab = strchr(line, '\t');
+        char* last_tab = strrchr(line, '\t');
+        if (tab == NULL || last_tab == tab) continue;
+        *tab = '\0';
+        *last_tab = '\0';
+        char* end;
+        unsigned long checksum = strtoul(last_tab + 1, &end, 16);
+        if (end == last_tab + 1 || *end != '\0' || checksum != line_checksum(line, tab + 1)) continue;
+        ctl_compact_set* set = read_runs(tab + 1, cache->num_states);
+        if (set == NULL) continue;
+
+        char* formula = strdup(line);
+        if (formula == NULL || !add_entry(cache, formula, set)) {
+            free(formula);
+            free(set);
+        }
+    }
+    free(line);
+    fclose(file);
+}
+
+/* Opening and Closing */
+
+// Open the cache of a model in a directory (created if missing); NULL if
+// the directory cannot be used
+ctl_cache* ctl_open_cache(const char* directory, model* model) {
+    if (mkdir(directory, 0777) != 0 && errno != EEXIST) {
+        fprintf(stderr, "Error: Cannot create cache directory %s\n", directory);
+        return NULL;
+    }
+
+    ctl_cache* cache = malloc(sizeof(ctl_cache));
+    if (cache == NULL) {
+        fprintf(stderr, "Error: Memory allocation failed for cache\n");
+        return NULL;
+    }
+    size_t path_length = strlen(directory) + 32;
+    cache->path = malloc(path_length);
+    cache->num_states = model->num_states;
+    cache->num_entries = 0;
+    cache->num_loaded = 0;
+    cache->capacity = CACHE_INITIAL_CAPACITY;
+    cache->entries = malloc(cache->capacity * sizeof(ctl_cache_entry));
+    cache->table_size = 2 * CACHE_INITIAL_CAPACITY;
+    cache->table = malloc(cache->table_size * sizeof(int));
+    cache->hits = 0;
+    cache->misses = 0;
+    if (cache->path == NULL || cache->entries == NULL || cache->table == NULL) {
+        fprintf(stderr, "Error: Memory allocation failed for cache\n");
+        free(cache->path);
+        free(cache->entries);
+        free(cache->table);
+        free(cache);
+        return NULL;
+    }
+    for (int i = 0; i < cache->table_size; i++) {
+        cache->table[i] = -1;
+    }
+
+    snprintf(cache->path, path_length, "%s/%016llx.cache", directory, ctl_model_fingerprint(model));
+    load_entries(cache);
+    cache->num_loaded = cache->num_entries;
+    return cache;
+}
+
+// Write every entry to a temporary file (named per process, so concurrent
+// runs do not share one) and move it over the cache file; false if it
+// could not be written
+static bool write_entries(ctl_cache* cache) {
+    size_t path_length = strlen(cache->path) + 32;
+    char* temp_path = malloc(path_length);
+    if (temp_path == NULL) {
+        fprintf(stderr, "Error: Memory allocation failed for cache\n");
+        return false;
+    }
+    snprintf(temp_path, path_length, "%s.%ld.tmp", cache->path, (long)getpid());
+
+    FILE* file = fopen(temp_path, "w");
+    if (file == NULL) {
+        fprintf(stderr, "Error: Cannot write cache file %s\n", temp_path);
+        free(temp_path);
+        return false;
+    }
+    char runs[RUNS_TEXT_SIZE];
+    fprintf(file, "# ctl result cache\nstates %d\n", cache->num_states);
+    for (int i = 0; i < cache->num_entries; i++) {
+        write_runs(runs, cache->entries[i].set, cache->num_states);
+        fprintf(file, "%s\t%s\t%08x\n", cache->entries[i].formula, runs,
+                line_checksum(cache->entries[i].formula, runs));
+    }
+
+    bool ok = (fclose(file) == 0);
+    if (ok && rename(temp_path, cache->path) != 0) {
+        ok = false;
+    }
+    if (!ok) {
+        fprintf(stderr, "Error: Cannot write cache file %s\n", cache->path);
+        remove(temp_path);
+    }
+    free(temp_path);
+    return ok;
+}
+
+// Write the cache file if entries were added since the cache was opened,
+// then free the cache; false if the file could not be written
+bool ctl_close_cache(ctl_cache* cache) {
+    if (cache == NULL) return true;
+
+    bool ok = true;
+    if (cache->num_entries > cache->num_loaded) {
+        ok = write_entries(cache);
+    }
+
+    for (int i = 0; i < cache->num_entries; i++) {
+        free(cache->entries[i].formula);
+        free(cache->entries[i].set);
+    }
+    free(cache->entries);
+    free(cache->table);
+    free(cache->path);
+    free(cache);
+    return ok;
+}
+
+/* Lookups */
+
+// A copy of the cached satisfaction set of a canonical formula; NULL if
+// there is none
+ctl_compact_set* ctl_cache_lookup(ctl_cache* cache, const char* formula) {
+    int entry = *entry_slot(cache, formula);
+    if (entry < 0) {
+        cache->misses++;
+        return NULL;
+    }
+    cache->hits++;
+    return ctl_copy_compact_set(cache->entries[entry].set);
+}
+
+// Remember the satisfaction set of a canonical formula
+void ctl_cache_store(ctl_cache* cache, const char* formula, ctl_compact_set* set) {
+    char* key = strdup(formula);
+    ctl_compact_set* copy = ctl_copy_compact_set(set);
+    if (key == NULL || !add_entry(cache, key, copy)) {
+        free(key);
+        free(copy);
+    }
+}
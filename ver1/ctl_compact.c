@@ -0,0 +1,339 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ctl_api.h"
+
+/*
+ * Compact state sets.
+ *
+ * A state_set is a flag per possible state, which the fixpoint kernels want,
+ * but most results kept for later are nearly empty ({2, 4}) or nearly full.
+ * A compact set stores the same states in whichever of three containers is
+ * smallest, as in roaring bitmaps (one container suffices, since state IDs
+ * fit in 16 bits):
+ *
+ *     array   sorted state IDs                  2 bytes per state
+ *     runs    first and last ID of each run     4 bytes per run
+ *     bitmap  one bit per state                 num_states / 8 bytes
+ *
+ * The empty set takes no storage beyond the header; the full set is one run
+ * (4 bytes; an array of the IDs in models of one or two states). Union,
+ * intersection and complement work on the containers directly: on 64-bit
+ * words when a bitmap is involved, otherwise by merging runs (an array is a
+ * list of one-state runs). Every result is repacked into the smallest
+ * container. A compact set is one allocation and is freed with free().
+ */
+
+#define WORD_BITS 64
+#define MAX_WORDS ((MAX_STATES + WORD_BITS - 1) / WORD_BITS)
+#define MAX_RUNS ((MAX_STATES + 1) / 2)
+
+typedef unsigned long long word;
+
+static int num_words(int num_states) {
+    return (num_states + WORD_BITS - 1) / WORD_BITS;
+}
+
+static int count_bits(word bits) {
+    return __builtin_popcountll(bits);
+}
+
+// Index of the lowest set bit (bits must not be 0)
+static int lowest_bit(word bits) {
+    return __builtin_ctzll(bits);
+}
+
+// Set the bits of states first..last
+static void fill_range(word* words, int first, int last) {
+    for (int w = first / WORD_BITS; w <= last / WORD_BITS; w++) {
+        int low = (w == first / WORD_BITS) ? first % WORD_BITS : 0;
+        int high = (w == last / WORD_BITS) ? last % WORD_BITS : WORD_BITS - 1;
+        word mask = (high == WORD_BITS - 1) ? ~(word)0 : ((word)1 << (high + 1)) - 1;
+        words[w] |= mask & ~(((word)1 << low) - 1);
+    }
+}
+
+// Storage behind the header for length IDs (array), runs or words (bitmap)
+static size_t data_bytes(ctl_container container, int length) {
+    if (container == CTL_SET_BITMAP) return length * sizeof(word);
+    if (container == CTL_SET_RUNS) return 2 * length * sizeof(unsigned short);
+    return length * sizeof(unsigned short);
+}
+
+static ctl_compact_set* allocate_set(ctl_container container, int size, int length) {
+    ctl_compact_set* set = malloc(sizeof(ctl_compact_set) + data_bytes(container, length));
+    if (set == NULL) {
+        fprintf(stderr, "Error: Memory allocation failed for state set\n");
+        exit(1);
+    }
+    set->container = container;
+    set->size = size;
+    set->length = length;
+    set->words = (word*)(set + 1);
+    set->ids = (unsigned short*)(set + 1);
+    return set;
+}
+
+// Pack runs (first and last ID of each, ascending and not adjacent) into
+// the smallest container
+static ctl_compact_set* pack_runs(const unsigned short* runs, int num_runs, int num_states) {
+    int size = 0;
+    for (int r = 0; r < num_runs; r++) {
+        size += runs[2 * r + 1] - runs[2 * r] + 1;
+    }
+
+    size_t array_bytes = size * sizeof(unsigned short);
+    size_t run_bytes = 2 * num_runs * sizeof(unsigned short);
+    size_t bitmap_bytes = num_words(num_states) * sizeof(word);
+    ctl_compact_set* set;
+
+    if (array_bytes <= run_bytes && array_bytes <= bitmap_bytes) {
+        set = allocate_set(CTL_SET_ARRAY, size, size);
+        int length = 0;
+        for (int r = 0; r < num_runs; r++) {
+            for (int i = runs[2 * r]; i <= runs[2 * r + 1]; i++) {
+                set->ids[length++] = (unsigned short)i;
+            }
+        }
+    } else if (run_bytes <= bitmap_bytes) {
+        set = allocate_set(CTL_SET_RUNS, size, num_runs);
+        memcpy(set->ids, runs, run_bytes);
+    } else {
+        set = allocate_set(CTL_SET_BITMAP, size, num_words(num_states));
+        memset(set->words, 0, bitmap_bytes);
+        for (int r = 0; r < num_runs; r++) {
+            fill_range(set->words, runs[2 * r], runs[2 * r + 1]);
+        }
+    }
+    return set;
+}
+
+// Append a run, joining it to the previous one if they touch
+static void append_run(unsigned short* runs, int* num_runs, int first, int last) {
+    if (*num_runs > 0 && runs[2 * *num_runs - 1] + 1 >= first) {
+        if (last > runs[2 * *num_runs - 1]) runs[2 * *num_runs - 1] = (unsigned short)last;
+        return;
+    }
+    runs[2 * *num_runs] = (unsigned short)first;
+    runs[2 * *num_runs + 1] = (unsigned short)last;
+    (*num_runs)++;
+}
+
+static int words_to_runs(const word* words, int num_states, unsigned short* runs) {
+    int num_runs = 0;
+    for (int w = 0; w < num_words(num_states); w++) {
+        word bits = words[w];
+        while (bits != 0) {
+            // The lowest run of ones in the word: where it starts, and where
+            // the first zero above it is
+            int first = lowest_bit(bits);
+            word above = ~(bits >> first);
+            int length = (above == 0) ? WORD_BITS : lowest_bit(above);
+            append_run(runs, &num_runs, w * WORD_BITS + first, w * WORD_BITS + first + length - 1);
+            bits = (first + length == WORD_BITS) ? 0 : bits & ~((word)0) << (first + length);
+        }
+    }
+    return num_runs;
+}
+
+// A set of any container as runs; returns their number
+static int set_runs(ctl_compact_set* set, int num_states, unsigned short* runs) {
+    int num_runs = 0;
+    switch (set->container) {
+        case CTL_SET_ARRAY:
+            for (int i = 0; i < set->length; i++) {
+                append_run(runs, &num_runs, set->ids[i], set->ids[i]);
+            }
+            return num_runs;
+        case CTL_SET_RUNS:
+            memcpy(runs, set->ids, 2 * set->length * sizeof(unsigned short));
+            return set->length;
+        default:
+            return words_to_runs(set->words, num_states, runs);
+    }
+}
+
+// A set of any container as a bitmap
+static void set_words(ctl_compact_set* set, int num_states, word* words) {
+    if (set->container == CTL_SET_BITMAP) {
+        memcpy(words, set->words, num_words(num_states) * sizeof(word));
+        return;
+    }
+    memset(words, 0, num_words(num_states) * sizeof(word));
+    if (set->container == CTL_SET_ARRAY) {
+        for (int i = 0; i < set->length; i++) {
+            words[set->ids[i] / WORD_BITS] |= (word)1 << (set->ids[i] % WORD_BITS);
+        }
+    } else {
+        for (int r = 0; r < set->length; r++) {
+            fill_range(words, set->ids[2 * r], set->ids[2 * r + 1]);
+        }
+    }
+}
+
+// Pack a bitmap into the smallest container; sizes come from counting bits
+// and run starts (ones whose lower neighbour is zero), word by word
+static ctl_compact_set* pack_words(const word* words, int num_states) {
+    int size = 0, num_runs = 0;
+    word carry = 0;
+    for (int w = 0; w < num_words(num_states); w++) {
+        size += count_bits(words[w]);
+        num_runs += count_bits(words[w] & ~((words[w] << 1) | carry));
+        carry = words[w] >> (WORD_BITS - 1);
+    }
+
+    size_t bitmap_bytes = num_words(num_states) * sizeof(word);
+    if (bitmap_bytes < size * sizeof(unsigned short) && bitmap_bytes < 2 * num_runs * sizeof(unsigned short)) {
+        ctl_compact_set* set = allocate_set(CTL_SET_BITMAP, size, num_words(num_states));
+        memcpy(set->words, words, bitmap_bytes);
+        return set;
+    }
+    unsigned short runs[2 * MAX_RUNS];
+    num_runs = words_to_runs(words, num_states, runs);
+    return pack_runs(runs, num_runs, num_states);
+}
+
+/* Conversions */
+
+// Compact copy of a state set (states below num_states)
+ctl_compact_set* ctl_compress_state_set(state_set* set, int num_states) {
+    unsigned short runs[2 * MAX_RUNS];
+    int num_runs = 0;
+    for (int i = 0; i < num_states; i++) {
+        if (!set->members[i]) continue;
+        int last = i;
+        while (last + 1 < num_states && set->members[last + 1]) last++;
+        append_run(runs, &num_runs, i, last);
+        i = last;
+    }
+    return pack_runs(runs, num_runs, num_states);
+}
+
+// Expand a compact set into a state set
+void ctl_decompress_state_set(state_set* result, ctl_compact_set* set, int num_states) {
+    unsigned short runs[2 * MAX_RUNS];
+    int num_runs = set_runs(set, num_states, runs);
+    ctl_init_state_set(result, num_states);
+    for (int r = 0; r < num_runs; r++) {
+        memset(&result->members[runs[2 * r]], true, runs[2 * r + 1] - runs[2 * r] + 1);
+    }
+    result->size = set->size;
+}
+
+// Compact set from runs of state IDs (first and last of each, ascending)
+ctl_compact_set* ctl_compact_set_from_runs(const unsigned short* runs, int num_runs, int num_states) {
+    unsigned short joined[2 * MAX_RUNS];
+    int num_joined = 0;
+    for (int r = 0; r < num_runs; r++) {
+        append_run(joined, &num_joined, runs[2 * r], runs[2 * r + 1]);
+    }
+    return pack_runs(joined, num_joined, num_states);
+}
+
+// The runs of a compact set (room for MAX_STATES + 1 values); returns their
+// number
+int ctl_compact_set_runs(ctl_compact_set* set, int num_states, unsigned short* runs) {
+    return set_runs(set, num_states, runs);
+}
+
+ctl_compact_set* ctl_copy_compact_set(ctl_compact_set* set) {
+    ctl_compact_set* copy = allocate_set(set->container, set->size, set->length);
+    memcpy(copy + 1, set + 1, data_bytes(set->container, set->length));
+    return copy;
+}
+
+// Storage a compact set takes, header included
+size_t ctl_compact_set_bytes(ctl_compact_set* set) {
+    return sizeof(ctl_compact_set) + data_bytes(set->container, set->length);
+}
+
+/* Operations */
+
+bool ctl_compact_set_contains(ctl_compact_set* set, int state_id) {
+    if (set->container == CTL_SET_BITMAP) {
+        return (set->words[state_id / WORD_BITS] >> (state_id % WORD_BITS)) & 1;
+    }
+
+    // Binary search for the last ID (array) or run start (runs) <= state_id
+    int stride = (set->container == CTL_SET_RUNS) ? 2 : 1;
+    int low = 0, high = set->length - 1;
+    while (low <= high) {
+        int middle = (low + high) / 2;
+        if (set->ids[stride * middle] <= state_id) {
+            low = middle + 1;
+        } else {
+            high = middle - 1;
+        }
+    }
+    if (high < 0) return false;
+    return set->ids[stride * high + stride - 1] >= state_id;
+}
+
+// Set complement (W \ X) as a new compact set
+ctl_compact_set* ctl_compact_complement(ctl_compact_set* set, int num_states) {
+    if (set->container == CTL_SET_BITMAP) {
+        word words[MAX_WORDS];
+        for (int w = 0; w < set->length; w++) {
+            words[w] = ~set->words[w];
+        }
+        if (num_states % WORD_BITS != 0) {
+            words[set->length - 1] &= ((word)1 << (num_states % WORD_BITS)) - 1;
+        }
+        return pack_words(words, num_states);
+    }
+
+    // The gaps between the runs
+    unsigned short runs[2 * MAX_RUNS], gaps[2 * MAX_RUNS + 2];
+    int num_runs = set_runs(set, num_states, runs);
+    int num_gaps = 0;
+    int next = 0;
+    for (int r = 0; r < num_runs; r++) {
+        if (runs[2 * r] > next) append_run(gaps, &num_gaps, next, runs[2 * r] - 1);
+        next = runs[2 * r + 1] + 1;
+    }
+    if (next < num_states) append_run(gaps, &num_gaps, next, num_states - 1);
+    return pack_runs(gaps, num_gaps, num_states);
+}
+
+// Union (X ∪ Y) or intersection (X ∩ Y) as a new compact set
+static ctl_compact_set* combine(ctl_compact_set* set1, ctl_compact_set* set2, int num_states, bool unite) {
+    if (set1->container == CTL_SET_BITMAP || set2->container == CTL_SET_BITMAP) {
+        word words1[MAX_WORDS], words2[MAX_WORDS];
+        set_words(set1, num_states, words1);
+        set_words(set2, num_states, words2);
+        for (int w = 0; w < num_words(num_states); w++) {
+            words1[w] = unite ? (words1[w] | words2[w]) : (words1[w] & words2[w]);
+        }
+        return pack_words(words1, num_states);
+    }
+
+    // Merge the two run lists in order of their first IDs
+    unsigned short runs1[2 * MAX_RUNS], runs2[2 * MAX_RUNS], result[2 * MAX_RUNS];
+    int num_runs1 = set_runs(set1, num_states, runs1);
+    int num_runs2 = set_runs(set2, num_states, runs2);
+    int num_result = 0;
+    int i = 0, j = 0;
+    if (unite) {
+        while (i < num_runs1 || j < num_runs2) {
+            bool take1 = (j == num_runs2) || (i < num_runs1 && runs1[2 * i] <= runs2[2 * j]);
+            unsigned short* run = take1 ? &runs1[2 * i++] : &runs2[2 * j++];
+            append_run(result, &num_result, run[0], run[1]);
+        }
+    } else {
+        while (i < num_runs1 && j < num_runs2) {
+            int first = (runs1[2 * i] > runs2[2 * j]) ? runs1[2 * i] : runs2[2 * j];
+            int last = (runs1[2 * i + 1] < runs2[2 * j + 1]) ? runs1[2 * i + 1] : runs2[2 * j + 1];
+            if (first <= last) append_run(result, &num_result, first, last);
+            if (runs1[2 * i + 1] < runs2[2 * j + 1]) i++; else j++;
+        }
+    }
+    return pack_runs(result, num_result, num_states);
+}
+
+ctl_compact_set* ctl_compact_union(ctl_compact_set* set1, ctl_compact_set* set2, int num_states) {
+    return combine(set1, set2, num_states, true);
+}
+
+ctl_compact_set* ctl_compact_intersect(ctl_compact_set* set1, ctl_compact_set* set2, int num_states) {
+    return combine(set1, set2, num_states, false);
+}
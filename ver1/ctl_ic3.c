@@ -0,0 +1,558 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "ctl_api.h"
+#include "ctl_sat.h"
+
+/*
+ * IC3 / property-directed reachability for AG P.
+ *
+ * States are encoded in binary over current-state bits x and next-state
+ * bits x', with the transition relation T(x, x') as clauses. Frames
+ * F_1 .. F_k over-approximate the states reachable in at most i steps and
+ * are kept as clauses ¬c over x, where c is a cube (a partial assignment
+ * of the bits) known to be unreachable within i steps. A bad state found
+ * in F_k is blocked by recursively blocking its predecessors in earlier
+ * frames; each blocked cube is generalized by dropping bits while the
+ * clause stays inductive relative to the previous frame. Clauses are then
+ * pushed forward, and once two adjacent frames agree the frame is an
+ * inductive invariant that excludes every ¬P state. A predecessor chain
+ * reaching an initial state is a counterexample.
+ *
+ * All queries go to one incremental solver: a clause of level i is guarded
+ * by an activation literal act_i, so F_i is selected by assuming act_j for
+ * every j >= i.
+ */
+
+#define IC3_MAX_BITS 16
+
+// Partial assignment of the state bits: 0 or 1, or -1 if the bit is free
+typedef struct {
+    signed char bit[IC3_MAX_BITS];
+} ic3_cube;
+
+typedef struct {
+    ic3_cube cube;
+    int level;                    // Highest frame the clause ¬cube is known to hold in
+} ic3_clause;
+
+// A state that reaches a bad state and has to be excluded from a frame
+typedef struct {
+    int state_id;
+    int level;
+    int parent;                   // Obligation this state is a predecessor of (-1 for the bad state)
+} ic3_obligation;
+
+typedef struct {
+    sat_solver* solver;
+    model* model;
+    int num_bits;
+    int cur_bit[IC3_MAX_BITS];
+    int next_bit[IC3_MAX_BITS];
+    int* cur_state;               // cur_state[s] <-> (x == s)
+    bool* is_initial;
+    int* initial_states;
+    int num_initial;
+    int init_act;                 // Activates x ∈ Init (frame 0)
+    int bad_var;                  // bad_var -> x ∉ P
+    int num_frames;               // Frames 1 .. num_frames exist
+    int* frame_act;               // frame_act[i] activates the clauses of level i
+    int frame_capacity;
+    ic3_clause* clauses;
+    int num_clauses;
+    int clause_capacity;
+    ic3_obligation* obligations;
+    int num_obligations;
+    int obligation_capacity;
+    int* assumptions;
+} ic3_engine;
+
+static void* ic3_grow(void* array, int* capacity, int needed, size_t size) {
+    if (needed <= *capacity) return array;
+    int new_capacity = (*capacity > 0) ? *capacity * 2 : 16;
+    while (new_capacity < needed) new_capacity *= 2;
+    void* grown = realloc(array, (size_t)new_capacity * size);
+    if (grown == NULL) {
+        fprintf(stderr, "Error: Memory allocation failed for IC3\n");
+        exit(1);
+    }
+    *capacity = new_capacity;
+    return grown;
+}
+
+// Literal asserting bit b of x (or x') has the given value
+static int bit_literal(const int* bits, int b, int value) {
+    return value ? bits[b] : -bits[b];
+}
+
+// Encode the state bits of x or x', tie one indicator per state to them and
+// exclude the codes beyond the last state
+static void encode_bits(ic3_engine* ic, int* bits, int* indicators) {
+    int n = ic->model->num_states;
+    int clause[IC3_MAX_BITS + 1];
+
+    for (int b = 0; b < ic->num_bits; b++) {
+        bits[b] = sat_new_var(ic->solver);
+    }
+    for (int s = 0; s < n; s++) {
+        indicators[s] = sat_new_var(ic->solver);
+        for (int b = 0; b < ic->num_bits; b++) {
+            clause[0] = -indicators[s];
+            clause[1] = bit_literal(bits, b, (s >> b) & 1);
+            sat_add_clause(ic->solver, clause, 2);
+        }
+        for (int b = 0; b < ic->num_bits; b++) {
+            clause[b] = bit_literal(bits, b, !((s >> b) & 1));
+        }
+        clause[ic->num_bits] = indicators[s];
+        sat_add_clause(ic->solver, clause, ic->num_bits + 1);
+    }
+    for (int code = n; code < (1 << ic->num_bits); code++) {
+        for (int b = 0; b < ic->num_bits; b++) {
+            clause[b] = bit_literal(bits, b, !((code >> b) & 1));
+        }
+        sat_add_clause(ic->solver, clause, ic->num_bits);
+    }
+}
+
+static bool ic3_init(ic3_engine* ic, model* model, state_set* prop_p) {
+    int n = model->num_states;
+    int* next_state = malloc(n * sizeof(int));
+    int* clause = malloc((n + MAX_TRANSITIONS + 1) * sizeof(int));
+
+    ic->solver = sat_new();
+    ic->model = model;
+    ic->num_bits = 1;
+    while ((1 << ic->num_bits) < n) ic->num_bits++;
+    ic->cur_state = malloc(n * sizeof(int));
+    ic->is_initial = calloc(n, sizeof(bool));
+    ic->initial_states = malloc(n * sizeof(int));
+    ic->num_initial = 0;
+    ic->num_frames = 0;
+    ic->frame_act = NULL;
+    ic->frame_capacity = 0;
+    ic->clauses = NULL;
+    ic->num_clauses = 0;
+    ic->clause_capacity = 0;
+    ic->obligations = NULL;
+    ic->num_obligations = 0;
+    ic->obligation_capacity = 0;
+    ic->assumptions = NULL;
+
+    if (ic->solver == NULL || ic->cur_state == NULL || ic->is_initial == NULL || ic->initial_states == NULL ||
+        next_state == NULL || clause == NULL || ic->num_bits > IC3_MAX_BITS) {
+        fprintf(stderr, "Error: Memory allocation failed for IC3\n");
+        free(next_state);
+        free(clause);
+        return false;
+    }
+
+    encode_bits(ic, ic->cur_bit, ic->cur_state);
+    encode_bits(ic, ic->next_bit, next_state);
+
+    // T(x, x'): a state moves to one of its successors; deadlock states
+    // stutter, which adds no reachable states
+    for (int s = 0; s < n; s++) {
+        state* current_state = &model->states[s];
+        clause[0] = -ic->cur_state[s];
+        if (current_state->num_transitions == 0) {
+            clause[1] = next_state[s];
+            sat_add_clause(ic->solver, clause, 2);
+            continue;
+        }
+        for (int j = 0; j < current_state->num_transitions; j++) {
+            clause[j + 1] = next_state[current_state->transitions[j]];
+        }
+        sat_add_clause(ic->solver, clause, current_state->num_transitions + 1);
+    }
+
+    // Initial states, defaulting to state 0
+    int count = 0;
+    ic->init_act = sat_new_var(ic->solver);
+    clause[count++] = -ic->init_act;
+    for (int s = 0; s < n; s++) {
+        if (model->initial[s]) {
+            ic->is_initial[s] = true;
+            ic->initial_states[ic->num_initial++] = s;
+            clause[count++] = ic->cur_state[s];
+        }
+    }
+    if (ic->num_initial == 0) {
+        ic->is_initial[0] = true;
+        ic->initial_states[ic->num_initial++] = 0;
+        clause[count++] = ic->cur_state[0];
+    }
+    sat_add_clause(ic->solver, clause, count);
+
+    // Bad states
+    count = 0;
+    ic->bad_var = sat_new_var(ic->solver);
+    clause[count++] = -ic->bad_var;
+    for (int s = 0; s < n; s++) {
+        if (!prop_p->members[s]) {
+            clause[count++] = ic->cur_state[s];
+        }
+    }
+    sat_add_clause(ic->solver, clause, count);
+
+    free(next_state);
+    free(clause);
+    return true;
+}
+
+static void ic3_free(ic3_engine* ic) {
+    sat_free(ic->solver);
+    free(ic->cur_state);
+    free(ic->is_initial);
+    free(ic->initial_states);
+    free(ic->frame_act);
+    free(ic->clauses);
+    free(ic->obligations);
+    free(ic->assumptions);
+}
+
+static void ic3_new_frame(ic3_engine* ic) {
+    ic->num_frames++;
+    ic->frame_act = ic3_grow(ic->frame_act, &ic->frame_capacity, ic->num_frames + 1, sizeof(int));
+    ic->frame_act[ic->num_frames] = sat_new_var(ic->solver);
+    ic->assumptions = realloc(ic->assumptions, (ic->num_frames + 2 * IC3_MAX_BITS + 4) * sizeof(int));
+    if (ic->assumptions == NULL) {
+        fprintf(stderr, "Error: Memory allocation failed for IC3\n");
+        exit(1);
+    }
+}
+
+// Start the assumptions of a query on F_level. Frame 0 is Init; the frame
+// clauses may be assumed along with it since no clause excludes an initial state.
+static int assume_frame(ic3_engine* ic, int level) {
+    int count = 0;
+    if (level == 0) {
+        ic->assumptions[count++] = ic->init_act;
+    }
+    for (int j = (level > 0 ? level : 1); j <= ic->num_frames; j++) {
+        ic->assumptions[count++] = ic->frame_act[j];
+    }
+    return count;
+}
+
+static void cube_of_state(ic3_engine* ic, int state_id, ic3_cube* cube) {
+    for (int b = 0; b < IC3_MAX_BITS; b++) {
+        cube->bit[b] = (b < ic->num_bits) ? ((state_id >> b) & 1) : -1;
+    }
+}
+
+static bool cube_contains(ic3_engine* ic, const ic3_cube* cube, int state_id) {
+    for (int b = 0; b < ic->num_bits; b++) {
+        if (cube->bit[b] >= 0 && cube->bit[b] != ((state_id >> b) & 1)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static int cube_initial_state(ic3_engine* ic, const ic3_cube* cube) {
+    for (int i = 0; i < ic->num_initial; i++) {
+        if (cube_contains(ic, cube, ic->initial_states[i])) {
+            return ic->initial_states[i];
+        }
+    }
+    return -1;
+}
+
+// The state assigned to x in the last satisfying assignment
+static int current_state_of_model(ic3_engine* ic) {
+    for (int s = 0; s < ic->model->num_states; s++) {
+        if (sat_value(ic->solver, ic->cur_state[s])) {
+            return s;
+        }
+    }
+    return -1;
+}
+
+// Is ¬cube inductive relative to F_level, i.e. F_level ∧ ¬cube ∧ T ∧ cube'
+// unsatisfiable? If so, drop from core the bits not needed for the answer.
+// Otherwise *predecessor (if given) is a state of F_level with a successor in the cube.
+static bool relative_inductive(ic3_engine* ic, const ic3_cube* cube, int level,
+                               ic3_cube* core, int* predecessor) {
+    int clause[IC3_MAX_BITS];
+    int width = 0;
+    int count = assume_frame(ic, level);
+
+    // ¬cube over x, for this query only
+    int guard = sat_new_var(ic->solver);
+    clause[width++] = -guard;
+    for (int b = 0; b < ic->num_bits; b++) {
+        if (cube->bit[b] >= 0) {
+            clause[width++] = bit_literal(ic->cur_bit, b, !cube->bit[b]);
+        }
+    }
+    sat_add_clause(ic->solver, clause, width);
+    ic->assumptions[count++] = guard;
+
+    for (int b = 0; b < ic->num_bits; b++) {
+        if (cube->bit[b] >= 0) {
+            ic->assumptions[count++] = bit_literal(ic->next_bit, b, cube->bit[b]);
+        }
+    }
+
+    bool unsat = (sat_solve(ic->solver, ic->assumptions, count) == SAT_UNSATISFIABLE);
+    if (unsat && core != NULL) {
+        *core = *cube;
+        for (int b = 0; b < ic->num_bits; b++) {
+            if (cube->bit[b] >= 0 &&
+                !sat_failed_assumption(ic->solver, bit_literal(ic->next_bit, b, cube->bit[b]))) {
+                core->bit[b] = -1;
+            }
+        }
+    } else if (!unsat && predecessor != NULL) {
+        *predecessor = current_state_of_model(ic);
+    }
+
+    // Retire the guard
+    clause[0] = -guard;
+    sat_add_clause(ic->solver, clause, 1);
+    return unsat;
+}
+
+// Put back bits of the original cube until the core excludes every initial state
+static void exclude_initial_states(ic3_engine* ic, const ic3_cube* original, ic3_cube* core) {
+    int s;
+    while ((s = cube_initial_state(ic, core)) >= 0) {
+        for (int b = 0; b < ic->num_bits; b++) {
+            if (core->bit[b] < 0 && original->bit[b] >= 0 && original->bit[b] != ((s >> b) & 1)) {
+                core->bit[b] = original->bit[b];
+                break;
+            }
+        }
+    }
+}
+
+// Shrink a cube whose negation is inductive relative to F_level
+static void generalize(ic3_engine* ic, const ic3_cube* cube, int level, ic3_cube* result) {
+    ic3_cube core;
+
+    relative_inductive(ic, cube, level, result, NULL);
+    exclude_initial_states(ic, cube, result);
+
+    for (int b = 0; b < ic->num_bits; b++) {
+        if (result->bit[b] < 0) continue;
+        ic3_cube candidate = *result;
+        candidate.bit[b] = -1;
+        if (cube_initial_state(ic, &candidate) >= 0) continue;
+        if (relative_inductive(ic, &candidate, level, &core, NULL)) {
+            exclude_initial_states(ic, &candidate, &core);
+            *result = core;
+        }
+    }
+}
+
+// Add ¬cube to the frames 1 .. level
+static void add_blocking_clause(ic3_engine* ic, const ic3_cube* cube, int level) {
+    int clause[IC3_MAX_BITS + 1];
+    int width = 0;
+
+    ic->clauses = ic3_grow(ic->clauses, &ic->clause_capacity, ic->num_clauses + 1, sizeof(ic3_clause));
+    ic->clauses[ic->num_clauses].cube = *cube;
+    ic->clauses[ic->num_clauses].level = level;
+    ic->num_clauses++;
+
+    clause[width++] = -ic->frame_act[level];
+    for (int b = 0; b < ic->num_bits; b++) {
+        if (cube->bit[b] >= 0) {
+            clause[width++] = bit_literal(ic->cur_bit, b, !cube->bit[b]);
+        }
+    }
+    sat_add_clause(ic->solver, clause, width);
+}
+
+static int push_obligation(ic3_engine* ic, int state_id, int level, int parent) {
+    ic->obligations = ic3_grow(ic->obligations, &ic->obligation_capacity,
+                               ic->num_obligations + 1, sizeof(ic3_obligation));
+    ic->obligations[ic->num_obligations].state_id = state_id;
+    ic->obligations[ic->num_obligations].level = level;
+    ic->obligations[ic->num_obligations].parent = parent;
+    return ic->num_obligations++;
+}
+
+static void read_counterexample(ic3_engine* ic, int obligation, ctl_path* path) {
+    path->length = 0;
+    path->loop_start = -1;
+    while (obligation >= 0 && path->length < MAX_STATES) {
+        path->states[path->length++] = ic->obligations[obligation].state_id;
+        obligation = ic->obligations[obligation].parent;
+    }
+}
+
+// Exclude a bad state from F_num_frames by blocking it and, recursively, its
+// predecessors. Returns false with a counterexample if an initial state reaches it.
+static bool block_state(ic3_engine* ic, int bad_state, ctl_path* counterexample) {
+    // Obligations are taken lowest frame first; pending[] lists the open ones
+    int* pending = NULL;
+    int num_pending = 0, pending_capacity = 0;
+
+    ic->num_obligations = 0;
+    pending = ic3_grow(pending, &pending_capacity, 1, sizeof(int));
+    pending[num_pending++] = push_obligation(ic, bad_state, ic->num_frames, -1);
+
+    while (num_pending > 0) {
+        int best = 0;
+        for (int i = 1; i < num_pending; i++) {
+            if (ic->obligations[pending[i]].level <= ic->obligations[pending[best]].level) {
+                best = i;
+            }
+        }
+        int current = pending[best];
+        ic3_obligation obligation = ic->obligations[current];
+
+        if (ic->is_initial[obligation.state_id]) {
+            read_counterexample(ic, current, counterexample);
+            free(pending);
+            return false;
+        }
+
+        ic3_cube cube, blocked;
+        int predecessor;
+        cube_of_state(ic, obligation.state_id, &cube);
+        if (relative_inductive(ic, &cube, obligation.level - 1, NULL, &predecessor)) {
+            generalize(ic, &cube, obligation.level - 1, &blocked);
+
+            // Block in as late a frame as the clause stays inductive
+            int level = obligation.level;
+            while (level < ic->num_frames && relative_inductive(ic, &blocked, level, NULL, NULL)) {
+                level++;
+            }
+            add_blocking_clause(ic, &blocked, level);
+
+            pending[best] = pending[--num_pending];
+            if (level < ic->num_frames) {
+                // Still reaches the bad state later: block it in the next frame too
+                pending[num_pending++] = push_obligation(ic, obligation.state_id, level + 1, obligation.parent);
+            }
+        } else {
+            pending = ic3_grow(pending, &pending_capacity, num_pending + 1, sizeof(int));
+            pending[num_pending++] = push_obligation(ic, predecessor, obligation.level - 1, current);
+        }
+    }
+
+    free(pending);
+    return true;
+}
+
+// Push clauses forward; returns the level whose clauses all moved on (so
+// F_level = F_level+1 is inductive), or 0
+static int propagate_clauses(ic3_engine* ic) {
+    for (int level = 1; level < ic->num_frames; level++) {
+        bool level_empty = true;
+        for (int i = 0; i < ic->num_clauses; i++) {
+            ic3_clause* clause = &ic->clauses[i];
+            if (clause->level != level) continue;
+            if (relative_inductive(ic, &clause->cube, level, NULL, NULL)) {
+                ic3_cube cube = clause->cube;
+                clause->level = level + 1;
+                // The old copy stays in the solver under act_level, where it is implied anyway
+                int literals[IC3_MAX_BITS + 1];
+                int width = 0;
+                literals[width++] = -ic->frame_act[level + 1];
+                for (int b = 0; b < ic->num_bits; b++) {
+                    if (cube.bit[b] >= 0) {
+                        literals[width++] = bit_literal(ic->cur_bit, b, !cube.bit[b]);
+                    }
+                }
+                sat_add_clause(ic->solver, literals, width);
+            } else {
+                level_empty = false;
+            }
+        }
+        if (level_empty) {
+            return level;
+        }
+    }
+    return 0;
+}
+
+// The invariant as clauses and, for reporting, as the set of states it admits
+static void read_invariant(ic3_engine* ic, int level, ctl_ic3_report* report) {
+    report->num_clauses = 0;
+    for (int i = 0; i < ic->num_clauses; i++) {
+        if (ic->clauses[i].level > level) {
+            report->num_clauses++;
+        }
+    }
+
+    ctl_init_state_set(&report->invariant, ic->model->num_states);
+    for (int s = 0; s < ic->model->num_states; s++) {
+        bool excluded = false;
+        for (int i = 0; i < ic->num_clauses && !excluded; i++) {
+            excluded = ic->clauses[i].level > level && cube_contains(ic, &ic->clauses[i].cube, s);
+        }
+        if (!excluded) {
+            ctl_add_to_state_set(&report->invariant, s);
+        }
+    }
+}
+
+// Check AG P from the initial states. The report (may be NULL) receives the
+// inductive invariant if the property holds, or a counterexample path from
+// an initial state to a ¬P state if it does not.
+ctl_ic3_result ctl_ic3_check(model* model, state_set* prop_p, ctl_ic3_report* report) {
+    ic3_engine ic;
+    ctl_ic3_report* local = NULL;
+    ctl_ic3_result result;
+
+    if (report == NULL) {
+        local = malloc(sizeof(ctl_ic3_report));
+        report = local;
+    }
+    if (report == NULL || model->num_states == 0) {
+        free(local);
+        return CTL_IC3_FAILED;
+    }
+    report->num_frames = 0;
+    report->num_clauses = 0;
+    report->counterexample.length = 0;
+    report->counterexample.loop_start = -1;
+
+    if (!ic3_init(&ic, model, prop_p)) {
+        ic3_free(&ic);
+        free(local);
+        return CTL_IC3_FAILED;
+    }
+    ic3_new_frame(&ic);
+
+    // A bad initial state is a counterexample of length 0
+    int assumptions[2] = { ic.init_act, ic.bad_var };
+    if (sat_solve(ic.solver, assumptions, 2) == SAT_SATISFIABLE) {
+        report->counterexample.states[0] = current_state_of_model(&ic);
+        report->counterexample.length = 1;
+        result = CTL_IC3_VIOLATED;
+        goto done;
+    }
+
+    for (;;) {
+        // Block every bad state left in the last frame
+        for (;;) {
+            int count = assume_frame(&ic, ic.num_frames);
+            ic.assumptions[count++] = ic.bad_var;
+            if (sat_solve(ic.solver, ic.assumptions, count) == SAT_UNSATISFIABLE) {
+                break;
+            }
+            if (!block_state(&ic, current_state_of_model(&ic), &report->counterexample)) {
+                result = CTL_IC3_VIOLATED;
+                goto done;
+            }
+        }
+
+        ic3_new_frame(&ic);
+        int fixpoint = propagate_clauses(&ic);
+        if (fixpoint > 0) {
+            read_invariant(&ic, fixpoint, report);
+            result = CTL_IC3_HOLDS;
+            goto done;
+        }
+    }
+
+done:
+    report->num_frames = ic.num_frames;
+    ic3_free(&ic);
+    free(local);
+    return result;
+}
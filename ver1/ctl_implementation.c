@@ -2,14 +2,19 @@
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
+#include <stdarg.h>
 #include "ctl_api.h"
 
 // Enum for token types in the formula parser
 typedef enum {
     TOKEN_PROP,    // Atomic proposition
+    TOKEN_TRUE,    // Constant true
+    TOKEN_FALSE,   // Constant false
     TOKEN_NOT,     // Negation (¬ or !)
     TOKEN_AND,     // Conjunction (∧ or &)
     TOKEN_OR,      // Disjunction (∨ or |)
+    TOKEN_IMPLIES, // Implication (->)
+    TOKEN_IFF,     // Equivalence (<->)
     TOKEN_EX,      // Exists Next
     TOKEN_EF,      // Exists Finally
     TOKEN_EG,      // Exists Globally
@@ -18,158 +23,187 @@ typedef enum {
     TOKEN_AF,      // Always Finally
     TOKEN_AG,      // Always Globally
     TOKEN_AU,      // Always Until
+    TOKEN_EW,      // Exists Weak until
+    TOKEN_AW,      // Always Weak until
+    TOKEN_ER,      // Exists Release
+    TOKEN_AR,      // Always Release
+    TOKEN_E,       // Path quantifier of E[P U Q], E[P W Q], E[P R Q]
+    TOKEN_A,       // Path quantifier of A[P U Q], A[P W Q], A[P R Q]
     TOKEN_LPAREN,  // Left parenthesis
     TOKEN_RPAREN,  // Right parenthesis
+    TOKEN_LBRACKET, // Left bracket
+    TOKEN_RBRACKET, // Right bracket
     TOKEN_COMMA,   // Comma
     TOKEN_EOF      // End of formula
 } token_type;
 
-// Structure for a token
+// Structure for a token: a slice of the formula, not a copy
 typedef struct {
     token_type type;
-    char value[MAX_TOKEN_LEN];
+    const char* start;
+    int length;
 } token;
 
-// Structure for a lexer
+// Structure for a lexer: reads the formula in place, one token ahead
 typedef struct {
-    char formula[MAX_FORMULA_LEN];
-    int position;
+    const char* formula;
+    const char* cursor;     // First character after the lookahead token
+    token lookahead;
+    ctl_parse_error* error; // First syntax error (position < 0 while none)
+    int depth;              // Nested factors and implications being parsed
 } lexer;
 
-// Forward declarations for recursive descent parser
-state_set* parse_expression(lexer* lexer, model* model);
-state_set* parse_term(lexer* lexer, model* model);
-state_set* parse_factor(lexer* lexer, model* model);
+// printf arguments for a token ("%.*s")
+#define TOKEN_TEXT(t) (t).length, (t).start
 
-// Initialize the lexer with a formula
-void init_lexer(lexer* lexer, const char* formula) {
-    strncpy(lexer->formula, formula, MAX_FORMULA_LEN - 1);
-    lexer->formula[MAX_FORMULA_LEN - 1] = '\0';
-    lexer->position = 0;
+// Forward declarations for recursive descent parser (compiles to plan nodes)
+int parse_expression(lexer* lexer, ctl_plan* plan);
+int parse_implication(lexer* lexer, ctl_plan* plan);
+int parse_disjunction(lexer* lexer, ctl_plan* plan);
+int parse_term(lexer* lexer, ctl_plan* plan);
+int parse_factor(lexer* lexer, ctl_plan* plan);
+static bool parse_until_operands(lexer* lexer, ctl_plan* plan, token* op_token, int* left, int* right);
+static bool parse_path_operands(lexer* lexer, ctl_plan* plan, token* op_token, int* left, int* right);
+
+// Does an atomic proposition end at p? (at a separator or an operator)
+static bool ends_proposition(const char* p) {
+    char c = *p;
+    return c == '\0' || isspace((unsigned char)c) || c == '(' || c == ')' || c == ',' ||
+           c == '[' || c == ']' || c == '&' || c == '|' || c == '!' || c == '~' ||
+           strncmp(p, "->", 2) == 0 || strncmp(p, "<->", 3) == 0;
+}
+
+// Does the token text equal a keyword?
+static bool token_is(const token* token, const char* keyword) {
+    return (int)strlen(keyword) == token->length && strncmp(token->start, keyword, token->length) == 0;
 }
 
-// Skip whitespace in the formula
-void skip_whitespace(lexer* lexer) {
-    while (lexer->formula[lexer->position] != '\0' && 
-           isspace(lexer->formula[lexer->position])) {
-        lexer->position++;
+// Scan the token at the cursor into the lookahead
+static void scan_token(lexer* lexer) {
+    const char* p = lexer->cursor;
+    token* token = &lexer->lookahead;
+    
+    while (*p != '\0' && isspace((unsigned char)*p)) {
+        p++;
+    }
+    token->start = p;
+    token->length = 1;
+    
+    switch (*p) {
+        case '\0': token->type = TOKEN_EOF; token->length = 0; break;
+        case '!': case '~': token->type = TOKEN_NOT; break;
+        case '&': case '^': token->type = TOKEN_AND; break;
+        case '|': case '+': token->type = TOKEN_OR; break;
+        case '(': token->type = TOKEN_LPAREN; break;
+        case ')': token->type = TOKEN_RPAREN; break;
+        case ',': token->type = TOKEN_COMMA; break;
+        case '[': token->type = TOKEN_LBRACKET; break;
+        case ']': token->type = TOKEN_RBRACKET; break;
+        default:
+            token->type = TOKEN_PROP;
+            if (strncmp(p, "->", 2) == 0) {
+                token->type = TOKEN_IMPLIES;
+                token->length = 2;
+            } else if (strncmp(p, "<->", 3) == 0) {
+                token->type = TOKEN_IFF;
+                token->length = 3;
+            } else if (*p == 'E' || *p == 'A') {
+                // CTL operators (EX, EF, EG, EU, AX, AF, AG, AU, and EW, AW,
+                // ER, AR as whole words); E or A before '[' is a path
+                // quantifier; anything else starting with E or A is an
+                // atomic proposition
+                bool exists = (*p == 'E');
+                token->length = 2;
+                switch (p[1]) {
+                    case 'X': token->type = exists ? TOKEN_EX : TOKEN_AX; break;
+                    case 'F': token->type = exists ? TOKEN_EF : TOKEN_AF; break;
+                    case 'G': token->type = exists ? TOKEN_EG : TOKEN_AG; break;
+                    case 'U': token->type = exists ? TOKEN_EU : TOKEN_AU; break;
+                    case 'W':
+                        if (ends_proposition(p + 2)) token->type = exists ? TOKEN_EW : TOKEN_AW;
+                        break;
+                    case 'R':
+                        if (ends_proposition(p + 2)) token->type = exists ? TOKEN_ER : TOKEN_AR;
+                        break;
+                    case '[':
+                        token->type = exists ? TOKEN_E : TOKEN_A;
+                        token->length = 1;
+                        break;
+                }
+            }
+            if (token->type == TOKEN_PROP) {
+                const char* end = p;
+                while (!ends_proposition(end)) end++;
+                token->length = (int)(end - p);
+                if (token_is(token, "true")) {
+                    token->type = TOKEN_TRUE;
+                } else if (token_is(token, "false")) {
+                    token->type = TOKEN_FALSE;
+                }
+            }
+            break;
     }
+    
+    lexer->cursor = p + token->length;
+}
+
+// Initialize the lexer with a formula (which must outlive the lexer)
+void init_lexer(lexer* lexer, const char* formula, ctl_parse_error* error) {
+    lexer->formula = formula;
+    lexer->cursor = formula;
+    lexer->error = error;
+    lexer->depth = 0;
+    error->position = -1;
+    error->message[0] = '\0';
+    scan_token(lexer);
 }
 
-// Get the next token from the formula
+// The next token, without consuming it
+static const token* peek_token(lexer* lexer) {
+    return &lexer->lookahead;
+}
+
+// Consume and return the next token
 token get_next_token(lexer* lexer) {
-    token token;
-    
-    skip_whitespace(lexer);
-    
-    if (lexer->formula[lexer->position] == '\0') {
-        token.type = TOKEN_EOF;
-        token.value[0] = '\0';
-        return token;
-    }
-    
-    // Check for special tokens
-    switch (lexer->formula[lexer->position]) {
-        case '!':
-        case '~':
-            token.type = TOKEN_NOT;
-            token.value[0] = lexer->formula[lexer->position];
-            token.value[1] = '\0';
-            lexer->position++;
-            return token;
-        case '&':
-        case '^':
-            token.type = TOKEN_AND;
-            token.value[0] = lexer->formula[lexer->position];
-            token.value[1] = '\0';
-            lexer->position++;
-            return token;
-        case '|':
-        case '+':
-            token.type = TOKEN_OR;
-            token.value[0] = lexer->formula[lexer->position];
-            token.value[1] = '\0';
-            lexer->position++;
-            return token;
-        case '(':
-            token.type = TOKEN_LPAREN;
-            token.value[0] = '(';
-            token.value[1] = '\0';
-            lexer->position++;
-            return token;
-        case ')':
-            token.type = TOKEN_RPAREN;
-            token.value[0] = ')';
-            token.value[1] = '\0';
-            lexer->position++;
-            return token;
-        case ',':
-            token.type = TOKEN_COMMA;
-            token.value[0] = ',';
-            token.value[1] = '\0';
-            lexer->position++;
-            return token;
-    }
-    
-    // Check for CTL operators (EX, EF, EG, EU, AX, AF, AG, AU)
-    if (lexer->formula[lexer->position] == 'E' || lexer->formula[lexer->position] == 'A') {
-        char first_char = lexer->formula[lexer->position];
-        lexer->position++;
-        
-        if (lexer->formula[lexer->position] == 'X') {
-            token.type = (first_char == 'E') ? TOKEN_EX : TOKEN_AX;
-            sprintf(token.value, "%cX", first_char);
-            lexer->position++;
-            return token;
-        } else if (lexer->formula[lexer->position] == 'F') {
-            token.type = (first_char == 'E') ? TOKEN_EF : TOKEN_AF;
-            sprintf(token.value, "%cF", first_char);
-            lexer->position++;
-            return token;
-        } else if (lexer->formula[lexer->position] == 'G') {
-            token.type = (first_char == 'E') ? TOKEN_EG : TOKEN_AG;
-            sprintf(token.value, "%cG", first_char);
-            lexer->position++;
-            return token;
-        } else if (lexer->formula[lexer->position] == 'U') {
-            token.type = (first_char == 'E') ? TOKEN_EU : TOKEN_AU;
-            sprintf(token.value, "%cU", first_char);
-            lexer->position++;
-            return token;
+    token current = lexer->lookahead;
+    if (current.type != TOKEN_EOF) {
+        scan_token(lexer);
+    }
+    return current;
+}
+
+// Record a syntax error at a token: "<what was expected>, got <token>".
+// Only the first error is kept. Returns -1, the node ID of a failed parse.
+static int syntax_error(lexer* lexer, const token* at, const char* expected, ...) {
+    ctl_parse_error* error = lexer->error;
+    if (error->position >= 0) {
+        return -1;
+    }
+    
+    va_list args;
+    va_start(args, expected);
+    int length = vsnprintf(error->message, sizeof(error->message), expected, args);
+    va_end(args);
+    
+    if (length >= 0 && length < (int)sizeof(error->message)) {
+        if (at->type == TOKEN_EOF) {
+            snprintf(error->message + length, sizeof(error->message) - length, ", got end of formula");
         } else {
-            // Invalid operator, treat as an atomic proposition
-            lexer->position--;
-        }
-    }
-    
-    // Atomic proposition
-    token.type = TOKEN_PROP;
-    int i = 0;
-    while (lexer->formula[lexer->position] != '\0' && 
-           !isspace(lexer->formula[lexer->position]) &&
-           lexer->formula[lexer->position] != '(' && 
-           lexer->formula[lexer->position] != ')' &&
-           lexer->formula[lexer->position] != ',' &&
-           lexer->formula[lexer->position] != '&' &&
-           lexer->formula[lexer->position] != '|' &&
-           lexer->formula[lexer->position] != '!' &&
-           lexer->formula[lexer->position] != '~') {
-        
-        token.value[i++] = lexer->formula[lexer->position++];
-        if (i >= MAX_TOKEN_LEN - 1) break;
+            snprintf(error->message + length, sizeof(error->message) - length, ", got '%.*s'", TOKEN_TEXT(*at));
+        }
     }
-    token.value[i] = '\0';
-    return token;
+    error->position = (int)(at->start - lexer->formula);
+    return -1;
 }
 
 /* State Set Operations */
 
 // Initialize an empty state set
+// (all MAX_STATES entries, since union and intersection scan all of them)
 void ctl_init_state_set(state_set* set, int num_states) {
+    (void)num_states;
     set->size = 0;
-    for (int i = 0; i < num_states; i++) {
-        set->members[i] = false;
-    }
+    memset(set->members, 0, sizeof(set->members));
 }
 
 // Add a state to a state set
@@ -237,10 +271,26 @@ model* ctl_create_model() {
     
     m->num_states = 0;
     m->num_props = 0;
+    for (int i = 0; i < PROP_TABLE_SIZE; i++) {
+        m->prop_table[i] = -1;
+    }
+    m->pred_start = NULL;
+    m->pred_list = NULL;
+    m->num_fairness = 0;
+    m->edges_scanned = 0;
+    m->iterations = 0;
     
     return m;
 }
 
+// Drop the cached predecessor index after a change to the transition relation
+static void invalidate_predecessor_index(model* model) {
+    free(model->pred_start);
+    free(model->pred_list);
+    model->pred_start = NULL;
+    model->pred_list = NULL;
+}
+
 // Free a model
 void ctl_free_model(model* model) {
     if (model == NULL) return;
@@ -249,6 +299,7 @@ void ctl_free_model(model* model) {
         free(model->prop_names[i]);
     }
     
+    invalidate_predecessor_index(model);
     free(model);
 }
 
@@ -262,6 +313,7 @@ int ctl_add_state(model* model) {
     int state_id = model->num_states;
     model->states[state_id].id = state_id;
     model->states[state_id].num_transitions = 0;
+    model->initial[state_id] = false;
     
     // Initialize all propositions to false for this state
     for (int i = 0; i < model->num_props; i++) {
@@ -269,6 +321,7 @@ int ctl_add_state(model* model) {
     }
     
     model->num_states++;
+    invalidate_predecessor_index(model);
     return state_id;
 }
 
@@ -287,26 +340,45 @@ bool ctl_add_transition(model* model, int from_state, int to_state) {
     
     // Add the transition
     model->states[from_state].transitions[model->states[from_state].num_transitions++] = to_state;
+    invalidate_predecessor_index(model);
     return true;
 }
 
+// Slot of the name table holding the proposition whose name is the first
+// `length` characters of name, or the empty slot where it would go
+static int* proposition_slot(model* model, const char* name, int length) {
+    // FNV-1a hash, then linear probing (the table is never more than half full)
+    unsigned int hash = 2166136261u;
+    for (int i = 0; i < length; i++) {
+        hash = (hash ^ (unsigned char)name[i]) * 16777619u;
+    }
+    
+    for (unsigned int slot = hash;; slot++) {
+        int* entry = &model->prop_table[slot & (PROP_TABLE_SIZE - 1)];
+        if (*entry < 0 ||
+            (strncmp(model->prop_names[*entry], name, length) == 0 && model->prop_names[*entry][length] == '\0')) {
+            return entry;
+        }
+    }
+}
+
 // Add a new atomic proposition to the model
 int ctl_add_proposition(model* model, const char* prop_name) {
+    // Check if the proposition already exists
+    int* entry = proposition_slot(model, prop_name, (int)strlen(prop_name));
+    if (*entry >= 0) {
+        return *entry;  // Return existing proposition ID
+    }
+    
     if (model->num_props >= MAX_PROPS) {
         fprintf(stderr, "Error: Maximum number of propositions reached\n");
         return -1;
     }
     
-    // Check if the proposition already exists
-    for (int i = 0; i < model->num_props; i++) {
-        if (strcmp(model->prop_names[i], prop_name) == 0) {
-            return i;  // Return existing proposition ID
-        }
-    }
-    
     // Add the new proposition
     int prop_id = model->num_props;
     model->prop_names[prop_id] = strdup(prop_name);
+    *entry = prop_id;
     
     // Initialize the proposition to false for all existing states
     for (int i = 0; i < model->num_states; i++) {
@@ -339,15 +411,68 @@ void ctl_set_proposition_false(model* model, int state_id, int prop_id) {
     model->states[state_id].atomic_props[prop_id] = false;
 }
 
+// ID of the proposition whose name is the first `length` characters of name
+// (-1 if not found); formula tokens are looked up in place this way
+static int find_proposition(model* model, const char* name, int length) {
+    return *proposition_slot(model, name, length);
+}
+
 // Get the ID of a proposition by name
 int ctl_get_proposition_id(model* model, const char* prop_name) {
-    for (int i = 0; i < model->num_props; i++) {
-        if (strcmp(model->prop_names[i], prop_name) == 0) {
-            return i;
+    return find_proposition(model, prop_name, (int)strlen(prop_name));
+}
+
+// Declare a state as initial
+void ctl_set_initial_state(model* model, int state_id) {
+    if (state_id < 0 || state_id >= model->num_states) {
+        fprintf(stderr, "Error: Invalid state ID: %d\n", state_id);
+        return;
+    }
+    
+    model->initial[state_id] = true;
+}
+
+// Build the predecessor index on first use; it is kept until the transitions change
+static bool build_predecessor_index(model* model) {
+    if (model->pred_start != NULL) {
+        return true;
+    }
+    
+    int num_edges = 0;
+    for (int i = 0; i < model->num_states; i++) {
+        num_edges += model->states[i].num_transitions;
+    }
+    
+    model->pred_start = calloc(model->num_states + 1, sizeof(int));
+    model->pred_list = malloc((num_edges > 0 ? num_edges : 1) * sizeof(int));
+    if (model->pred_start == NULL || model->pred_list == NULL) {
+        fprintf(stderr, "Error: Memory allocation failed for predecessor index\n");
+        invalidate_predecessor_index(model);
+        return false;
+    }
+    
+    // Count predecessors, turn the counts into start offsets, then fill
+    for (int i = 0; i < model->num_states; i++) {
+        for (int j = 0; j < model->states[i].num_transitions; j++) {
+            model->pred_start[model->states[i].transitions[j] + 1]++;
+        }
+    }
+    for (int i = 0; i < model->num_states; i++) {
+        model->pred_start[i + 1] += model->pred_start[i];
+    }
+    int fill[MAX_STATES];
+    for (int i = 0; i < model->num_states; i++) {
+        fill[i] = model->pred_start[i];
+    }
+    for (int i = 0; i < model->num_states; i++) {
+        for (int j = 0; j < model->states[i].num_transitions; j++) {
+            int successor_id = model->states[i].transitions[j];
+            model->pred_list[fill[successor_id]++] = i;
         }
     }
+    model->edges_scanned += 2L * num_edges;
     
-    return -1;  // Proposition not found
+    return true;
 }
 
 /* CTL Operators */
@@ -381,6 +506,7 @@ void ctl_eval_atomic_prop_by_name(state_set* result, model* model, const char* p
 
 // Find states that have a successor in the given set (EX)
 void ctl_existential_successor(state_set* result, state_set* set, model* model) {
+    long scanned = 0;
     ctl_init_state_set(result, model->num_states);
     
     for (int i = 0; i < model->num_states; i++) {
@@ -389,16 +515,19 @@ void ctl_existential_successor(state_set* result, state_set* set, model* model)
         // Check if any successor of state i is in the input set
         for (int j = 0; j < current_state->num_transitions; j++) {
             int successor_id = current_state->transitions[j];
+            scanned++;
             if (ctl_is_in_state_set(set, successor_id)) {
                 ctl_add_to_state_set(result, i);
                 break;
             }
         }
     }
+    model->edges_scanned += scanned;
 }
 
 // Find states such that all successors are in the given set (AX)
 void ctl_universal_successor(state_set* result, state_set* set, model* model) {
+    long scanned = 0;
     ctl_init_state_set(result, model->num_states);
     
     for (int i = 0; i < model->num_states; i++) {
@@ -408,6 +537,7 @@ void ctl_universal_successor(state_set* result, state_set* set, model* model) {
         // Check if all successors of state i are in the input set
         for (int j = 0; j < current_state->num_transitions; j++) {
             int successor_id = current_state->transitions[j];
+            scanned++;
             if (!ctl_is_in_state_set(set, successor_id)) {
                 all_in_set = false;
                 break;
@@ -418,38 +548,18 @@ void ctl_universal_successor(state_set* result, state_set* set, model* model) {
             ctl_add_to_state_set(result, i);
         }
     }
+    model->edges_scanned += scanned;
 }
 
 // Evaluate EF P (exists finally) - states that can reach a state where P is true
 void ctl_eval_ef(state_set* result, state_set* prop_p, model* model) {
-    state_set current, next;
-    
-    // Initialize with states where P is true
-    ctl_init_state_set(&current, model->num_states);
-    ctl_copy_state_set(&current, prop_p);
-    
-    bool changed = true;
-    while (changed) {
-        changed = false;
-        
-        // Find states that can reach the current set in one step
-        ctl_existential_successor(&next, &current, model);
-        
-        // Add these states to the current set
-        for (int i = 0; i < model->num_states; i++) {
-            if (next.members[i] && !current.members[i]) {
-                ctl_add_to_state_set(&current, i);
-                changed = true;
-            }
-        }
-    }
-    
-    ctl_copy_state_set(result, &current);
+    ctl_eval_eu_traced(result, NULL, prop_p, model, NULL);
 }
 
 // Evaluate EG P (exists globally) - states where there exists a path where P is always true
 void ctl_eval_eg(state_set* result, state_set* prop_p, model* model) {
     state_set current;
+    long scanned = 0;
     
     // Initialize with all states where P is true
     ctl_copy_state_set(&current, prop_p);
@@ -457,6 +567,7 @@ void ctl_eval_eg(state_set* result, state_set* prop_p, model* model) {
     bool changed = true;
     while (changed) {
         changed = false;
+        model->iterations++;
         
         for (int i = 0; i < model->num_states; i++) {
             if (current.members[i]) {
@@ -466,6 +577,7 @@ void ctl_eval_eg(state_set* result, state_set* prop_p, model* model) {
                 // Check if the state has at least one successor that's in the current set
                 for (int j = 0; j < current_state->num_transitions; j++) {
                     int successor_id = current_state->transitions[j];
+                    scanned++;
                     if (current.members[successor_id]) {
                         has_valid_successor = true;
                         break;
@@ -481,10 +593,33 @@ void ctl_eval_eg(state_set* result, state_set* prop_p, model* model) {
             }
         }
     }
+    model->edges_scanned += scanned;
     
     ctl_copy_state_set(result, &current);
 }
 
+// EG P with a trace: every state of the result keeps a successor inside the
+// result (-1 for deadlock states), so following it yields a lasso
+void ctl_eval_eg_traced(state_set* result, state_set* prop_p, model* model, ctl_trace* trace) {
+    ctl_eval_eg(result, prop_p, model);
+    
+    trace->num_states = model->num_states;
+    trace->complete = true;
+    for (int i = 0; i < model->num_states; i++) {
+        trace->layer[i] = result->members[i] ? 0 : -1;
+        trace->next[i] = -1;
+        if (!result->members[i]) continue;
+        
+        state* current_state = &model->states[i];
+        for (int j = 0; j < current_state->num_transitions; j++) {
+            if (result->members[current_state->transitions[j]]) {
+                trace->next[i] = current_state->transitions[j];
+                break;
+            }
+        }
+    }
+}
+
 // Evaluate AF P (always finally) - states where all paths eventually reach a state where P is true
 void ctl_eval_af(state_set* result, state_set* prop_p, model* model) {
     state_set not_p, eg_not_p;
@@ -515,24 +650,56 @@ void ctl_eval_ag(state_set* result, state_set* prop_p, model* model) {
 
 // Evaluate EU P Q (exists until) - states that can reach Q through P states
 void ctl_eval_eu(state_set* result, state_set* prop_p, state_set* prop_q, model* model) {
-    state_set current, next, temp;
+    ctl_eval_eu_traced(result, prop_p, prop_q, model, NULL);
+}
+
+// E[P U Q] (EF Q if prop_p is NULL) by layers: round k adds the P states with a
+// successor added in an earlier round. With a trace, each state keeps its round
+// and one such successor, so a path to Q can be read off without recomputing.
+void ctl_eval_eu_traced(state_set* result, state_set* prop_p, state_set* prop_q, model* model, ctl_trace* trace) {
+    state_set current, next;
     
     // Initialize with states where Q is true
+    ctl_init_state_set(&current, model->num_states);
     ctl_copy_state_set(&current, prop_q);
     
+    if (trace != NULL) {
+        trace->num_states = model->num_states;
+        trace->complete = true;
+        for (int i = 0; i < model->num_states; i++) {
+            trace->layer[i] = current.members[i] ? 0 : -1;
+            trace->next[i] = -1;
+        }
+    }
+    
+    int layer = 0;
     bool changed = true;
     while (changed) {
         changed = false;
+        layer++;
+        model->iterations++;
         
-        // Find states that can reach the current set in one step and satisfy P
+        // Find states that can reach the current set in one step (and satisfy P)
         ctl_existential_successor(&next, &current, model);
-        ctl_intersect_state_sets(&temp, &next, prop_p);
         
         // Add these states to the current set
         for (int i = 0; i < model->num_states; i++) {
-            if (temp.members[i] && !current.members[i]) {
-                ctl_add_to_state_set(&current, i);
-                changed = true;
+            if (!next.members[i] || current.members[i]) continue;
+            if (prop_p != NULL && !prop_p->members[i]) continue;
+            
+            ctl_add_to_state_set(&current, i);
+            changed = true;
+            
+            if (trace != NULL) {
+                state* current_state = &model->states[i];
+                trace->layer[i] = layer;
+                for (int j = 0; j < current_state->num_transitions; j++) {
+                    int successor_id = current_state->transitions[j];
+                    if (trace->layer[successor_id] >= 0 && trace->layer[successor_id] < layer) {
+                        trace->next[i] = successor_id;
+                        break;
+                    }
+                }
             }
         }
     }
@@ -540,211 +707,920 @@ void ctl_eval_eu(state_set* result, state_set* prop_p, state_set* prop_q, model*
     ctl_copy_state_set(result, &current);
 }
 
-// Evaluate AU P Q (always until) - states where all paths reach Q through P states
-void ctl_eval_au(state_set* result, state_set* prop_p, state_set* prop_q, model* model) {
-    state_set not_p, not_q, eu_not_p_not_q, eg_not_q;
+// E[P U Q] (EF Q if prop_p is NULL) by one backward search from Q over the
+// predecessor index: linear in the model, where the layered version above
+// rescans every transition each round
+void ctl_eval_eu_backward(state_set* result, state_set* prop_p, state_set* prop_q, model* model) {
+    int queue[MAX_STATES];
+    int head = 0, tail = 0;
     
-    // Calculate ¬P and ¬Q
-    ctl_complement_state_set(&not_p, prop_p, model->num_states);
-    ctl_complement_state_set(&not_q, prop_q, model->num_states);
+    ctl_init_state_set(result, model->num_states);
+    if (!build_predecessor_index(model)) {
+        return;
+    }
+    
+    for (int i = 0; i < model->num_states; i++) {
+        if (prop_q->members[i]) {
+            ctl_add_to_state_set(result, i);
+            queue[tail++] = i;
+        }
+    }
+    while (head < tail) {
+        int current = queue[head++];
+        model->edges_scanned += model->pred_start[current + 1] - model->pred_start[current];
+        for (int k = model->pred_start[current]; k < model->pred_start[current + 1]; k++) {
+            int pred_id = model->pred_list[k];
+            if (!result->members[pred_id] && (prop_p == NULL || prop_p->members[pred_id])) {
+                ctl_add_to_state_set(result, pred_id);
+                queue[tail++] = pred_id;
+            }
+        }
+    }
+    model->iterations += tail;
+}
+
+// Evaluate AU P Q (always until) - states where all paths reach Q through P
+// states: the least fixpoint μZ. Q ∨ (P ∧ AX Z), computed backwards from Q.
+// A state joins once every successor has joined; deadlock states join only
+// through Q, since their one path ends there.
+void ctl_eval_au(state_set* result, state_set* prop_p, state_set* prop_q, model* model) {
+    int pending[MAX_STATES];    // Successors not yet in the result
+    int worklist[MAX_STATES];
+    int count = 0;
     
-    // Calculate E[¬P U (¬P ∧ ¬Q)]
-    ctl_intersect_state_sets(&eu_not_p_not_q, &not_p, &not_q);
-    ctl_eval_eu(&eu_not_p_not_q, &not_p, &eu_not_p_not_q, model);
+    ctl_init_state_set(result, model->num_states);
+    if (!build_predecessor_index(model)) {
+        return;
+    }
     
-    // Calculate EG ¬Q
-    ctl_eval_eg(&eg_not_q, &not_q, model);
+    for (int i = 0; i < model->num_states; i++) {
+        pending[i] = model->states[i].num_transitions;
+        if (prop_q->members[i]) {
+            ctl_add_to_state_set(result, i);
+            worklist[count++] = i;
+        }
+    }
     
-    // A[P U Q] = ¬(E[¬P U (¬P ∧ ¬Q)] ∨ EG ¬Q)
-    state_set temp;
-    ctl_union_state_sets(&temp, &eu_not_p_not_q, &eg_not_q);
-    ctl_complement_state_set(result, &temp, model->num_states);
+    while (count > 0) {
+        int state_id = worklist[--count];
+        model->iterations++;
+        model->edges_scanned += model->pred_start[state_id + 1] - model->pred_start[state_id];
+        for (int k = model->pred_start[state_id]; k < model->pred_start[state_id + 1]; k++) {
+            int pred_id = model->pred_list[k];
+            if (--pending[pred_id] == 0 && !result->members[pred_id] && prop_p->members[pred_id]) {
+                ctl_add_to_state_set(result, pred_id);
+                worklist[count++] = pred_id;
+            }
+        }
+    }
 }
 
-// Parse a formula
-void ctl_parse_formula(const char* formula, state_set* result, model* model) {
-    lexer lex;
-    init_lexer(&lex, formula);
+// Greatest fixpoint shared by weak until and release, computed by removing
+// states until none fails its condition:
+//   weak until  νZ. Q ∨ (P ∧ X Z)
+//   release     νZ. Q ∧ (P ∨ X Z)
+// with X = EX (universal false) or AX (universal true). A deadlock state
+// satisfies X Z here: its one path ends, so the weak obligation is met.
+static void eval_weak_fixpoint(state_set* result, state_set* prop_p, state_set* prop_q,
+                               model* model, bool universal, bool release) {
+    int inside[MAX_STATES];     // Successors still in Z
+    int worklist[MAX_STATES];
+    int count = 0;
+    
+    ctl_init_state_set(result, model->num_states);
+    if (!build_predecessor_index(model)) {
+        return;
+    }
     
-    state_set* temp_result = parse_expression(&lex, model);
+    // States that satisfy the condition without X Z
+    state_set settled;
+    ctl_init_state_set(&settled, model->num_states);
+    for (int i = 0; i < model->num_states; i++) {
+        bool p = prop_p->members[i], q = prop_q->members[i];
+        if (release ? (q && p) : q) {
+            ctl_add_to_state_set(&settled, i);
+        }
+        if (release ? q : (q || p)) {
+            ctl_add_to_state_set(result, i);
+        }
+    }
     
-    // Copy the result to the output parameter
-    ctl_copy_state_set(result, temp_result);
+    for (int i = 0; i < model->num_states; i++) {
+        state* current_state = &model->states[i];
+        inside[i] = 0;
+        for (int j = 0; j < current_state->num_transitions; j++) {
+            if (result->members[current_state->transitions[j]]) {
+                inside[i]++;
+            }
+        }
+        model->edges_scanned += current_state->num_transitions;
+    }
     
-    // Free the temporary result
-    free(temp_result);
+    // Remove a state of Z when X Z fails for it and it is not settled
+    for (int i = 0; i < model->num_states; i++) {
+        int num_transitions = model->states[i].num_transitions;
+        bool next_fails = universal ? inside[i] < num_transitions : inside[i] == 0;
+        if (result->members[i] && !settled.members[i] && num_transitions > 0 && next_fails) {
+            result->members[i] = false;
+            result->size--;
+            worklist[count++] = i;
+        }
+    }
     
-    // Check if we've consumed the whole formula
-    token current_token = get_next_token(&lex);
-    if (current_token.type != TOKEN_EOF) {
-        fprintf(stderr, "Warning: Unconsumed input at the end of formula: %s\n", current_token.value);
+    while (count > 0) {
+        int state_id = worklist[--count];
+        model->iterations++;
+        model->edges_scanned += model->pred_start[state_id + 1] - model->pred_start[state_id];
+        for (int k = model->pred_start[state_id]; k < model->pred_start[state_id + 1]; k++) {
+            int pred_id = model->pred_list[k];
+            inside[pred_id]--;
+            if (!result->members[pred_id] || settled.members[pred_id]) continue;
+            if (universal || inside[pred_id] == 0) {
+                result->members[pred_id] = false;
+                result->size--;
+                worklist[count++] = pred_id;
+            }
+        }
     }
 }
 
-// Parse an expression (lowest precedence: OR)
-state_set* parse_expression(lexer* lexer, model* model) {
-    state_set* left = parse_term(lexer, model);
-    token current_token = get_next_token(lexer);
-    
-    while (current_token.type == TOKEN_OR) {
-        state_set* right = parse_term(lexer, model);
-        state_set* result = malloc(sizeof(state_set));
-        ctl_init_state_set(result, model->num_states);
-        ctl_union_state_sets(result, left, right);
-        
-        free(left);
-        free(right);
-        left = result;
-        
-        current_token = get_next_token(lexer);
+// Evaluate EW P Q (exists weak until) - E[P U Q] or a path staying in P
+void ctl_eval_ew(state_set* result, state_set* prop_p, state_set* prop_q, model* model) {
+    eval_weak_fixpoint(result, prop_p, prop_q, model, false, false);
+}
+
+// Evaluate AW P Q (always weak until) - on every path P holds until Q, if ever
+void ctl_eval_aw(state_set* result, state_set* prop_p, state_set* prop_q, model* model) {
+    eval_weak_fixpoint(result, prop_p, prop_q, model, true, false);
+}
+
+// Evaluate ER P Q (exists release) - a path where Q holds up to and including
+// the first P state, or forever
+void ctl_eval_er(state_set* result, state_set* prop_p, state_set* prop_q, model* model) {
+    eval_weak_fixpoint(result, prop_p, prop_q, model, false, true);
+}
+
+// Evaluate AR P Q (always release) - Q holds up to and including the first P
+// state on every path, or forever
+void ctl_eval_ar(state_set* result, state_set* prop_p, state_set* prop_q, model* model) {
+    eval_weak_fixpoint(result, prop_p, prop_q, model, true, true);
+}
+
+/* Fairness Constraints */
+
+// Add a fairness constraint: fair paths visit these states infinitely often
+int ctl_add_fairness_constraint(model* model, state_set* states) {
+    if (model->num_fairness >= MAX_FAIRNESS) {
+        fprintf(stderr, "Error: Maximum number of fairness constraints reached\n");
+        return -1;
     }
     
-    // Put back the token that's not part of this expression
-    lexer->position -= strlen(current_token.value);
+    ctl_copy_state_set(&model->fairness[model->num_fairness], states);
+    return model->num_fairness++;
+}
+
+// Add a fairness constraint given as a formula (evaluated without fairness);
+// -1 if the formula does not parse
+int ctl_add_fairness_formula(model* model, const char* formula) {
+    state_set states;
+    int saved = model->num_fairness;
     
-    return left;
+    model->num_fairness = 0;
+    bool parsed = ctl_parse_formula(formula, &states, model);
+    model->num_fairness = saved;
+    
+    return parsed ? ctl_add_fairness_constraint(model, &states) : -1;
 }
 
-// Parse a term (AND has higher precedence than OR)
-state_set* parse_term(lexer* lexer, model* model) {
-    state_set* left = parse_factor(lexer, model);
-    token current_token = get_next_token(lexer);
+void ctl_clear_fairness_constraints(model* model) {
+    model->num_fairness = 0;
+}
+
+// Working state of Tarjan's algorithm on the subgraph induced by a state set
+typedef struct {
+    model* model;
+    state_set* allowed;
+    int next_order;
+    int order[MAX_STATES];           // Discovery order, -1 if unvisited
+    int low[MAX_STATES];
+    bool on_stack[MAX_STATES];
+    int stack[MAX_STATES];
+    int stack_top;
+    state_set* fair_core;            // Receives the fair SCCs
+} scc_search;
+
+// Is the component just popped (stack[from] .. stack[top - 1]) a fair SCC?
+// It must contain a cycle and meet every fairness constraint.
+static bool is_fair_component(scc_search* search, int from) {
+    model* model = search->model;
+    int size = search->stack_top - from;
     
-    while (current_token.type == TOKEN_AND) {
-        state_set* right = parse_factor(lexer, model);
-        state_set* result = malloc(sizeof(state_set));
-        ctl_init_state_set(result, model->num_states);
-        ctl_intersect_state_sets(result, left, right);
-        
-        free(left);
-        free(right);
-        left = result;
-        
-        current_token = get_next_token(lexer);
+    if (size == 1) {
+        int only = search->stack[from];
+        bool self_loop = false;
+        for (int j = 0; j < model->states[only].num_transitions; j++) {
+            if (model->states[only].transitions[j] == only) self_loop = true;
+        }
+        if (!self_loop) return false;
     }
     
-    // Put back the token that's not part of this term
-    lexer->position -= strlen(current_token.value);
-    
-    return left;
+    for (int c = 0; c < model->num_fairness; c++) {
+        bool met = false;
+        for (int k = from; k < search->stack_top && !met; k++) {
+            met = model->fairness[c].members[search->stack[k]];
+        }
+        if (!met) return false;
+    }
+    return true;
 }
 
-// Parse a factor (highest precedence: NOT, EX, AX, etc.)
-state_set* parse_factor(lexer* lexer, model* model) {
-    token current_token = get_next_token(lexer);
+static void fair_scc_visit(scc_search* search, int state_id) {
+    state* current_state = &search->model->states[state_id];
     
-    if (current_token.type == TOKEN_LPAREN) {
-        // Handle parenthesized expressions
-        state_set* result = parse_expression(lexer, model);
-        current_token = get_next_token(lexer);
-        
-        if (current_token.type != TOKEN_RPAREN) {
-            fprintf(stderr, "Error: Expected closing parenthesis, got %s\n", current_token.value);
-            free(result);
-            exit(1);
+    search->order[state_id] = search->low[state_id] = search->next_order++;
+    search->stack[search->stack_top++] = state_id;
+    search->on_stack[state_id] = true;
+    search->model->edges_scanned += current_state->num_transitions;
+    
+    for (int j = 0; j < current_state->num_transitions; j++) {
+        int successor_id = current_state->transitions[j];
+        if (!search->allowed->members[successor_id]) continue;
+        if (search->order[successor_id] < 0) {
+            fair_scc_visit(search, successor_id);
+            if (search->low[successor_id] < search->low[state_id]) {
+                search->low[state_id] = search->low[successor_id];
+            }
+        } else if (search->on_stack[successor_id] && search->order[successor_id] < search->low[state_id]) {
+            search->low[state_id] = search->order[successor_id];
         }
+    }
+    
+    if (search->low[state_id] == search->order[state_id]) {
+        int from = search->stack_top;
+        do {
+            from--;
+        } while (search->stack[from] != state_id);
         
-        return result;
-    } else if (current_token.type == TOKEN_NOT) {
-        // Handle negation
-        state_set* operand = parse_factor(lexer, model);
-        state_set* result = malloc(sizeof(state_set));
-        ctl_init_state_set(result, model->num_states);
-        ctl_complement_state_set(result, operand, model->num_states);
-        
-        free(operand);
-        return result;
-    } else if (current_token.type == TOKEN_EX || current_token.type == TOKEN_AX ||
-               current_token.type == TOKEN_EF || current_token.type == TOKEN_AF ||
-               current_token.type == TOKEN_EG || current_token.type == TOKEN_AG) {
-        // Handle unary CTL operators
-        state_set* operand = parse_factor(lexer, model);
-        state_set* result = malloc(sizeof(state_set));
+        bool fair = is_fair_component(search, from);
+        while (search->stack_top > from) {
+            int member = search->stack[--search->stack_top];
+            search->on_stack[member] = false;
+            if (fair) {
+                ctl_add_to_state_set(search->fair_core, member);
+            }
+        }
+    }
+}
+
+// Fair EG P: the P states from which a P-path leads into a fair SCC of the
+// P-subgraph. One SCC pass plus one backward search, i.e. linear in the model
+// for each fairness constraint.
+void ctl_eval_fair_eg(state_set* result, state_set* prop_p, model* model) {
+    if (model->num_fairness == 0) {
+        ctl_eval_eg(result, prop_p, model);
+        return;
+    }
+    
+    scc_search* search = malloc(sizeof(scc_search));
+    state_set fair_core;
+    if (search == NULL || !build_predecessor_index(model)) {
+        fprintf(stderr, "Error: Memory allocation failed for fair EG\n");
+        free(search);
         ctl_init_state_set(result, model->num_states);
-        
-        switch (current_token.type) {
-            case TOKEN_EX:
-                ctl_existential_successor(result, operand, model);
-                break;
-            case TOKEN_AX:
-                ctl_universal_successor(result, operand, model);
-                break;
-            case TOKEN_EF:
-                ctl_eval_ef(result, operand, model);
-                break;
-            case TOKEN_AF:
-                ctl_eval_af(result, operand, model);
-                break;
-            case TOKEN_EG:
-                ctl_eval_eg(result, operand, model);
-                break;
-            case TOKEN_AG:
-                ctl_eval_ag(result, operand, model);
-                break;
-            default:
-                fprintf(stderr, "Error: Unhandled unary operator: %s\n", current_token.value);
-                exit(1);
+        return;
+    }
+    
+    ctl_init_state_set(&fair_core, model->num_states);
+    search->model = model;
+    search->allowed = prop_p;
+    search->next_order = 0;
+    search->stack_top = 0;
+    search->fair_core = &fair_core;
+    for (int i = 0; i < model->num_states; i++) {
+        search->order[i] = -1;
+        search->on_stack[i] = false;
+    }
+    for (int i = 0; i < model->num_states; i++) {
+        if (prop_p->members[i] && search->order[i] < 0) {
+            fair_scc_visit(search, i);
         }
-        
-        free(operand);
-        return result;
-    } else if (current_token.type == TOKEN_EU || current_token.type == TOKEN_AU) {
-        // Handle binary CTL operators
-        token op_token = current_token;
-        
-        // Check for opening parenthesis
-        current_token = get_next_token(lexer);
-        if (current_token.type != TOKEN_LPAREN) {
-            fprintf(stderr, "Error: Expected opening parenthesis after %s, got %s\n", op_token.value, current_token.value);
-            exit(1);
+    }
+    free(search);
+    
+    // Backward search within P from the fair SCCs
+    int queue[MAX_STATES];
+    int head = 0, tail = 0;
+    ctl_init_state_set(result, model->num_states);
+    for (int i = 0; i < model->num_states; i++) {
+        if (fair_core.members[i]) {
+            ctl_add_to_state_set(result, i);
+            queue[tail++] = i;
         }
-        
-        // Parse first operand
-        state_set* left = parse_expression(lexer, model);
-        
-        // Check for comma
-        current_token = get_next_token(lexer);
-        if (current_token.type != TOKEN_COMMA) {
-            fprintf(stderr, "Error: Expected comma in %s operator, got %s\n", op_token.value, current_token.value);
-            free(left);
-            exit(1);
+    }
+    while (head < tail) {
+        int current = queue[head++];
+        model->edges_scanned += model->pred_start[current + 1] - model->pred_start[current];
+        for (int k = model->pred_start[current]; k < model->pred_start[current + 1]; k++) {
+            int predecessor_id = model->pred_list[k];
+            if (prop_p->members[predecessor_id] && !result->members[predecessor_id]) {
+                ctl_add_to_state_set(result, predecessor_id);
+                queue[tail++] = predecessor_id;
+            }
         }
-        
-        // Parse second operand
-        state_set* right = parse_expression(lexer, model);
-        
-        // Check for closing parenthesis
-        current_token = get_next_token(lexer);
-        if (current_token.type != TOKEN_RPAREN) {
-            fprintf(stderr, "Error: Expected closing parenthesis after %s operands, got %s\n", op_token.value, current_token.value);
-            free(left);
-            free(right);
-            exit(1);
+    }
+    model->iterations += tail;
+}
+
+// States from which some fair path starts (fair EG true)
+void ctl_eval_fair_states(state_set* result, model* model) {
+    state_set none, all;
+    ctl_init_state_set(&none, model->num_states);
+    ctl_complement_state_set(&all, &none, model->num_states);
+    ctl_eval_fair_eg(result, &all, model);
+}
+
+// Fair EX P = EX (P ∧ fair)
+void ctl_eval_fair_ex(state_set* result, state_set* prop_p, model* model) {
+    if (model->num_fairness == 0) {
+        ctl_existential_successor(result, prop_p, model);
+        return;
+    }
+    
+    state_set fair, target;
+    ctl_eval_fair_states(&fair, model);
+    ctl_intersect_state_sets(&target, prop_p, &fair);
+    ctl_existential_successor(result, &target, model);
+}
+
+// Fair E[P U Q] = E[P U (Q ∧ fair)]
+void ctl_eval_fair_eu(state_set* result, state_set* prop_p, state_set* prop_q, model* model) {
+    if (model->num_fairness == 0) {
+        ctl_eval_eu(result, prop_p, prop_q, model);
+        return;
+    }
+    
+    state_set fair, target;
+    ctl_eval_fair_states(&fair, model);
+    ctl_intersect_state_sets(&target, prop_q, &fair);
+    ctl_eval_eu(result, prop_p, &target, model);
+}
+
+// Fair EF P = EF (P ∧ fair)
+void ctl_eval_fair_ef(state_set* result, state_set* prop_p, model* model) {
+    if (model->num_fairness == 0) {
+        ctl_eval_ef(result, prop_p, model);
+        return;
+    }
+    
+    state_set fair, target;
+    ctl_eval_fair_states(&fair, model);
+    ctl_intersect_state_sets(&target, prop_p, &fair);
+    ctl_eval_ef(result, &target, model);
+}
+
+// Fair AX P = ¬ fair EX ¬P
+void ctl_eval_fair_ax(state_set* result, state_set* prop_p, model* model) {
+    if (model->num_fairness == 0) {
+        ctl_universal_successor(result, prop_p, model);
+        return;
+    }
+    
+    state_set not_p, ex_not_p;
+    ctl_complement_state_set(&not_p, prop_p, model->num_states);
+    ctl_eval_fair_ex(&ex_not_p, &not_p, model);
+    ctl_complement_state_set(result, &ex_not_p, model->num_states);
+}
+
+// Fair AF P = ¬ fair EG ¬P
+void ctl_eval_fair_af(state_set* result, state_set* prop_p, model* model) {
+    if (model->num_fairness == 0) {
+        ctl_eval_af(result, prop_p, model);
+        return;
+    }
+    
+    state_set not_p, eg_not_p;
+    ctl_complement_state_set(&not_p, prop_p, model->num_states);
+    ctl_eval_fair_eg(&eg_not_p, &not_p, model);
+    ctl_complement_state_set(result, &eg_not_p, model->num_states);
+}
+
+// Fair AG P = ¬ fair EF ¬P
+void ctl_eval_fair_ag(state_set* result, state_set* prop_p, model* model) {
+    if (model->num_fairness == 0) {
+        ctl_eval_ag(result, prop_p, model);
+        return;
+    }
+    
+    state_set not_p, ef_not_p;
+    ctl_complement_state_set(&not_p, prop_p, model->num_states);
+    ctl_eval_fair_ef(&ef_not_p, &not_p, model);
+    ctl_complement_state_set(result, &ef_not_p, model->num_states);
+}
+
+// Fair A[P U Q] = ¬(fair E[¬Q U (¬P ∧ ¬Q)] ∨ fair EG ¬Q)
+void ctl_eval_fair_au(state_set* result, state_set* prop_p, state_set* prop_q, model* model) {
+    if (model->num_fairness == 0) {
+        ctl_eval_au(result, prop_p, prop_q, model);
+        return;
+    }
+    
+    state_set not_p, not_q, not_p_not_q, eu, eg_not_q, either;
+    ctl_complement_state_set(&not_p, prop_p, model->num_states);
+    ctl_complement_state_set(&not_q, prop_q, model->num_states);
+    ctl_intersect_state_sets(&not_p_not_q, &not_p, &not_q);
+    ctl_eval_fair_eu(&eu, &not_q, &not_p_not_q, model);
+    ctl_eval_fair_eg(&eg_not_q, &not_q, model);
+    ctl_union_state_sets(&either, &eu, &eg_not_q);
+    ctl_complement_state_set(result, &either, model->num_states);
+}
+
+// Fair E[P W Q] = fair E[P U Q] ∨ fair EG P
+void ctl_eval_fair_ew(state_set* result, state_set* prop_p, state_set* prop_q, model* model) {
+    if (model->num_fairness == 0) {
+        ctl_eval_ew(result, prop_p, prop_q, model);
+        return;
+    }
+    
+    state_set eu, eg_p;
+    ctl_eval_fair_eu(&eu, prop_p, prop_q, model);
+    ctl_eval_fair_eg(&eg_p, prop_p, model);
+    ctl_union_state_sets(result, &eu, &eg_p);
+}
+
+// Fair A[P W Q] = ¬ fair E[¬Q U (¬P ∧ ¬Q)]
+void ctl_eval_fair_aw(state_set* result, state_set* prop_p, state_set* prop_q, model* model) {
+    if (model->num_fairness == 0) {
+        ctl_eval_aw(result, prop_p, prop_q, model);
+        return;
+    }
+    
+    state_set not_p, not_q, not_p_not_q, eu;
+    ctl_complement_state_set(&not_p, prop_p, model->num_states);
+    ctl_complement_state_set(&not_q, prop_q, model->num_states);
+    ctl_intersect_state_sets(&not_p_not_q, &not_p, &not_q);
+    ctl_eval_fair_eu(&eu, &not_q, &not_p_not_q, model);
+    ctl_complement_state_set(result, &eu, model->num_states);
+}
+
+// Fair E[P R Q] = fair E[Q U (P ∧ Q)] ∨ fair EG Q
+void ctl_eval_fair_er(state_set* result, state_set* prop_p, state_set* prop_q, model* model) {
+    if (model->num_fairness == 0) {
+        ctl_eval_er(result, prop_p, prop_q, model);
+        return;
+    }
+    
+    state_set p_q, eu, eg_q;
+    ctl_intersect_state_sets(&p_q, prop_p, prop_q);
+    ctl_eval_fair_eu(&eu, prop_q, &p_q, model);
+    ctl_eval_fair_eg(&eg_q, prop_q, model);
+    ctl_union_state_sets(result, &eu, &eg_q);
+}
+
+// Fair A[P R Q] = ¬ fair E[¬P U ¬Q]
+void ctl_eval_fair_ar(state_set* result, state_set* prop_p, state_set* prop_q, model* model) {
+    if (model->num_fairness == 0) {
+        ctl_eval_ar(result, prop_p, prop_q, model);
+        return;
+    }
+    
+    state_set not_p, not_q, eu;
+    ctl_complement_state_set(&not_p, prop_p, model->num_states);
+    ctl_complement_state_set(&not_q, prop_q, model->num_states);
+    ctl_eval_fair_eu(&eu, &not_p, &not_q, model);
+    ctl_complement_state_set(result, &eu, model->num_states);
+}
+
+// Evaluate a formula; false (with an empty result) if it does not parse
+bool ctl_parse_formula(const char* formula, state_set* result, model* model) {
+    ctl_parse_error error;
+    ctl_init_state_set(result, model->num_states);
+    
+    ctl_plan* plan = ctl_create_plan(model);
+    if (plan == NULL) {
+        return false;
+    }
+    int root = ctl_compile_formula(plan, formula, &error);
+    if (root >= 0) {
+        ctl_decompress_state_set(result, ctl_eval_plan_node(plan, root), model->num_states);
+    } else {
+        ctl_print_parse_error(formula, &error, stderr);
+    }
+    ctl_free_plan(plan);
+    return root >= 0;
+}
+
+// Compile a formula into plan nodes; returns its root node, or -1 with the
+// position and reason in error. Nodes made before the error stay in the
+// plan, unused, and so do the results the plan already holds.
+int ctl_compile_formula(ctl_plan* plan, const char* formula, ctl_parse_error* error) {
+    lexer lex;
+    init_lexer(&lex, formula, error);
+    
+    int root = parse_expression(&lex, plan);
+    
+    // The whole formula must be consumed
+    const token* current_token = peek_token(&lex);
+    if (root >= 0 && current_token->type != TOKEN_EOF) {
+        return syntax_error(&lex, current_token, "Expected an operator or the end of the formula");
+    }
+    return root;
+}
+
+// Print a parse error with the formula and a caret under the position
+void ctl_print_parse_error(const char* formula, ctl_parse_error* error, FILE* out) {
+    fprintf(out, "Error: %s (column %d)\n", error->message, error->position + 1);
+    fprintf(out, "  %s\n  %*s^\n", formula, error->position, "");
+}
+
+// Node for an operator (-1 once the parse has failed or memory runs out).
+// Long chains of binary operators nest without recursing in the parser, so
+// the depth limit is also checked on the nodes.
+static int plan_node(lexer* lexer, ctl_plan* plan, ctl_op op, int left, int right, int prop_id) {
+    if (lexer->error->position >= 0) {
+        return -1;
+    }
+    int node = ctl_plan_make_node(plan, op, left, right, prop_id);
+    if (node < 0) {
+        return syntax_error(lexer, peek_token(lexer), "Out of memory for the plan");
+    }
+    if (plan->nodes[node].depth > CTL_MAX_FORMULA_DEPTH) {
+        return syntax_error(lexer, peek_token(lexer), "Formula nested deeper than %d levels",
+                            CTL_MAX_FORMULA_DEPTH);
+    }
+    return node;
+}
+
+// Enter one more level of parser recursion; false (with a syntax error at
+// the next token) past the depth limit. Leave it with lexer->depth--.
+static bool enter_nesting(lexer* lexer) {
+    if (lexer->depth >= CTL_MAX_FORMULA_DEPTH) {
+        syntax_error(lexer, peek_token(lexer), "Formula nested deeper than %d levels", CTL_MAX_FORMULA_DEPTH);
+        return false;
+    }
+    lexer->depth++;
+    return true;
+}
+
+// Plan operator of an operator token
+static ctl_op token_operator(token_type type) {
+    switch (type) {
+        case TOKEN_AND:     return CTL_OP_AND;
+        case TOKEN_OR:      return CTL_OP_OR;
+        case TOKEN_IMPLIES: return CTL_OP_IMPLIES;
+        case TOKEN_IFF:     return CTL_OP_IFF;
+        case TOKEN_EX:      return CTL_OP_EX;
+        case TOKEN_AX:      return CTL_OP_AX;
+        case TOKEN_EF:      return CTL_OP_EF;
+        case TOKEN_AF:      return CTL_OP_AF;
+        case TOKEN_EG:      return CTL_OP_EG;
+        case TOKEN_AG:      return CTL_OP_AG;
+        case TOKEN_EU:      return CTL_OP_EU;
+        case TOKEN_AU:      return CTL_OP_AU;
+        case TOKEN_EW:      return CTL_OP_EW;
+        case TOKEN_AW:      return CTL_OP_AW;
+        case TOKEN_ER:      return CTL_OP_ER;
+        case TOKEN_AR:      return CTL_OP_AR;
+        default:            return CTL_OP_NOT;
+    }
+}
+
+// Parse an expression (lowest precedence: <->, left associative)
+int parse_expression(lexer* lexer, ctl_plan* plan) {
+    int left = parse_implication(lexer, plan);
+    
+    while (left >= 0 && peek_token(lexer)->type == TOKEN_IFF) {
+        get_next_token(lexer);
+        int right = parse_implication(lexer, plan);
+        left = plan_node(lexer, plan, CTL_OP_IFF, left, right, -1);
+    }
+    
+    return left;
+}
+
+// Parse an implication (-> binds looser than OR, right associative)
+int parse_implication(lexer* lexer, ctl_plan* plan) {
+    int left = parse_disjunction(lexer, plan);
+    
+    if (left >= 0 && peek_token(lexer)->type == TOKEN_IMPLIES) {
+        get_next_token(lexer);
+        if (!enter_nesting(lexer)) {
+            return -1;
         }
+        int right = parse_implication(lexer, plan);
+        lexer->depth--;
+        left = plan_node(lexer, plan, CTL_OP_IMPLIES, left, right, -1);
+    }
+    
+    return left;
+}
+
+// Parse a disjunction (OR)
+int parse_disjunction(lexer* lexer, ctl_plan* plan) {
+    int left = parse_term(lexer, plan);
+    
+    while (left >= 0 && peek_token(lexer)->type == TOKEN_OR) {
+        get_next_token(lexer);
+        int right = parse_term(lexer, plan);
+        left = plan_node(lexer, plan, CTL_OP_OR, left, right, -1);
+    }
+    
+    return left;
+}
+
+// Parse a term (AND has higher precedence than OR)
+int parse_term(lexer* lexer, ctl_plan* plan) {
+    int left = parse_factor(lexer, plan);
+    
+    while (left >= 0 && peek_token(lexer)->type == TOKEN_AND) {
+        get_next_token(lexer);
+        int right = parse_factor(lexer, plan);
+        left = plan_node(lexer, plan, CTL_OP_AND, left, right, -1);
+    }
+    
+    return left;
+}
+
+// Parse the "(P, Q)" operands of EU/AU
+static bool parse_until_operands(lexer* lexer, ctl_plan* plan, token* op_token, int* left, int* right) {
+    // Check for opening parenthesis
+    token current_token = get_next_token(lexer);
+    if (current_token.type != TOKEN_LPAREN) {
+        syntax_error(lexer, &current_token, "Expected ( after %.*s", TOKEN_TEXT(*op_token));
+        return false;
+    }
+    
+    // Parse first operand
+    *left = parse_expression(lexer, plan);
+    if (*left < 0) return false;
+    
+    // Check for comma
+    current_token = get_next_token(lexer);
+    if (current_token.type != TOKEN_COMMA) {
+        syntax_error(lexer, &current_token, "Expected , in %.*s(...)", TOKEN_TEXT(*op_token));
+        return false;
+    }
+    
+    // Parse second operand
+    *right = parse_expression(lexer, plan);
+    if (*right < 0) return false;
+    
+    // Check for closing parenthesis
+    current_token = get_next_token(lexer);
+    if (current_token.type != TOKEN_RPAREN) {
+        syntax_error(lexer, &current_token, "Expected ) after %.*s operands", TOKEN_TEXT(*op_token));
+        return false;
+    }
+    return true;
+}
+
+// Parse the "[P U Q]", "[P W Q]" or "[P R Q]" after an E or A path
+// quantifier, turning op_token into the matching binary operator
+static bool parse_path_operands(lexer* lexer, ctl_plan* plan, token* op_token, int* left, int* right) {
+    bool exists = (op_token->type == TOKEN_E);
+    
+    token current_token = get_next_token(lexer);
+    if (current_token.type != TOKEN_LBRACKET) {
+        syntax_error(lexer, &current_token, "Expected [ after %.*s", TOKEN_TEXT(*op_token));
+        return false;
+    }
+    
+    *left = parse_expression(lexer, plan);
+    if (*left < 0) return false;
+    
+    // The operator letter arrives as a proposition token
+    current_token = get_next_token(lexer);
+    if (token_is(&current_token, "U")) {
+        op_token->type = exists ? TOKEN_EU : TOKEN_AU;
+    } else if (token_is(&current_token, "W")) {
+        op_token->type = exists ? TOKEN_EW : TOKEN_AW;
+    } else if (token_is(&current_token, "R")) {
+        op_token->type = exists ? TOKEN_ER : TOKEN_AR;
+    } else {
+        syntax_error(lexer, &current_token, "Expected U, W or R in %.*s[...]", TOKEN_TEXT(*op_token));
+        return false;
+    }
+    
+    *right = parse_expression(lexer, plan);
+    if (*right < 0) return false;
+    
+    current_token = get_next_token(lexer);
+    if (current_token.type != TOKEN_RBRACKET) {
+        syntax_error(lexer, &current_token, "Expected ] after %.*s[...] operands", TOKEN_TEXT(*op_token));
+        return false;
+    }
+    return true;
+}
+
+// Parse a factor (highest precedence: NOT, EX, AX, etc.)
+static int parse_nested_factor(lexer* lexer, ctl_plan* plan) {
+    token current_token = get_next_token(lexer);
+    
+    if (current_token.type == TOKEN_LPAREN) {
+        // Handle parenthesized expressions
+        int result = parse_expression(lexer, plan);
+        if (result < 0) {
+            return -1;
+        }
+        current_token = get_next_token(lexer);
         
-        // Evaluate the binary operator
-        state_set* result = malloc(sizeof(state_set));
-        ctl_init_state_set(result, model->num_states);
-        
-        if (op_token.type == TOKEN_EU) {
-            ctl_eval_eu(result, left, right, model);
-        } else { // TOKEN_AU
-            ctl_eval_au(result, left, right, model);
+        if (current_token.type != TOKEN_RPAREN) {
+            return syntax_error(lexer, &current_token, "Expected closing parenthesis");
         }
         
-        free(left);
-        free(right);
         return result;
+    } else if (current_token.type == TOKEN_NOT) {
+        // Handle negation
+        int operand = parse_factor(lexer, plan);
+        return plan_node(lexer, plan, CTL_OP_NOT, operand, -1, -1);
+    } else if (current_token.type == TOKEN_EX || current_token.type == TOKEN_AX ||
+               current_token.type == TOKEN_EF || current_token.type == TOKEN_AF ||
+               current_token.type == TOKEN_EG || current_token.type == TOKEN_AG) {
+        // Handle unary CTL operators
+        int operand = parse_factor(lexer, plan);
+        return plan_node(lexer, plan, token_operator(current_token.type), operand, -1, -1);
+    } else if (current_token.type == TOKEN_EU || current_token.type == TOKEN_AU ||
+               current_token.type == TOKEN_EW || current_token.type == TOKEN_AW ||
+               current_token.type == TOKEN_ER || current_token.type == TOKEN_AR ||
+               current_token.type == TOKEN_E || current_token.type == TOKEN_A) {
+        // Handle binary CTL operators, as OP(P, Q) or E[P OP Q] / A[P OP Q]
+        token op_token = current_token;
+        int left, right;
+        bool parsed = (op_token.type == TOKEN_E || op_token.type == TOKEN_A)
+            ? parse_path_operands(lexer, plan, &op_token, &left, &right)
+            : parse_until_operands(lexer, plan, &op_token, &left, &right);
+        if (!parsed) {
+            return -1;
+        }
+        return plan_node(lexer, plan, token_operator(op_token.type), left, right, -1);
+    } else if (current_token.type == TOKEN_TRUE) {
+        return plan_node(lexer, plan, CTL_OP_TRUE, -1, -1, -1);
+    } else if (current_token.type == TOKEN_FALSE) {
+        return plan_node(lexer, plan, CTL_OP_FALSE, -1, -1, -1);
     } else if (current_token.type == TOKEN_PROP) {
-        // Handle atomic propositions
-        state_set* result = malloc(sizeof(state_set));
-        ctl_init_state_set(result, model->num_states);
-        ctl_eval_atomic_prop_by_name(result, model, current_token.value);
-        return result;
+        // Handle atomic propositions (which the model must define)
+        int prop_id = find_proposition(plan->model, current_token.start, current_token.length);
+        if (prop_id < 0) {
+            return syntax_error(lexer, &current_token, "Expected a proposition of the model");
+        }
+        return plan_node(lexer, plan, CTL_OP_PROP, -1, -1, prop_id);
     } else {
-        fprintf(stderr, "Error: Unexpected token: %s\n", current_token.value);
-        exit(1);
+        return syntax_error(lexer, &current_token, "Expected a formula");
+    }
+}
+
+// Parse a factor, one level deeper (parentheses and prefix operators recurse here)
+int parse_factor(lexer* lexer, ctl_plan* plan) {
+    if (!enter_nesting(lexer)) {
+        return -1;
+    }
+    int node = parse_nested_factor(lexer, plan);
+    lexer->depth--;
+    return node;
+}
+
+/* Cone-of-Influence Reduction */
+
+// Mark the propositions of the model that the formula mentions (marks are
+// added to `used`, so the propositions of several formulas can be collected)
+void ctl_formula_propositions(const char* formula, model* model, bool* used) {
+    lexer lex;
+    ctl_parse_error error;
+    init_lexer(&lex, formula, &error);
+    
+    token current_token = get_next_token(&lex);
+    while (current_token.type != TOKEN_EOF) {
+        if (current_token.type == TOKEN_PROP) {
+            int prop_id = find_proposition(model, current_token.start, current_token.length);
+            if (prop_id >= 0) {
+                used[prop_id] = true;
+            }
+        }
+        current_token = get_next_token(&lex);
+    }
+}
+
+// Build the part of the model a set of formulas depends on: the states
+// reachable from from_state (from the initial states if from_state < 0),
+// labelled with the propositions in used_props (all if NULL). The reachable
+// fragment is closed under successors, so every CTL formula has the same
+// value on it as in the full model. Dropping propositions alone saves no
+// work, so if every state is reachable reduction->reduced is left NULL and
+// the model itself is to be checked. Returns false on errors.
+bool ctl_reduce_model(ctl_reduction* reduction, model* model, const bool* used_props, int from_state) {
+    int queue[MAX_STATES];
+    int head = 0, tail = 0;
+    
+    if (from_state >= model->num_states) {
+        fprintf(stderr, "Error: Invalid state ID: %d\n", from_state);
+        return false;
+    }
+    
+    reduction->reduced = NULL;
+    reduction->num_original_states = model->num_states;
+    for (int i = 0; i < model->num_states; i++) {
+        reduction->reduced_state[i] = -1;
+    }
+    
+    // Keep the states in breadth-first order from the start states
+    for (int i = 0; i < model->num_states; i++) {
+        if (from_state >= 0 ? i == from_state : model->initial[i]) {
+            reduction->reduced_state[i] = tail;
+            queue[tail++] = i;
+        }
+    }
+    if (tail == 0 && model->num_states > 0) {
+        reduction->reduced_state[0] = tail;
+        queue[tail++] = 0;
+    }
+    while (head < tail) {
+        state* current_state = &model->states[queue[head++]];
+        for (int j = 0; j < current_state->num_transitions; j++) {
+            int successor_id = current_state->transitions[j];
+            if (reduction->reduced_state[successor_id] < 0) {
+                reduction->reduced_state[successor_id] = tail;
+                queue[tail++] = successor_id;
+            }
+        }
+    }
+    if (tail == model->num_states) {
+        return true;
+    }
+    
+    reduction->reduced = ctl_create_model();
+    if (reduction->reduced == NULL) {
+        return false;
+    }
+    for (int i = 0; i < tail; i++) {
+        reduction->original_state[i] = queue[i];
+        ctl_add_state(reduction->reduced);
+        reduction->reduced->initial[i] = model->initial[queue[i]];
     }
+    
+    // Keep the propositions under their original names
+    for (int p = 0; p < model->num_props; p++) {
+        if (used_props != NULL && !used_props[p]) continue;
+        int reduced_prop = ctl_add_proposition(reduction->reduced, model->prop_names[p]);
+        for (int i = 0; i < tail; i++) {
+            if (model->states[queue[i]].atomic_props[p]) {
+                ctl_set_proposition_true(reduction->reduced, i, reduced_prop);
+            }
+        }
+    }
+    
+    for (int i = 0; i < tail; i++) {
+        state* current_state = &model->states[queue[i]];
+        for (int j = 0; j < current_state->num_transitions; j++) {
+            ctl_add_transition(reduction->reduced, i, reduction->reduced_state[current_state->transitions[j]]);
+        }
+    }
+    
+    // Fairness constraints restricted to the kept states
+    for (int c = 0; c < model->num_fairness; c++) {
+        state_set kept;
+        ctl_init_state_set(&kept, tail);
+        for (int i = 0; i < tail; i++) {
+            if (model->fairness[c].members[queue[i]]) {
+                ctl_add_to_state_set(&kept, i);
+            }
+        }
+        ctl_add_fairness_constraint(reduction->reduced, &kept);
+    }
+    
+    return true;
+}
+
+void ctl_free_reduction(ctl_reduction* reduction) {
+    ctl_free_model(reduction->reduced);
+    reduction->reduced = NULL;
+}
+
+// Map a set of reduced states back to the original states (dropped states are left out)
+void ctl_expand_state_set(state_set* result, state_set* set, ctl_reduction* reduction) {
+    ctl_init_state_set(result, reduction->num_original_states);
+    for (int i = 0; i < reduction->reduced->num_states; i++) {
+        if (set->members[i]) {
+            ctl_add_to_state_set(result, reduction->original_state[i]);
+        }
+    }
+}
+
+// Parse a formula on its cone of influence. Only states reachable from
+// from_state (from the initial states if from_state < 0) are decided; the
+// others are reported as not satisfying the formula.
+void ctl_parse_formula_reduced(const char* formula, state_set* result, model* model, int from_state) {
+    ctl_reduction reduction;
+    state_set reduced_result;
+    bool used[MAX_PROPS] = {false};
+    
+    ctl_formula_propositions(formula, model, used);
+    if (!ctl_reduce_model(&reduction, model, used, from_state) || reduction.reduced == NULL) {
+        ctl_parse_formula(formula, result, model);
+        return;
+    }
+    
+    ctl_parse_formula(formula, &reduced_result, reduction.reduced);
+    ctl_expand_state_set(result, &reduced_result, &reduction);
+    ctl_free_reduction(&reduction);
 }
 
 // Check if a formula is satisfied at a specific state
@@ -754,12 +1630,560 @@ bool ctl_check_formula_at_state(const char* formula, model* model, int state_id)
         return false;
     }
     
+    // Only the states reachable from state_id and the formula's propositions matter
     state_set result;
-    ctl_parse_formula(formula, &result, model);
+    ctl_parse_formula_reduced(formula, &result, model, state_id);
     
     return ctl_is_in_state_set(&result, state_id);
 }
 
+/* Initial-State Queries */
+
+// Collect the declared initial states, defaulting to state 0
+static int collect_initial_states(model* model, int* initial) {
+    int count = 0;
+    for (int i = 0; i < model->num_states; i++) {
+        if (model->initial[i]) {
+            initial[count++] = i;
+        }
+    }
+    if (count == 0 && model->num_states > 0) {
+        initial[count++] = 0;
+    }
+    return count;
+}
+
+// Empty trace of a search that records only the states it gets to
+static void init_partial_trace(ctl_trace* trace, model* model) {
+    trace->num_states = model->num_states;
+    trace->complete = false;
+    for (int i = 0; i < model->num_states; i++) {
+        trace->layer[i] = -1;
+        trace->next[i] = -1;
+    }
+}
+
+// Do all initial states satisfy EF P? Backward search from the P states that
+// stops as soon as the last initial state has been reached; the first initial
+// state it never reaches goes to failing_state. With a trace, every state the
+// search reached keeps its distance and a successor toward P.
+static bool initial_states_satisfy_ef(state_set* prop_p, model* model, int* initial, int num_initial,
+                                      int* failing_state, ctl_trace* trace) {
+    bool visited[MAX_STATES] = {false};
+    bool is_initial[MAX_STATES] = {false};
+    int queue[MAX_STATES];
+    int head = 0, tail = 0;
+    int pending = num_initial;
+    
+    if (!build_predecessor_index(model)) {
+        state_set result;
+        ctl_eval_eu_traced(&result, NULL, prop_p, model, trace);
+        for (int i = 0; i < num_initial; i++) {
+            if (!result.members[initial[i]]) {
+                *failing_state = initial[i];
+                return false;
+            }
+        }
+        return true;
+    }
+    
+    if (trace != NULL) {
+        init_partial_trace(trace, model);
+    }
+    for (int i = 0; i < model->num_states; i++) {
+        if (prop_p->members[i]) {
+            visited[i] = true;
+            queue[tail++] = i;
+            if (trace != NULL) trace->layer[i] = 0;
+        }
+    }
+    for (int i = 0; i < num_initial; i++) {
+        is_initial[initial[i]] = true;
+        if (visited[initial[i]]) pending--;
+    }
+    
+    while (pending > 0 && head < tail) {
+        int current = queue[head++];
+        for (int k = model->pred_start[current]; k < model->pred_start[current + 1]; k++) {
+            int predecessor_id = model->pred_list[k];
+            if (visited[predecessor_id]) continue;
+            visited[predecessor_id] = true;
+            queue[tail++] = predecessor_id;
+            if (trace != NULL) {
+                trace->layer[predecessor_id] = trace->layer[current] + 1;
+                trace->next[predecessor_id] = current;
+            }
+            if (is_initial[predecessor_id]) {
+                pending--;
+            }
+        }
+    }
+    
+    for (int i = 0; i < num_initial && pending > 0; i++) {
+        if (!visited[initial[i]]) {
+            *failing_state = initial[i];
+            return false;
+        }
+    }
+    return true;
+}
+
+// Trace holding only one path (a counterexample found by a search)
+static void trace_from_path(ctl_trace* trace, model* model, const int* states, int length) {
+    init_partial_trace(trace, model);
+    for (int k = 0; k < length; k++) {
+        trace->layer[states[k]] = length - 1 - k;
+        trace->next[states[k]] = (k + 1 < length) ? states[k + 1] : -1;
+    }
+}
+
+// Do all initial states satisfy AG P? Forward search from the initial states
+// that stops at the first reachable state violating P; the initial state it
+// was reached from goes to failing_state, and with a trace, the shortest path
+// from there to the violation.
+static bool initial_states_satisfy_ag(state_set* prop_p, model* model, int* initial, int num_initial,
+                                      int* failing_state, ctl_trace* trace) {
+    bool visited[MAX_STATES] = {false};
+    int parent[MAX_STATES];
+    int queue[MAX_STATES];
+    int head = 0, tail = 0;
+    
+    for (int i = 0; i < num_initial; i++) {
+        visited[initial[i]] = true;
+        parent[initial[i]] = -1;
+        queue[tail++] = initial[i];
+    }
+    
+    while (head < tail) {
+        int current = queue[head++];
+        if (!prop_p->members[current]) {
+            // Walk back to the initial state, reusing the queue for the path
+            int length = 0;
+            for (int s = current; s >= 0; s = parent[s]) {
+                queue[length++] = s;
+            }
+            for (int k = 0; k < length / 2; k++) {
+                int swap = queue[k];
+                queue[k] = queue[length - 1 - k];
+                queue[length - 1 - k] = swap;
+            }
+            *failing_state = queue[0];
+            if (trace != NULL) {
+                trace_from_path(trace, model, queue, length);
+            }
+            return false;
+        }
+        state* current_state = &model->states[current];
+        for (int j = 0; j < current_state->num_transitions; j++) {
+            int successor_id = current_state->transitions[j];
+            if (!visited[successor_id]) {
+                visited[successor_id] = true;
+                parent[successor_id] = current;
+                queue[tail++] = successor_id;
+            }
+        }
+    }
+    
+    return true;
+}
+
+// Keep a trace a search filled in as the node's trace (freed if it is empty)
+static void keep_trace(ctl_plan* plan, int node, ctl_trace* trace) {
+    if (trace == NULL) return;
+    if (trace->num_states == 0) {
+        free(trace);
+        return;
+    }
+    free(plan->traces[node]);
+    plan->traces[node] = trace;
+}
+
+// Is a plan node free of temporal operators?
+static bool is_propositional(ctl_plan* plan, int node) {
+    ctl_plan_node* current = &plan->nodes[node];
+    switch (current->op) {
+        case CTL_OP_TRUE: case CTL_OP_FALSE: case CTL_OP_PROP:
+            return true;
+        case CTL_OP_NOT:
+            return is_propositional(plan, current->left);
+        case CTL_OP_AND: case CTL_OP_OR: case CTL_OP_IMPLIES: case CTL_OP_IFF:
+            return is_propositional(plan, current->left) && is_propositional(plan, current->right);
+        default:
+            return false;
+    }
+}
+
+// Decide AG P with IC3; false if IC3 gave up. With a trace, a violation
+// leaves IC3's counterexample there.
+static bool holds_initially_ic3(state_set* prop_p, model* model, bool* holds, int* failing_state,
+                                ctl_trace* trace) {
+    ctl_ic3_report* report = malloc(sizeof(ctl_ic3_report));
+    if (report == NULL) {
+        return false;
+    }
+    ctl_ic3_result result = ctl_ic3_check(model, prop_p, report);
+    *holds = (result == CTL_IC3_HOLDS);
+    if (result == CTL_IC3_VIOLATED) {
+        *failing_state = report->counterexample.states[0];
+        if (trace != NULL) {
+            trace_from_path(trace, model, report->counterexample.states, report->counterexample.length);
+        }
+    }
+    free(report);
+    return result != CTL_IC3_FAILED;
+}
+
+// Does the formula of a plan node hold in all initial states? If not, an
+// initial state where it fails goes to failing_state (may be NULL). Unless
+// the plan already holds the node's result, a pure safety property (AG over
+// a formula without temporal operators, no fairness) goes to IC3 when
+// use_ic3 is set, and any other top-level EF or AG is decided by a search
+// that stops once the answer is known; everything else is evaluated in full.
+// If the plan keeps traces, the paths these searches find are kept for
+// ctl_plan_find_path.
+static bool plan_holds_initially(ctl_plan* plan, int node, int* failing_state, bool use_ic3) {
+    model* model = plan->model;
+    ctl_plan_node* current = &plan->nodes[node];
+    int initial[MAX_STATES];
+    int num_initial = collect_initial_states(model, initial);
+    int failing = -1;
+    bool holds = true;
+    
+    if (plan->results[node] == NULL && (current->op == CTL_OP_EF || current->op == CTL_OP_AG)) {
+        state_set operand;
+        ctl_trace* trace = NULL;
+        ctl_decompress_state_set(&operand, ctl_eval_plan_node(plan, current->left), model->num_states);
+        if (plan->keep_traces && (trace = malloc(sizeof(ctl_trace))) != NULL) {
+            trace->num_states = 0;
+        }
+        
+        if (use_ic3 && current->op == CTL_OP_AG && model->num_fairness == 0 && num_initial > 0 &&
+            is_propositional(plan, current->left) &&
+            holds_initially_ic3(&operand, model, &holds, &failing, trace)) {
+            keep_trace(plan, node, trace);
+            if (!holds && failing_state != NULL) *failing_state = failing;
+            return holds;
+        }
+        
+        // Under fairness only fair states count as targets (EF) or violations (AG)
+        if (model->num_fairness > 0) {
+            state_set fair, unfair;
+            ctl_eval_fair_states(&fair, model);
+            if (current->op == CTL_OP_EF) {
+                ctl_intersect_state_sets(&operand, &operand, &fair);
+            } else {
+                ctl_complement_state_set(&unfair, &fair, model->num_states);
+                ctl_union_state_sets(&operand, &operand, &unfair);
+            }
+        }
+        holds = (current->op == CTL_OP_EF)
+            ? initial_states_satisfy_ef(&operand, model, initial, num_initial, &failing, trace)
+            : initial_states_satisfy_ag(&operand, model, initial, num_initial, &failing, trace);
+        keep_trace(plan, node, trace);
+    } else {
+        ctl_compact_set* result = ctl_eval_plan_node(plan, node);
+        for (int i = 0; i < num_initial && holds; i++) {
+            if (!ctl_compact_set_contains(result, initial[i])) {
+                failing = initial[i];
+                holds = false;
+            }
+        }
+    }
+    
+    if (!holds && failing_state != NULL) *failing_state = failing;
+    return holds;
+}
+
+bool ctl_plan_holds_initially(ctl_plan* plan, int node, int* failing_state) {
+    return plan_holds_initially(plan, node, failing_state, true);
+}
+
+// Compile a formula into a plan of its own; NULL (after reporting the parse
+// error) if it does not compile
+static ctl_plan* compile_own_plan(const char* formula, model* model, int* root) {
+    ctl_plan* plan = ctl_create_plan(model);
+    if (plan == NULL) {
+        exit(1);
+    }
+    ctl_parse_error error;
+    *root = ctl_compile_formula(plan, formula, &error);
+    if (*root < 0) {
+        ctl_print_parse_error(formula, &error, stderr);
+        ctl_free_plan(plan);
+        return NULL;
+    }
+    return plan;
+}
+
+// Check if all initial states satisfy a formula, through a plan of its own
+static bool check_initial_plan(const char* formula, model* model, bool use_ic3) {
+    int root;
+    ctl_plan* plan = compile_own_plan(formula, model, &root);
+    if (plan == NULL) {
+        return false;
+    }
+    bool holds = plan_holds_initially(plan, root, NULL, use_ic3);
+    ctl_free_plan(plan);
+    return holds;
+}
+
+/* Witnesses and Counterexamples */
+
+// Follow the trace from a state: to the target of an EF/EU trace, or around
+// the cycle of an EG trace (a lasso). Linear in the length of the path.
+bool ctl_extract_path(ctl_trace* trace, int state_id, ctl_path* path) {
+    int position[MAX_STATES];
+    
+    path->length = 0;
+    path->loop_start = -1;
+    if (state_id < 0 || state_id >= trace->num_states || trace->layer[state_id] < 0) {
+        return false;
+    }
+    for (int i = 0; i < trace->num_states; i++) {
+        position[i] = -1;
+    }
+    
+    int current = state_id;
+    while (current >= 0) {
+        int k = position[current];
+        if (k >= 0) {
+            path->loop_start = k;   // Revisiting a state of this path closes the lasso
+            break;
+        }
+        
+        position[current] = path->length;
+        path->states[path->length++] = current;
+        current = trace->next[current];
+    }
+    
+    return true;
+}
+
+// Evaluate the operands of a top-level EF, EG, AF, AG or EU node (right only
+// for EU); false for any other node. The operands stay memoized in the plan.
+static bool top_level_operands(ctl_plan* plan, int root, ctl_op* op, state_set* left, state_set* right) {
+    model* model = plan->model;
+    ctl_plan_node node = plan->nodes[root];
+    *op = node.op;
+    bool supported = (node.op == CTL_OP_EF || node.op == CTL_OP_EG || node.op == CTL_OP_AF ||
+                      node.op == CTL_OP_AG || node.op == CTL_OP_EU);
+    if (supported) {
+        ctl_decompress_state_set(left, ctl_eval_plan_node(plan, node.left), model->num_states);
+        if (node.right >= 0) {
+            ctl_decompress_state_set(right, ctl_eval_plan_node(plan, node.right), model->num_states);
+        }
+    }
+    return supported;
+}
+
+// Path from state_id showing why an existential node holds (EF P, E[P U Q]:
+// a path to a P resp. Q state; EG P: a lasso through P) or why a universal one
+// fails (AG P: a path to a ¬P state; AF P: a lasso through ¬P). Under fairness,
+// path targets are fair states; EG lassos are not available under fairness.
+// The operands come from the plan, and the node's trace is computed once and
+// kept: a later path from the same node, or one the initial-state check
+// already found, needs no fixpoint.
+bool ctl_plan_find_path(ctl_plan* plan, int node, int state_id, ctl_path* path, bool counterexample) {
+    model* model = plan->model;
+    ctl_plan_node current = plan->nodes[node];
+    ctl_trace* trace = plan->traces[node];
+    state_set left, right, set, fair, result;
+    
+    path->length = 0;
+    path->loop_start = -1;
+    bool universal = (current.op == CTL_OP_AG || current.op == CTL_OP_AF);
+    bool supported = (current.op == CTL_OP_EF || current.op == CTL_OP_EG || current.op == CTL_OP_AF ||
+                      current.op == CTL_OP_AG || current.op == CTL_OP_EU);
+    if (!supported || universal != counterexample || state_id < 0 || state_id >= model->num_states) {
+        return false;
+    }
+    if (trace != NULL && (trace->complete || trace->layer[state_id] >= 0)) {
+        return ctl_extract_path(trace, state_id, path);
+    }
+    if ((current.op == CTL_OP_EG || current.op == CTL_OP_AF) && model->num_fairness > 0) {
+        return false;
+    }
+    
+    ctl_decompress_state_set(&left, ctl_eval_plan_node(plan, current.left), model->num_states);
+    if (universal) {
+        ctl_complement_state_set(&set, &left, model->num_states);
+    } else if (current.op == CTL_OP_EU) {
+        ctl_decompress_state_set(&right, ctl_eval_plan_node(plan, current.right), model->num_states);
+        ctl_copy_state_set(&set, &right);
+    } else {
+        ctl_copy_state_set(&set, &left);
+    }
+    
+    trace = malloc(sizeof(ctl_trace));
+    if (trace == NULL) {
+        return false;
+    }
+    if (current.op == CTL_OP_EG || current.op == CTL_OP_AF) {
+        ctl_eval_eg_traced(&result, &set, model, trace);
+    } else {
+        if (model->num_fairness > 0) {
+            ctl_eval_fair_states(&fair, model);
+            ctl_intersect_state_sets(&set, &set, &fair);
+        }
+        ctl_eval_eu_traced(&result, current.op == CTL_OP_EU ? &left : NULL, &set, model, trace);
+    }
+    free(plan->traces[node]);
+    plan->traces[node] = trace;
+    return ctl_extract_path(trace, state_id, path);
+}
+
+// ctl_plan_find_path on a plan of the formula's own
+static bool find_path(const char* formula, model* model, int state_id, ctl_path* path, bool counterexample) {
+    ctl_plan* plan = ctl_create_plan(model);
+    path->length = 0;
+    path->loop_start = -1;
+    if (plan == NULL) {
+        return false;
+    }
+    
+    ctl_parse_error error;
+    int root = ctl_compile_formula(plan, formula, &error);
+    bool found = false;
+    if (root < 0) {
+        ctl_print_parse_error(formula, &error, stderr);
+    } else {
+        found = ctl_plan_find_path(plan, root, state_id, path, counterexample);
+    }
+    ctl_free_plan(plan);
+    return found;
+}
+
+bool ctl_find_witness(const char* formula, model* model, int state_id, ctl_path* path) {
+    return find_path(formula, model, state_id, path, false);
+}
+
+bool ctl_find_counterexample(const char* formula, model* model, int state_id, ctl_path* path) {
+    return find_path(formula, model, state_id, path, true);
+}
+
+/* Bounded Model Checking */
+
+// Decide a top-level EF, EU or EG (a witness from every initial state) or AG,
+// AF (no counterexample from any initial state) with the bounded engine; the
+// operands are evaluated explicitly. Returns false if the query is not one
+// the bounded engine handles.
+static bool check_initial_bmc(ctl_plan* plan, int root, bool* holds) {
+    model* model = plan->model;
+    ctl_op op_type;
+    state_set left, right, negated;
+    int initial[MAX_STATES];
+    int num_initial = collect_initial_states(model, initial);
+    ctl_path* path = malloc(sizeof(ctl_path));
+    bool supported = true;
+    
+    if (path == NULL || model->num_fairness > 0 || !top_level_operands(plan, root, &op_type, &left, &right)) {
+        free(path);
+        return false;
+    }
+    
+    ctl_bmc_operator op;
+    state_set* prop_p = NULL;
+    state_set* prop_q = NULL;
+    bool universal = (op_type == CTL_OP_AG || op_type == CTL_OP_AF);
+    if (universal) {
+        ctl_complement_state_set(&negated, &left, model->num_states);
+    }
+    switch (op_type) {
+        case CTL_OP_EF: op = CTL_BMC_EF; prop_q = &left; break;
+        case CTL_OP_EU: op = CTL_BMC_EU; prop_p = &left; prop_q = &right; break;
+        case CTL_OP_EG: op = CTL_BMC_EG; prop_p = &left; break;
+        case CTL_OP_AG: op = CTL_BMC_EF; prop_q = &negated; break;    // AG P = ¬EF ¬P
+        default:        op = CTL_BMC_EG; prop_p = &negated; break;    // AF P = ¬EG ¬P
+    }
+    
+    *holds = true;
+    for (int i = 0; i < num_initial && *holds && supported; i++) {
+        ctl_bmc_result result = ctl_bmc_search(model, op, prop_p, prop_q, initial[i],
+                                               model->num_states, path);
+        if (result == CTL_BMC_WITNESS) {
+            *holds = !universal;
+        } else if (result == CTL_BMC_NO_WITNESS) {
+            *holds = universal;
+        } else {
+            supported = false;
+        }
+    }
+    
+    free(path);
+    return supported;
+}
+
+/* Engine Selection */
+
+// Decide a top-level AG with IC3; false if the formula is not one
+static bool check_initial_ic3(ctl_plan* plan, int root, bool* holds) {
+    model* model = plan->model;
+    ctl_op op_type;
+    state_set left, right;
+    
+    if (model->num_fairness > 0 || !top_level_operands(plan, root, &op_type, &left, &right)) {
+        return false;
+    }
+    
+    ctl_ic3_result result = CTL_IC3_FAILED;
+    if (op_type == CTL_OP_AG) {
+        result = ctl_ic3_check(model, &left, NULL);
+        *holds = (result == CTL_IC3_HOLDS);
+    }
+    return result != CTL_IC3_FAILED;
+}
+
+// Check if all initial states satisfy a formula with the given engine. The
+// bounded engine handles top-level EF, EU, EG, AG and AF and IC3 handles
+// top-level AG, both without fairness constraints; everything else is
+// checked explicitly, on the plan the formula was compiled into for the
+// engines (with the operands they already evaluated).
+bool ctl_check_formula_initial_engine(const char* formula, model* model, ctl_engine engine) {
+    int root;
+    ctl_plan* plan = compile_own_plan(formula, model, &root);
+    if (plan == NULL) {
+        return false;
+    }
+    
+    bool holds;
+    bool decided = model->num_states > 0 &&
+                   ((engine == CTL_ENGINE_BMC && check_initial_bmc(plan, root, &holds)) ||
+                    (engine == CTL_ENGINE_IC3 && check_initial_ic3(plan, root, &holds)));
+    if (!decided) {
+        holds = plan_holds_initially(plan, root, NULL, false);
+    }
+    ctl_free_plan(plan);
+    return holds;
+}
+
+// Check if all initial states satisfy a formula, with IC3 for pure safety
+// properties and explicit checking otherwise (as ctl_plan_holds_initially)
+bool ctl_check_formula_initial(const char* formula, model* model) {
+    return check_initial_plan(formula, model, true);
+}
+
+// Print a path as "s0 -> s1 -> ...", marking where a lasso loops back
+void ctl_print_path(ctl_path* path, model* model) {
+    for (int k = 0; k < path->length; k++) {
+        int state_id = path->states[k];
+        if (k > 0) printf(" -> ");
+        if (k == path->loop_start) printf("[loop: ");
+        printf("%d (", state_id);
+        bool first = true;
+        for (int p = 0; p < model->num_props; p++) {
+            if (model->states[state_id].atomic_props[p]) {
+                printf("%s%s", first ? "" : ",", model->prop_names[p]);
+                first = false;
+            }
+        }
+        printf(")");
+    }
+    if (path->loop_start >= 0) {
+        printf(" -> back to %d]", path->states[path->loop_start]);
+    }
+    printf("\n");
+}
+
 // Check if a state is in a state set
 bool ctl_check_state_in_set(int state_id, state_set* set) {
   return ctl_is_in_state_set(set, state_id);
@@ -4,6 +4,12 @@
 #include <stdbool.h>
 #include "ctl_api.h"
 
+// Property files used by the demonstrations. The Makefile points this at the
+// examples directory of the source tree, so the verifier runs from anywhere.
+#ifndef EXAMPLES_DIR
+#define EXAMPLES_DIR "examples/"
+#endif
+
 /*
  * Complete implementation to verify the correctness of Theorem 3
  * for CTL model checking as described in the lecture notes.
@@ -162,6 +168,9 @@ void manual_existential_successor(state_set* result, state_set* set, model* mode
 // Function to manually calculate universal successor (τAX) for demonstration
 void manual_universal_successor(state_set* result, state_set* set, model* model);
 
+// Mutual exclusion model of the lecture (defined below)
+model* create_mutex_model();
+
 // Demonstrate the Knaster-Tarski fixpoint theorem with examples
 void demonstrate_knaster_tarski(model* model) {
     printf("\n===== Demonstrating Knaster-Tarski Fixpoint Theorem =====\n");
@@ -239,8 +248,8 @@ void demonstrate_knaster_tarski(model* model) {
     }
 }
 
-// Verify the complexity claim from Theorem 4
-void verify_complexity_theorem(model* model) {
+// Verify the complexity claim from Theorem 4; false if the formulas cannot be read
+bool verify_complexity_theorem(model* model) {
     printf("\n===== Verifying Theorem 4: Complexity of CTL Model Checking =====\n");
     printf("Theorem 4 states: The CTL model checking problem is linear in the size of the state space K = (W, γ, v)\n");
     printf("and in the size of the formula φ in the sense that it is in O(|K| · |φ|) where |K| = |W| + |γ|.\n\n");
@@ -258,30 +267,34 @@ void verify_complexity_theorem(model* model) {
     
     printf("\nLet's measure the actual time for checking formulas of different sizes:\n");
     
-    // Array of formulas with increasing complexity
-    const char* formulas[] = {
-        "p1c",                    // Atomic proposition
-        "p1c | p2c",              // Disjunction
-        "!(p1c & p2c)",           // Negation of conjunction
-        "EX(p1c)",                // EX
-        "EF(p1c)",                // EF
-        "AG(!(p1c & p2c))",       // AG
-        "AG(p1t -> AF p1c)",      // AG with implication and AF
-        "AG(EF(p1c | p2c))"       // AG with EF and disjunction
-    };
-    
-    int num_formulas = sizeof(formulas) / sizeof(formulas[0]);
+    // Formulas with increasing complexity
+    ctl_property_list formulas;
+    if (!ctl_load_properties(&formulas, EXAMPLES_DIR "theorem4.ctl")) {
+        return false;
+    }
+    ctl_plan* plan = ctl_create_plan(model);
+    if (plan == NULL) {
+        ctl_free_properties(&formulas);
+        return false;
+    }
+    
     printf("%-30s | %s\n", "Formula", "States where formula is true");
     printf("-------------------------------+------------------------------------------------\n");
     
-    for (int i = 0; i < num_formulas; i++) {
-        state_set result;
-        ctl_parse_formula(formulas[i], &result, model);
+    for (int i = 0; i < formulas.num_properties; i++) {
+        const char* formula = formulas.properties[i].formula;
+        ctl_parse_error error;
+        int root = ctl_compile_formula(plan, formula, &error);
+        if (root < 0) {
+            ctl_print_parse_error(formula, &error, stderr);
+            continue;
+        }
+        ctl_compact_set* result = ctl_eval_plan_node(plan, root);
         
-        printf("%-30s | ", formulas[i]);
+        printf("%-30s | ", formula);
         bool first = true;
         for (int j = 0; j < model->num_states; j++) {
-            if (result.members[j]) {
+            if (ctl_compact_set_contains(result, j)) {
                 if (!first) printf(", ");
                 printf("%d", j);
                 first = false;
@@ -290,64 +303,156 @@ void verify_complexity_theorem(model* model) {
         printf("\n");
     }
     
+    ctl_free_plan(plan);
+    ctl_free_properties(&formulas);
+    
     printf("\nObservation: The complexity of model checking grows linearly with formula size and model size,\n");
     printf("which aligns with Theorem 4's claim that CTL model checking is in O(|K| · |φ|).\n");
+    return true;
+}
+
+// Print a path from an initial state that violates a compiled property
+void print_counterexample(ctl_plan* plan, int node, int state_id) {
+    ctl_path path;
+    if (ctl_plan_find_path(plan, node, state_id, &path, true)) {
+        printf("   Counterexample: ");
+        ctl_print_path(&path, plan->model);
+    }
 }
 
-// Verify mutual exclusion properties for completeness
-void verify_mutual_exclusion_properties(model* model) {
+// Verify mutual exclusion properties for completeness; false if the property
+// file cannot be read
+bool verify_mutual_exclusion_properties(model* model) {
     printf("\n===== Verifying Mutual Exclusion Properties =====\n");
     
-    // Safety property: no two processes are in the critical section simultaneously
-    printf("1. Safety Property AG !(p1c & p2c)\n");
-    printf("   Meaning: It's always globally true that processes 1 and 2 are not both in their critical sections\n");
-    state_set safety_result;
-    ctl_parse_formula("AG !(p1c & p2c)", &safety_result, model);
-    printf("   Result: ");
-    bool safety_holds = ctl_is_in_state_set(&safety_result, 0);
-    print_state_set(&safety_result, model, "AG !(p1c & p2c)");
-    printf("   Property holds in initial state: %s\n\n", safety_holds ? "YES" : "NO");
-    
-    // Liveness property for Process 1: if trying, it will eventually enter critical section
-    printf("2. Liveness Property for P1: AG (p1t -> AF p1c)\n");
-    printf("   Meaning: It's always globally true that if process 1 is trying, it will always finally enter its critical section\n");
-    state_set liveness1_result;
-    ctl_parse_formula("AG (p1t -> AF p1c)", &liveness1_result, model);
-    printf("   Result: ");
-    bool liveness1_holds = ctl_is_in_state_set(&liveness1_result, 0);
-    print_state_set(&liveness1_result, model, "AG (p1t -> AF p1c)");
-    printf("   Property holds in initial state: %s\n\n", liveness1_holds ? "YES" : "NO");
-    
-    // Liveness property for Process 2: if trying, it will eventually enter critical section
-    printf("3. Liveness Property for P2: AG (p2t -> AF p2c)\n");
-    printf("   Meaning: It's always globally true that if process 2 is trying, it will always finally enter its critical section\n");
-    state_set liveness2_result;
-    ctl_parse_formula("AG (p2t -> AF p2c)", &liveness2_result, model);
-    printf("   Result: ");
-    bool liveness2_holds = ctl_is_in_state_set(&liveness2_result, 0);
-    print_state_set(&liveness2_result, model, "AG (p2t -> AF p2c)");
-    printf("   Property holds in initial state: %s\n\n", liveness2_holds ? "YES" : "NO");
-    
-    // Non-blocking: it's always possible for a process to enter critical section
-    printf("4. Non-blocking Property: AG EF (p1c | p2c)\n");
-    printf("   Meaning: It's always globally true that there exists a path where eventually some process enters its critical section\n");
-    state_set nonblocking_result;
-    ctl_parse_formula("AG EF (p1c | p2c)", &nonblocking_result, model);
-    printf("   Result: ");
-    bool nonblocking_holds = ctl_is_in_state_set(&nonblocking_result, 0);
-    print_state_set(&nonblocking_result, model, "AG EF (p1c | p2c)");
-    printf("   Property holds in initial state: %s\n\n", nonblocking_holds ? "YES" : "NO");
-    
-    // No unnecessary waiting: if one process is not competing, the other can enter immediately
-    printf("5. No Unnecessary Waiting for P1: AG ((p2n & p1t) -> EX p1c)\n");
-    printf("   Meaning: It's always globally true that if process 2 is in non-critical section and process 1 is trying,\n");
-    printf("            then there exists a path where process 1 enters its critical section in the next state\n");
-    state_set nowait1_result;
-    ctl_parse_formula("AG ((p2n & p1t) -> EX p1c)", &nowait1_result, model);
-    printf("   Result: ");
-    bool nowait1_holds = ctl_is_in_state_set(&nowait1_result, 0);
-    print_state_set(&nowait1_result, model, "AG ((p2n & p1t) -> EX p1c)");
-    printf("   Property holds in initial state: %s\n", nowait1_holds ? "YES" : "NO");
+    ctl_property_list properties;
+    if (!ctl_load_properties(&properties, EXAMPLES_DIR "mutex.ctl")) {
+        return false;
+    }
+    ctl_plan* plan = ctl_create_plan(model);
+    if (plan == NULL) {
+        ctl_free_properties(&properties);
+        return false;
+    }
+    plan->keep_traces = true;   // Counterexamples come from the searches of the checks
+    
+    for (int i = 0; i < properties.num_properties; i++) {
+        ctl_property* property = &properties.properties[i];
+        property->root = ctl_compile_formula(plan, property->formula, &property->error);
+        
+        printf("%d. %s: %s\n", i + 1, property->name, property->formula);
+        if (property->root < 0) {
+            ctl_print_parse_error(property->formula, &property->error, stdout);
+            printf("\n");
+            continue;
+        }
+        int failing_state;
+        bool holds = ctl_plan_holds_initially(plan, property->root, &failing_state);
+        if (!holds) print_counterexample(plan, property->root, failing_state);
+        printf("   Property holds in initial state: %s\n\n", holds ? "YES" : "NO");
+    }
+    
+    ctl_free_plan(plan);
+    ctl_free_properties(&properties);
+    return true;
+}
+
+// Check a property file against a model file (the built-in mutual exclusion
+// model if model_path is NULL), streaming one verdict per property. With
+// explain only the plan of each property is printed; with analyze the plan
+// follows each verdict, with what its nodes actually took. Invalid
+// properties are reported and skipped. The properties are compiled against
+// their cone of influence when it drops unreachable states. With a cache
+// directory, fixpoint results are read from and saved to the cache file of
+// the checked model there. Exit
+// status: 0 if all properties hold, 1 if some fail, 2 on errors, including
+// invalid properties.
+int check_property_file(const char* model_path, const char* properties_path, bool simplify,
+                        bool explain, bool analyze, const char* cache_dir) {
+    model* model = (model_path != NULL) ? ctl_load_model(model_path) : create_mutex_model();
+    if (model == NULL) {
+        return 2;
+    }
+    
+    ctl_property_list properties;
+    if (!ctl_load_properties(&properties, properties_path)) {
+        ctl_free_model(model);
+        return 2;
+    }
+    
+    ctl_reduction reduction;
+    if (!ctl_reduce_for_properties(&reduction, &properties, model)) {
+        ctl_free_properties(&properties);
+        ctl_free_model(model);
+        return 2;
+    }
+    if (reduction.reduced != NULL) {
+        printf("Cone of influence: %d of %d states, %d of %d propositions\n", reduction.reduced->num_states,
+               model->num_states, reduction.reduced->num_props, model->num_props);
+    }
+    
+    ctl_plan* plan = ctl_create_plan((reduction.reduced != NULL) ? reduction.reduced : model);
+    if (plan == NULL) {
+        ctl_free_reduction(&reduction);
+        ctl_free_properties(&properties);
+        ctl_free_model(model);
+        return 2;
+    }
+    plan->simplify = simplify;
+    if (cache_dir != NULL) {
+        plan->cache = ctl_open_cache(cache_dir, plan->model);
+        if (plan->cache == NULL) {
+            ctl_free_plan(plan);
+            ctl_free_reduction(&reduction);
+            ctl_free_properties(&properties);
+            ctl_free_model(model);
+            return 2;
+        }
+    }
+    
+    int failures = 0;
+    int invalid = 0;
+    if (explain || analyze) {
+        for (int i = 0; i < properties.num_properties; i++) {
+            ctl_property* property = &properties.properties[i];
+            property->root = ctl_compile_formula(plan, property->formula, &property->error);
+            printf("%s: %s\n", property->name, property->formula);
+            if (property->root < 0) {
+                ctl_print_parse_error(property->formula, &property->error, stdout);
+                invalid++;
+            } else if (analyze) {
+                ctl_analyze_plan(plan, property->root, stdout);
+                bool holds = ctl_plan_holds_initially(plan, property->root, NULL);
+                printf("%s\n", holds ? "holds" : "fails");
+                if (!holds) failures++;
+            } else {
+                ctl_explain_plan(plan, property->root, stdout);
+            }
+            printf("\n");
+        }
+    } else {
+        failures = ctl_check_properties(&properties, plan, &reduction, stdout, &invalid);
+        printf("%d properties: %d hold, %d fail", properties.num_properties,
+               properties.num_properties - failures - invalid, failures);
+        if (invalid > 0) {
+            printf(", %d invalid", invalid);
+        }
+        printf(" (%d plan nodes, %d fixpoints", plan->num_nodes, plan->num_fixpoints);
+        if (plan->cache != NULL) {
+            printf(", %d cache hits", plan->cache->hits);
+        }
+        printf(")\n");
+    }
+    
+    bool saved = ctl_close_cache(plan->cache);
+    ctl_free_plan(plan);
+    ctl_free_reduction(&reduction);
+    ctl_free_properties(&properties);
+    ctl_free_model(model);
+    if (invalid > 0 || !saved) {
+        return 2;
+    }
+    return failures > 0 ? 1 : 0;
 }
 
 // Create a model representing a mutual exclusion algorithm similar to the lecture example
@@ -446,6 +551,9 @@ model* create_mutex_model() {
     // From state 8 (tc)
     ctl_add_transition(model, 8, 7); // tc -> nc
     
+    // Both processes start in their non-critical sections
+    ctl_set_initial_state(model, 0);
+    
     return model;
 }
 #include "ctl_eq1-4.c"
@@ -457,8 +565,55 @@ model* create_mutex_model() {
 #include "ctl_eq10.c"
 #include "ctl_eq11.c"
 #include "ctl_eq12.c"
-// Main function to verify all equations of Theorem 3
-int main() {
+// Main function to verify all equations of Theorem 3, or, with
+// --properties, to check a property file (--no-simplify keeps the formulas
+// exactly as written, --explain prints their plans instead of checking them,
+// --analyze checks them and prints their plans with measurements, --cache
+// keeps fixpoint results in a directory between runs); --selfcheck runs the
+// differential test of make check instead
+int main(int argc, char** argv) {
+    const char* model_path = NULL;
+    const char* properties_path = NULL;
+    bool simplify = true;
+    bool explain = false;
+    bool analyze = false;
+    const char* cache_dir = NULL;
+    int selfcheck_iterations = 0;
+    unsigned int selfcheck_seed = 1;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--model") == 0 && i + 1 < argc) {
+            model_path = argv[++i];
+        } else if (strcmp(argv[i], "--properties") == 0 && i + 1 < argc) {
+            properties_path = argv[++i];
+        } else if (strcmp(argv[i], "--no-simplify") == 0) {
+            simplify = false;
+        } else if (strcmp(argv[i], "--explain") == 0) {
+            explain = true;
+        } else if (strcmp(argv[i], "--analyze") == 0) {
+            analyze = true;
+        } else if (strcmp(argv[i], "--cache") == 0 && i + 1 < argc) {
+            cache_dir = argv[++i];
+        } else if (strcmp(argv[i], "--selfcheck") == 0 && i + 1 < argc) {
+            selfcheck_iterations = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            selfcheck_seed = (unsigned int)strtoul(argv[++i], NULL, 10);
+        } else {
+            fprintf(stderr, "Usage: %s [--model <file>] [--properties <file>] [--no-simplify] [--explain] [--analyze] [--cache <dir>]\n", argv[0]);
+            fprintf(stderr, "       %s --selfcheck <iterations> [--seed <n>]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (selfcheck_iterations > 0) {
+        return ctl_run_selfcheck(selfcheck_iterations, selfcheck_seed) == 0 ? 0 : 1;
+    }
+    if (properties_path != NULL) {
+        return check_property_file(model_path, properties_path, simplify, explain, analyze, cache_dir);
+    }
+    if (model_path != NULL) {
+        fprintf(stderr, "Error: --model needs --properties\n");
+        return 2;
+    }
+    
     printf("===== CTL Model Checking: Theorem 3 Verification =====\n");
     printf("This program verifies the 12 equations of Theorem 3 from the CTL model checking lecture.\n");
     printf("Theorem 3 (CTL model checking): In computation structures, the set [[φ]] of all states\n");
@@ -478,7 +633,8 @@ int main() {
     print_model_graph(mutex_model);
     
     // Let the user choose which verifications to run
-    char input[10];
+    char input[32];
+    bool demos_ok = true;
     printf("\nVerify which equations? (1-12, 'all', or 'properties'): ");
     if (fgets(input, sizeof(input), stdin) == NULL) {
         input[0] = '\0';
@@ -510,10 +666,10 @@ int main() {
         demonstrate_knaster_tarski(mutex_model);
         
         // Verify the complexity claim from Theorem 4
-        verify_complexity_theorem(mutex_model);
+        demos_ok = verify_complexity_theorem(mutex_model);
     } else if (strcmp(input, "properties") == 0) {
         // Verify only mutual exclusion properties
-        verify_mutual_exclusion_properties(mutex_model);
+        demos_ok = verify_mutual_exclusion_properties(mutex_model);
     } else {
         // Verify specific equation(s)
         int eq_num = atoi(input);
@@ -541,6 +697,9 @@ int main() {
     
     // Clean up
     ctl_free_model(mutex_model);
+    if (!demos_ok) {
+        return 2;
+    }
     
     printf("\n===== Verification Complete =====\n");
     printf("All requested equations from Theorem 3 have been verified.\n");
@@ -0,0 +1,942 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "ctl_api.h"
+
+/*
+ * Compiled formulas.
+ *
+ * The parser turns a formula into plan nodes instead of evaluating it as it
+ * reads. Nodes are hash-consed: asking for a node that already exists (same
+ * operator, operands and proposition) returns the existing one, so a
+ * subformula shared by several formulas of a property file is one node and
+ * its fixpoint is computed once. Operands always precede the nodes that use
+ * them.
+ *
+ * Unless plan->simplify is off, nodes built by the parser first go through
+ * CTL identities (constant folding, double negation, idempotence of the
+ * temporal operators, negation pushed into the dual operator), so "!!EF EF p"
+ * costs one fixpoint instead of two and "!EF p" shares its fixpoint with
+ * "AG !p".
+ *
+ * Each new node also gets an algorithm. Most temporal operators have more
+ * than one: the layered sweeps need nothing but rescan every transition
+ * each round, the worklist kernels make one backward pass but need the
+ * predecessor index, and AF/AG/EG/AU can also be computed as complements of
+ * their duals. The planner estimates each candidate's work in state and
+ * edge visits from the model's size, its depth, the estimated density of
+ * the operand sets and whether the index exists, and keeps the cheapest.
+ * ctl_explain_plan prints the result; ctl_analyze_plan evaluates the plan
+ * and adds what each node actually took.
+ *
+ * With a result cache (plan->cache), a fixpoint node is first looked up by
+ * its canonical formula, and a hit skips the node and all its operands.
+ *
+ * Results are kept as compact sets (ctl_compact.c). Boolean nodes combine
+ * their operands' compact sets directly; temporal kernels get theirs
+ * expanded and their result compressed.
+ */
+
+#define PLAN_INITIAL_CAPACITY 64
+
+static unsigned int hash_node(ctl_op op, int left, int right, int prop_id) {
+    unsigned int hash = 2166136261u;
+    int fields[4] = { (int)op, left, right, prop_id };
+    for (int i = 0; i < 4; i++) {
+        hash = (hash ^ (unsigned int)fields[i]) * 16777619u;
+    }
+    return hash;
+}
+
+// Model statistics the planner works from: the number of transitions, and
+// the rounds of a breadth-first search from the initial states as a guess
+// at how many rounds a layered fixpoint takes
+static void measure_model(ctl_plan* plan) {
+    model* model = plan->model;
+    int distance[MAX_STATES];
+    int queue[MAX_STATES];
+    int head = 0, tail = 0;
+
+    plan->num_edges = 0;
+    plan->depth = 0;
+    plan->index_planned = false;
+    for (int i = 0; i < model->num_states; i++) {
+        plan->num_edges += model->states[i].num_transitions;
+        distance[i] = -1;
+        if (model->initial[i]) {
+            distance[i] = 0;
+            queue[tail++] = i;
+        }
+    }
+    if (tail == 0 && model->num_states > 0) {
+        distance[0] = 0;
+        queue[tail++] = 0;
+    }
+
+    while (head < tail) {
+        int current = queue[head++];
+        if (distance[current] > plan->depth) {
+            plan->depth = distance[current];
+        }
+        state* current_state = &model->states[current];
+        for (int j = 0; j < current_state->num_transitions; j++) {
+            int successor_id = current_state->transitions[j];
+            if (distance[successor_id] < 0) {
+                distance[successor_id] = distance[current] + 1;
+                queue[tail++] = successor_id;
+            }
+        }
+    }
+}
+
+// Create an empty plan for a model
+ctl_plan* ctl_create_plan(model* model) {
+    ctl_plan* plan = malloc(sizeof(ctl_plan));
+    if (plan == NULL) {
+        fprintf(stderr, "Error: Memory allocation failed for plan\n");
+        return NULL;
+    }
+
+    plan->model = model;
+    plan->simplify = true;
+    plan->num_fixpoints = 0;
+    plan->cache = NULL;
+    plan->keep_traces = false;
+    plan->num_nodes = 0;
+    plan->capacity = PLAN_INITIAL_CAPACITY;
+    plan->table_size = 2 * PLAN_INITIAL_CAPACITY;
+    plan->nodes = malloc(plan->capacity * sizeof(ctl_plan_node));
+    plan->results = malloc(plan->capacity * sizeof(ctl_compact_set*));
+    plan->stats = malloc(plan->capacity * sizeof(ctl_node_stats));
+    plan->traces = malloc(plan->capacity * sizeof(ctl_trace*));
+    plan->table = malloc(plan->table_size * sizeof(int));
+    if (plan->nodes == NULL || plan->results == NULL || plan->stats == NULL || plan->traces == NULL ||
+        plan->table == NULL) {
+        fprintf(stderr, "Error: Memory allocation failed for plan\n");
+        ctl_free_plan(plan);
+        return NULL;
+    }
+    for (int i = 0; i < plan->table_size; i++) {
+        plan->table[i] = -1;
+    }
+    measure_model(plan);
+
+    return plan;
+}
+
+// Free a plan and its results
+void ctl_free_plan(ctl_plan* plan) {
+    if (plan == NULL) return;
+
+    if (plan->results != NULL) {
+        for (int i = 0; i < plan->num_nodes; i++) {
+            free(plan->results[i]);
+        }
+    }
+    if (plan->traces != NULL) {
+        for (int i = 0; i < plan->num_nodes; i++) {
+            free(plan->traces[i]);
+        }
+    }
+    free(plan->nodes);
+    free(plan->results);
+    free(plan->stats);
+    free(plan->traces);
+    free(plan->table);
+    free(plan);
+}
+
+// Slot of the hash table holding the node, or the empty slot where it would go
+static int* node_slot(ctl_plan* plan, ctl_op op, int left, int right, int prop_id) {
+    for (unsigned int slot = hash_node(op, left, right, prop_id);; slot++) {
+        int* entry = &plan->table[slot & (plan->table_size - 1)];
+        if (*entry < 0) {
+            return entry;
+        }
+        ctl_plan_node* node = &plan->nodes[*entry];
+        if (node->op == op && node->left == left && node->right == right && node->prop_id == prop_id) {
+            return entry;
+        }
+    }
+}
+
+// Double the node arrays and the hash table
+static bool grow_plan(ctl_plan* plan) {
+    int capacity = 2 * plan->capacity;
+    ctl_plan_node* nodes = realloc(plan->nodes, capacity * sizeof(ctl_plan_node));
+    if (nodes == NULL) return false;
+    plan->nodes = nodes;
+    ctl_compact_set** results = realloc(plan->results, capacity * sizeof(ctl_compact_set*));
+    if (results == NULL) return false;
+    plan->results = results;
+    ctl_node_stats* stats = realloc(plan->stats, capacity * sizeof(ctl_node_stats));
+    if (stats == NULL) return false;
+    plan->stats = stats;
+    ctl_trace** traces = realloc(plan->traces, capacity * sizeof(ctl_trace*));
+    if (traces == NULL) return false;
+    plan->traces = traces;
+    int* table = malloc(2 * capacity * sizeof(int));
+    if (table == NULL) return false;
+
+    free(plan->table);
+    plan->table = table;
+    plan->table_size = 2 * capacity;
+    plan->capacity = capacity;
+    for (int i = 0; i < plan->table_size; i++) {
+        plan->table[i] = -1;
+    }
+    for (int i = 0; i < plan->num_nodes; i++) {
+        ctl_plan_node* node = &plan->nodes[i];
+        *node_slot(plan, node->op, node->left, node->right, node->prop_id) = i;
+    }
+    return true;
+}
+
+/* Planning */
+
+// Estimated densities of the temporal operators. These only have to rank
+// the candidates sensibly: E[P U Q] keeps Q and about half of the other P
+// states, EG P about half of P; the universal operators are the
+// complements of their existential duals.
+static double union_density(double a, double b) {
+    return 1.0 - (1.0 - a) * (1.0 - b);
+}
+
+static double eu_density(double p, double q) {
+    return (q > 0.0) ? q + (1.0 - q) * p / 2.0 : 0.0;
+}
+
+static double eg_density(double p) {
+    return (p >= 1.0) ? 1.0 : p / 2.0;
+}
+
+static double estimate_density(ctl_plan* plan, ctl_plan_node* node) {
+    model* model = plan->model;
+    double p = (node->left >= 0) ? plan->nodes[node->left].density : 0.0;
+    double q = (node->right >= 0) ? plan->nodes[node->right].density : 0.0;
+    double degree = (model->num_states > 0) ? (double)plan->num_edges / model->num_states : 0.0;
+
+    switch (node->op) {
+        case CTL_OP_TRUE: return 1.0;
+        case CTL_OP_FALSE: return 0.0;
+        case CTL_OP_PROP: {
+            int count = 0;
+            for (int i = 0; i < model->num_states; i++) {
+                if (model->states[i].atomic_props[node->prop_id]) count++;
+            }
+            return (model->num_states > 0) ? (double)count / model->num_states : 0.0;
+        }
+        case CTL_OP_NOT: return 1.0 - p;
+        case CTL_OP_AND: return p * q;
+        case CTL_OP_OR: return union_density(p, q);
+        case CTL_OP_IMPLIES: return union_density(1.0 - p, q);
+        case CTL_OP_IFF: return p * q + (1.0 - p) * (1.0 - q);
+        case CTL_OP_EX:
+        case CTL_OP_AX: {
+            // Some resp. every one of `degree` successors in P
+            double none = 1.0, all = 1.0;
+            for (int k = 0; k < (int)(degree + 0.5); k++) {
+                none *= 1.0 - p;
+                all *= p;
+            }
+            return (node->op == CTL_OP_EX) ? 1.0 - none : all;
+        }
+        case CTL_OP_EF: return eu_density(1.0, p);
+        case CTL_OP_AF: return 1.0 - eg_density(1.0 - p);
+        case CTL_OP_EG: return eg_density(p);
+        case CTL_OP_AG: return 1.0 - eu_density(1.0, 1.0 - p);
+        case CTL_OP_EU: return eu_density(p, q);
+        case CTL_OP_AU:
+            return 1.0 - union_density(eu_density(1.0 - q, (1.0 - p) * (1.0 - q)), eg_density(1.0 - q));
+        case CTL_OP_EW: return union_density(eu_density(p, q), eg_density(p));
+        case CTL_OP_AW: return 1.0 - eu_density(1.0 - q, (1.0 - p) * (1.0 - q));
+        case CTL_OP_ER: return union_density(eu_density(q, p * q), eg_density(q));
+        case CTL_OP_AR: return 1.0 - eu_density(1.0 - p, 1.0 - q);
+    }
+    return 0.0;
+}
+
+// Work of the candidate algorithms, in state and edge visits. A layered
+// sweep takes one round per layer it adds (at most the candidate states,
+// guessed to be at most the model's depth) plus a final round that finds
+// nothing; a worklist kernel visits every state and transition about once,
+// or twice for the greatest fixpoints that count successors first.
+typedef struct {
+    double n;                         // States
+    double m;                         // Transitions
+    double depth;
+    double index;                     // Building the predecessor index (0 if done or planned)
+} plan_costs;
+
+static double sweep_rounds(plan_costs* c, double candidates) {
+    double layers = candidates * c->n;
+    return 1.0 + ((layers < c->depth) ? layers : c->depth);
+}
+
+static double eu_sweep_cost(plan_costs* c, double p, double q) {
+    return sweep_rounds(c, p * (1.0 - q)) * (c->n + c->m);
+}
+
+static double eg_sweep_cost(plan_costs* c, double p) {
+    return sweep_rounds(c, p) * (c->n + p * c->m);
+}
+
+static double backward_cost(plan_costs* c) {
+    return c->n + c->m + c->index;
+}
+
+static double counting_cost(plan_costs* c) {
+    return c->n + 2.0 * c->m + c->index;
+}
+
+// Keep a candidate if it is cheaper than the best so far
+static void consider(ctl_plan_node* node, ctl_algorithm algorithm, double cost) {
+    if (cost < node->cost) {
+        node->algorithm = algorithm;
+        node->cost = cost;
+    }
+}
+
+static bool uses_index(ctl_plan_node* node) {
+    return node->algorithm == CTL_ALG_WORKLIST || node->algorithm == CTL_ALG_DUAL_WORKLIST;
+}
+
+// Estimate a new node and pick its cheapest algorithm
+static void choose_algorithm(ctl_plan* plan, int id) {
+    ctl_plan_node* node = &plan->nodes[id];
+    model* model = plan->model;
+    double p = (node->left >= 0) ? plan->nodes[node->left].density : 0.0;
+    double q = (node->right >= 0) ? plan->nodes[node->right].density : 0.0;
+    plan_costs c;
+    c.n = model->num_states;
+    c.m = plan->num_edges;
+    c.depth = plan->depth;
+    c.index = (plan->index_planned || model->pred_start != NULL) ? 0.0 : c.n + 2.0 * c.m;
+
+    node->density = estimate_density(plan, node);
+    node->algorithm = CTL_ALG_DIRECT;
+    node->cost = c.n;
+
+    if (node->op >= CTL_OP_EX && model->num_fairness > 0) {
+        // The fair states (an SCC pass and a backward search), then the
+        // operator on top of them; fair EG and AF are that search itself
+        node->algorithm = CTL_ALG_FAIR;
+        node->cost = 2.0 * (c.n + c.m) + c.index;
+        if (node->op == CTL_OP_EX || node->op == CTL_OP_AX) {
+            node->cost += c.n + c.m;
+        } else if (node->op != CTL_OP_EG && node->op != CTL_OP_AF) {
+            node->cost += eu_sweep_cost(&c, p, q);
+        }
+        plan->index_planned = true;
+        return;
+    }
+
+    node->cost = 1e300;
+    switch (node->op) {
+        case CTL_OP_EX:
+        case CTL_OP_AX:
+            consider(node, CTL_ALG_DIRECT, c.n + c.m);
+            break;
+        case CTL_OP_EF:
+            consider(node, CTL_ALG_SWEEP, eu_sweep_cost(&c, 1.0, p));
+            consider(node, CTL_ALG_WORKLIST, backward_cost(&c));
+            break;
+        case CTL_OP_EU:
+            consider(node, CTL_ALG_SWEEP, eu_sweep_cost(&c, p, q));
+            consider(node, CTL_ALG_WORKLIST, backward_cost(&c));
+            break;
+        case CTL_OP_EG:
+            consider(node, CTL_ALG_SWEEP, eg_sweep_cost(&c, p));
+            consider(node, CTL_ALG_WORKLIST, counting_cost(&c));
+            consider(node, CTL_ALG_DUAL_WORKLIST, backward_cost(&c) + 2.0 * c.n);
+            break;
+        case CTL_OP_AF:
+            consider(node, CTL_ALG_DUAL_SWEEP, eg_sweep_cost(&c, 1.0 - p) + 2.0 * c.n);
+            consider(node, CTL_ALG_WORKLIST, backward_cost(&c));
+            break;
+        case CTL_OP_AG:
+            consider(node, CTL_ALG_DUAL_SWEEP, eu_sweep_cost(&c, 1.0, 1.0 - p) + 2.0 * c.n);
+            consider(node, CTL_ALG_DUAL_WORKLIST, backward_cost(&c) + 2.0 * c.n);
+            consider(node, CTL_ALG_WORKLIST, counting_cost(&c));
+            break;
+        case CTL_OP_AU:
+            // Dual: ¬(E[¬Q U (¬P ∧ ¬Q)] ∨ EG ¬Q), five set operations
+            consider(node, CTL_ALG_WORKLIST, backward_cost(&c));
+            consider(node, CTL_ALG_DUAL_SWEEP, eu_sweep_cost(&c, 1.0 - q, (1.0 - p) * (1.0 - q)) +
+                                               eg_sweep_cost(&c, 1.0 - q) + 5.0 * c.n);
+            break;
+        case CTL_OP_EW:
+        case CTL_OP_AW:
+        case CTL_OP_ER:
+        case CTL_OP_AR:
+            consider(node, CTL_ALG_WORKLIST, counting_cost(&c));
+            break;
+        default:
+            consider(node, CTL_ALG_DIRECT, c.n);
+            break;
+    }
+    if (uses_index(node)) {
+        plan->index_planned = true;
+    }
+}
+
+// The node for an operator applied to existing nodes (unused operands -1,
+// prop_id -1 unless op is CTL_OP_PROP); -1 if memory runs out
+int ctl_plan_add_node(ctl_plan* plan, ctl_op op, int left, int right, int prop_id) {
+    int* entry = node_slot(plan, op, left, right, prop_id);
+    if (*entry >= 0) {
+        return *entry;
+    }
+
+    if (plan->num_nodes == plan->capacity) {
+        if (!grow_plan(plan)) {
+            fprintf(stderr, "Error: Memory allocation failed for plan\n");
+            return -1;
+        }
+        entry = node_slot(plan, op, left, right, prop_id);
+    }
+
+    int id = plan->num_nodes++;
+    plan->nodes[id].op = op;
+    plan->nodes[id].prop_id = prop_id;
+    plan->nodes[id].left = left;
+    plan->nodes[id].right = right;
+    plan->nodes[id].depth = 1;
+    if (left >= 0 && plan->nodes[left].depth >= plan->nodes[id].depth) {
+        plan->nodes[id].depth = plan->nodes[left].depth + 1;
+    }
+    if (right >= 0 && plan->nodes[right].depth >= plan->nodes[id].depth) {
+        plan->nodes[id].depth = plan->nodes[right].depth + 1;
+    }
+    plan->results[id] = NULL;
+    plan->traces[id] = NULL;
+    plan->stats[id].seconds = 0.0;
+    plan->stats[id].iterations = 0;
+    plan->stats[id].edges_scanned = 0;
+    *entry = id;
+    choose_algorithm(plan, id);
+    return id;
+}
+
+/* Simplification */
+
+static bool is_op(ctl_plan* plan, int node, ctl_op op) {
+    return plan->nodes[node].op == op;
+}
+
+// Is one node the negation of the other?
+static bool negates(ctl_plan* plan, int a, int b) {
+    return (is_op(plan, a, CTL_OP_NOT) && plan->nodes[a].left == b) ||
+           (is_op(plan, b, CTL_OP_NOT) && plan->nodes[b].left == a);
+}
+
+static int make_constant(ctl_plan* plan, bool value) {
+    return ctl_plan_add_node(plan, value ? CTL_OP_TRUE : CTL_OP_FALSE, -1, -1, -1);
+}
+
+static int make_unary(ctl_plan* plan, ctl_op op, int operand) {
+    return (operand < 0) ? -1 : ctl_plan_make_node(plan, op, operand, -1, -1);
+}
+
+// Boolean connectives: constants, p ∘ p, p ∘ ¬p; commutative operands in
+// node order so that "p & q" and "q & p" share a node
+static int simplify_boolean(ctl_plan* plan, ctl_op op, int left, int right) {
+    bool left_true = is_op(plan, left, CTL_OP_TRUE), left_false = is_op(plan, left, CTL_OP_FALSE);
+    bool right_true = is_op(plan, right, CTL_OP_TRUE), right_false = is_op(plan, right, CTL_OP_FALSE);
+
+    switch (op) {
+        case CTL_OP_AND:
+            if (left_false || right_false || negates(plan, left, right)) return make_constant(plan, false);
+            if (left_true || left == right) return right;
+            if (right_true) return left;
+            break;
+        case CTL_OP_OR:
+            if (left_true || right_true || negates(plan, left, right)) return make_constant(plan, true);
+            if (left_false || left == right) return right;
+            if (right_false) return left;
+            break;
+        case CTL_OP_IMPLIES:
+            if (left_false || right_true || left == right) return make_constant(plan, true);
+            if (left_true) return right;
+            if (right_false) return make_unary(plan, CTL_OP_NOT, left);
+            return ctl_plan_add_node(plan, op, left, right, -1);
+        case CTL_OP_IFF:
+            if (left == right) return make_constant(plan, true);
+            if (negates(plan, left, right)) return make_constant(plan, false);
+            if (left_true) return right;
+            if (right_true) return left;
+            if (left_false) return make_unary(plan, CTL_OP_NOT, right);
+            if (right_false) return make_unary(plan, CTL_OP_NOT, left);
+            break;
+        default:
+            break;
+    }
+
+    if (left > right) {
+        int swap = left;
+        left = right;
+        right = swap;
+    }
+    return ctl_plan_add_node(plan, op, left, right, -1);
+}
+
+// Negation: constants, double negation, and pushed through EF, AG, EG and
+// AF into their duals, so that "!EF p" and "AG !p" share a node. EX and AX
+// are not duals of each other at deadlocks, so they keep the negation.
+static int simplify_not(ctl_plan* plan, int operand) {
+    ctl_plan_node* node = &plan->nodes[operand];
+    int inner = node->left;
+
+    switch (node->op) {
+        case CTL_OP_TRUE: return make_constant(plan, false);
+        case CTL_OP_FALSE: return make_constant(plan, true);
+        case CTL_OP_NOT: return inner;
+        case CTL_OP_EF: return make_unary(plan, CTL_OP_AG, make_unary(plan, CTL_OP_NOT, inner));
+        case CTL_OP_AG: return make_unary(plan, CTL_OP_EF, make_unary(plan, CTL_OP_NOT, inner));
+        case CTL_OP_EG: return make_unary(plan, CTL_OP_AF, make_unary(plan, CTL_OP_NOT, inner));
+        case CTL_OP_AF: return make_unary(plan, CTL_OP_EG, make_unary(plan, CTL_OP_NOT, inner));
+        default: return ctl_plan_add_node(plan, CTL_OP_NOT, operand, -1, -1);
+    }
+}
+
+// Temporal operators: idempotence and constant operands. Under fairness
+// only fair paths count, so "true" no longer guarantees a path and the
+// rules marked unfair are skipped.
+static int simplify_temporal(ctl_plan* plan, ctl_op op, int left, int right) {
+    bool unfair = (plan->model->num_fairness == 0);
+    bool left_true = is_op(plan, left, CTL_OP_TRUE), left_false = is_op(plan, left, CTL_OP_FALSE);
+    bool right_true = false, right_false = false;
+    if (right >= 0) {
+        right_true = is_op(plan, right, CTL_OP_TRUE);
+        right_false = is_op(plan, right, CTL_OP_FALSE);
+    }
+
+    switch (op) {
+        case CTL_OP_EX:
+            if (left_false) return left;
+            break;
+        case CTL_OP_AX:
+            if (left_false && unfair) return left;
+            break;
+        case CTL_OP_EF:
+        case CTL_OP_EG:
+            if (is_op(plan, left, op) || left_false) return left;
+            if (left_true && unfair) return left;
+            break;
+        case CTL_OP_AF:
+        case CTL_OP_AG:
+            if (is_op(plan, left, op) || left_true) return left;
+            if (left_false && unfair) return left;
+            break;
+        case CTL_OP_EU:
+            if (right_false) return right;
+            if (left_true) return make_unary(plan, CTL_OP_EF, right);
+            if (unfair && (left_false || right_true)) return right;
+            break;
+        case CTL_OP_AU:
+            if (right_true) return right;
+            if (left_true) return make_unary(plan, CTL_OP_AF, right);
+            if (unfair && (left_false || right_false)) return right;
+            break;
+        case CTL_OP_EW:
+            if (right_false) return make_unary(plan, CTL_OP_EG, left);
+            if (unfair && (left_false || right_true)) return right;
+            break;
+        case CTL_OP_AW:
+            if (right_true) return right;
+            if (right_false) return make_unary(plan, CTL_OP_AG, left);
+            if (unfair && left_false) return right;
+            break;
+        case CTL_OP_ER:
+            if (right_false) return right;
+            if (left_false) return make_unary(plan, CTL_OP_EG, right);
+            if (unfair && left_true) return right;
+            break;
+        case CTL_OP_AR:
+            if (left_false) return make_unary(plan, CTL_OP_AG, right);
+            if (unfair && (left_true || right_false)) return right;
+            break;
+        default:
+            break;
+    }
+    return ctl_plan_add_node(plan, op, left, right, -1);
+}
+
+// Like ctl_plan_add_node, but first rewrites the node with CTL identities
+// (unless plan->simplify is off). The operands must come from this function
+// too, so that they are simplified already.
+int ctl_plan_make_node(ctl_plan* plan, ctl_op op, int left, int right, int prop_id) {
+    if (!plan->simplify) {
+        return ctl_plan_add_node(plan, op, left, right, prop_id);
+    }
+
+    switch (op) {
+        case CTL_OP_TRUE:
+        case CTL_OP_FALSE:
+        case CTL_OP_PROP:
+            return ctl_plan_add_node(plan, op, left, right, prop_id);
+        case CTL_OP_NOT:
+            return simplify_not(plan, left);
+        case CTL_OP_AND:
+        case CTL_OP_OR:
+        case CTL_OP_IMPLIES:
+        case CTL_OP_IFF:
+            return simplify_boolean(plan, op, left, right);
+        default:
+            return simplify_temporal(plan, op, left, right);
+    }
+}
+
+// Does the operator need a fixpoint computation? (all temporal operators
+// but EX and AX)
+bool ctl_is_fixpoint_op(ctl_op op) {
+    return op >= CTL_OP_EF;
+}
+
+// Evaluate a temporal node with its chosen algorithm
+static void eval_temporal(state_set* result, ctl_plan_node* node, state_set* p, state_set* q, model* model) {
+    state_set all, none, not_p, not_q, dual;
+    ctl_init_state_set(&none, model->num_states);
+    ctl_complement_state_set(&all, &none, model->num_states);
+
+    if (node->algorithm == CTL_ALG_FAIR) {
+        switch (node->op) {
+            case CTL_OP_EX: ctl_eval_fair_ex(result, p, model); break;
+            case CTL_OP_AX: ctl_eval_fair_ax(result, p, model); break;
+            case CTL_OP_EF: ctl_eval_fair_ef(result, p, model); break;
+            case CTL_OP_AF: ctl_eval_fair_af(result, p, model); break;
+            case CTL_OP_EG: ctl_eval_fair_eg(result, p, model); break;
+            case CTL_OP_AG: ctl_eval_fair_ag(result, p, model); break;
+            case CTL_OP_EU: ctl_eval_fair_eu(result, p, q, model); break;
+            case CTL_OP_AU: ctl_eval_fair_au(result, p, q, model); break;
+            case CTL_OP_EW: ctl_eval_fair_ew(result, p, q, model); break;
+            case CTL_OP_AW: ctl_eval_fair_aw(result, p, q, model); break;
+            case CTL_OP_ER: ctl_eval_fair_er(result, p, q, model); break;
+            case CTL_OP_AR: ctl_eval_fair_ar(result, p, q, model); break;
+            default: break;
+        }
+        return;
+    }
+
+    bool worklist = (node->algorithm == CTL_ALG_WORKLIST);
+    switch (node->op) {
+        case CTL_OP_EX: ctl_existential_successor(result, p, model); break;
+        case CTL_OP_AX: ctl_universal_successor(result, p, model); break;
+        case CTL_OP_EF:
+            if (worklist) ctl_eval_eu_backward(result, NULL, p, model);
+            else ctl_eval_ef(result, p, model);
+            break;
+        case CTL_OP_EU:
+            if (worklist) ctl_eval_eu_backward(result, p, q, model);
+            else ctl_eval_eu(result, p, q, model);
+            break;
+        case CTL_OP_EG:
+            if (node->algorithm == CTL_ALG_DUAL_WORKLIST) {
+                // EG P = ¬AF ¬P
+                ctl_complement_state_set(&not_p, p, model->num_states);
+                ctl_eval_au(&dual, &all, &not_p, model);
+                ctl_complement_state_set(result, &dual, model->num_states);
+            } else if (worklist) {
+                ctl_eval_ew(result, p, &none, model);
+            } else {
+                ctl_eval_eg(result, p, model);
+            }
+            break;
+        case CTL_OP_AF:
+            if (worklist) ctl_eval_au(result, &all, p, model);
+            else ctl_eval_af(result, p, model);
+            break;
+        case CTL_OP_AG:
+            if (node->algorithm == CTL_ALG_DUAL_WORKLIST) {
+                // AG P = ¬EF ¬P
+                ctl_complement_state_set(&not_p, p, model->num_states);
+                ctl_eval_eu_backward(&dual, NULL, &not_p, model);
+                ctl_complement_state_set(result, &dual, model->num_states);
+            } else if (worklist) {
+                ctl_eval_aw(result, p, &none, model);
+            } else {
+                ctl_eval_ag(result, p, model);
+            }
+            break;
+        case CTL_OP_AU:
+            if (worklist) {
+                ctl_eval_au(result, p, q, model);
+            } else {
+                // A[P U Q] = ¬(E[¬Q U (¬P ∧ ¬Q)] ∨ EG ¬Q)
+                state_set not_p_not_q, eg_not_q;
+                ctl_complement_state_set(&not_p, p, model->num_states);
+                ctl_complement_state_set(&not_q, q, model->num_states);
+                ctl_intersect_state_sets(&not_p_not_q, &not_p, &not_q);
+                ctl_eval_eu(&dual, &not_q, &not_p_not_q, model);
+                ctl_eval_eg(&eg_not_q, &not_q, model);
+                ctl_union_state_sets(&dual, &dual, &eg_not_q);
+                ctl_complement_state_set(result, &dual, model->num_states);
+            }
+            break;
+        case CTL_OP_EW: ctl_eval_ew(result, p, q, model); break;
+        case CTL_OP_AW: ctl_eval_aw(result, p, q, model); break;
+        case CTL_OP_ER: ctl_eval_er(result, p, q, model); break;
+        case CTL_OP_AR: ctl_eval_ar(result, p, q, model); break;
+        default: break;
+    }
+}
+
+// Boolean node on its operands' compact sets, without expanding them
+static ctl_compact_set* eval_boolean(ctl_plan* plan, ctl_plan_node* n, ctl_compact_set* p, ctl_compact_set* q) {
+    int num_states = plan->model->num_states;
+    ctl_compact_set *not_p, *both, *neither, *not_q, *result;
+
+    switch (n->op) {
+        case CTL_OP_NOT:
+            return ctl_compact_complement(p, num_states);
+        case CTL_OP_AND:
+            return ctl_compact_intersect(p, q, num_states);
+        case CTL_OP_OR:
+            return ctl_compact_union(p, q, num_states);
+        case CTL_OP_IMPLIES:
+            not_p = ctl_compact_complement(p, num_states);
+            result = ctl_compact_union(not_p, q, num_states);
+            free(not_p);
+            return result;
+        default:
+            // IFF: states in both or in neither
+            not_p = ctl_compact_complement(p, num_states);
+            not_q = ctl_compact_complement(q, num_states);
+            both = ctl_compact_intersect(p, q, num_states);
+            neither = ctl_compact_intersect(not_p, not_q, num_states);
+            result = ctl_compact_union(both, neither, num_states);
+            free(not_p);
+            free(not_q);
+            free(both);
+            free(neither);
+            return result;
+    }
+}
+
+// Satisfaction set of a node, evaluating its operands first if needed. The
+// set belongs to the plan. Results are kept compact; the temporal kernels
+// get their operands expanded.
+ctl_compact_set* ctl_eval_plan_node(ctl_plan* plan, int node) {
+    if (plan->results[node] != NULL) {
+        return plan->results[node];
+    }
+
+    model* model = plan->model;
+    ctl_plan_node* n = &plan->nodes[node];
+    ctl_compact_set* result;
+
+    // Fixpoints only: the boolean nodes cost less than the lookup
+    char* key = NULL;
+    plan->stats[node].from_cache = false;
+    if (plan->cache != NULL && ctl_is_fixpoint_op(n->op)) {
+        clock_t start = clock();
+        key = ctl_canonical_formula(plan, node);
+        result = (key != NULL) ? ctl_cache_lookup(plan->cache, key) : NULL;
+        if (result != NULL) {
+            free(key);
+            plan->stats[node].seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+            plan->stats[node].iterations = 0;
+            plan->stats[node].edges_scanned = 0;
+            plan->stats[node].from_cache = true;
+            plan->results[node] = result;
+            return result;
+        }
+    }
+
+    ctl_compact_set* p = (n->left >= 0) ? ctl_eval_plan_node(plan, n->left) : NULL;
+    ctl_compact_set* q = (n->right >= 0) ? ctl_eval_plan_node(plan, n->right) : NULL;
+    long iterations = model->iterations;
+    long edges_scanned = model->edges_scanned;
+    clock_t start = clock();
+
+    if (n->op == CTL_OP_TRUE || n->op == CTL_OP_FALSE) {
+        unsigned short all[2] = { 0, (unsigned short)(model->num_states - 1) };
+        int num_runs = (n->op == CTL_OP_TRUE && model->num_states > 0) ? 1 : 0;
+        result = ctl_compact_set_from_runs(all, num_runs, model->num_states);
+    } else if (n->op == CTL_OP_PROP) {
+        state_set prop;
+        ctl_eval_atomic_prop(&prop, model, n->prop_id);
+        result = ctl_compress_state_set(&prop, model->num_states);
+    } else if (n->op <= CTL_OP_IFF) {
+        result = eval_boolean(plan, n, p, q);
+    } else {
+        state_set p_states, q_states, states;
+        if (p != NULL) ctl_decompress_state_set(&p_states, p, model->num_states);
+        if (q != NULL) ctl_decompress_state_set(&q_states, q, model->num_states);
+        ctl_init_state_set(&states, model->num_states);
+        eval_temporal(&states, n, (p != NULL) ? &p_states : NULL, (q != NULL) ? &q_states : NULL, model);
+        result = ctl_compress_state_set(&states, model->num_states);
+    }
+    if (ctl_is_fixpoint_op(n->op)) {
+        plan->num_fixpoints++;
+    }
+    plan->stats[node].seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+    plan->stats[node].iterations = model->iterations - iterations;
+    plan->stats[node].edges_scanned = model->edges_scanned - edges_scanned;
+
+    if (key != NULL) {
+        ctl_cache_store(plan->cache, key, result);
+        free(key);
+    }
+    plan->results[node] = result;
+    return result;
+}
+
+/* Explain */
+
+static const char* op_name(ctl_op op) {
+    static const char* names[] = {
+        "true", "false", "prop", "!", "&", "|", "->", "<->",
+        "EX", "AX", "EF", "AF", "EG", "AG", "EU", "AU", "EW", "AW", "ER", "AR"
+    };
+    return names[op];
+}
+
+static const char* algorithm_name(ctl_algorithm algorithm) {
+    static const char* names[] = {
+        "direct", "sweep", "worklist", "dual sweep", "dual worklist", "fair"
+    };
+    return names[algorithm];
+}
+
+// Running totals of a printed plan
+typedef struct {
+    double cost;
+    double seconds;
+    long iterations;
+    long edges_scanned;
+} plan_totals;
+
+// Print a node and its operands; cached (ANALYZE only, else NULL) marks the
+// nodes whose results existed before the analyzed evaluation
+static void explain_node(ctl_plan* plan, int node, int depth, bool* shown, bool* cached,
+                         plan_totals* totals, FILE* out) {
+    ctl_plan_node* n = &plan->nodes[node];
+    const char* name = (n->op == CTL_OP_PROP) ? plan->model->prop_names[n->prop_id] : op_name(n->op);
+    char label[64];
+    snprintf(label, sizeof(label), "%*s%s", 2 * depth, "", name);
+
+    if (shown[node]) {
+        fprintf(out, "%-32s (shared, see above)\n", label);
+        return;
+    }
+    shown[node] = true;
+    totals->cost += n->cost;
+    fprintf(out, "%-32s %-14s ~%d states, cost %.0f", label, algorithm_name(n->algorithm),
+            (int)(n->density * plan->model->num_states + 0.5), n->cost);
+
+    if (cached != NULL) {
+        ctl_node_stats* stats = &plan->stats[node];
+        if (plan->results[node] == NULL) {
+            // Below a node read from the result cache
+            fprintf(out, "  | not evaluated");
+        } else if (cached[node]) {
+            fprintf(out, "  | %d states (cached)", plan->results[node]->size);
+        } else if (stats->from_cache) {
+            fprintf(out, "  | %d states, %.3f ms (result cache)", plan->results[node]->size,
+                    1000.0 * stats->seconds);
+            totals->seconds += stats->seconds;
+        } else {
+            fprintf(out, "  | %d states", plan->results[node]->size);
+            fprintf(out, ", %.3f ms, %ld iterations, %ld edges", 1000.0 * stats->seconds,
+                    stats->iterations, stats->edges_scanned);
+            totals->seconds += stats->seconds;
+            totals->iterations += stats->iterations;
+            totals->edges_scanned += stats->edges_scanned;
+        }
+    }
+    fprintf(out, "\n");
+
+    if (n->left >= 0) explain_node(plan, n->left, depth + 1, shown, cached, totals, out);
+    if (n->right >= 0) explain_node(plan, n->right, depth + 1, shown, cached, totals, out);
+}
+
+static void print_plan(ctl_plan* plan, int node, bool* cached, FILE* out) {
+    bool* shown = calloc(plan->num_nodes, sizeof(bool));
+    plan_totals totals = { 0.0, 0.0, 0, 0 };
+    if (shown == NULL) {
+        fprintf(stderr, "Error: Memory allocation failed for plan\n");
+        return;
+    }
+
+    explain_node(plan, node, 0, shown, cached, &totals, out);
+    fprintf(out, "Estimated cost: %.0f\n", totals.cost);
+    if (cached != NULL) {
+        fprintf(out, "Actual: %.3f ms, %ld iterations, %ld edges scanned\n",
+                1000.0 * totals.seconds, totals.iterations, totals.edges_scanned);
+    }
+    free(shown);
+}
+
+// Print the plan of a formula as a tree: each node's operator, chosen
+// algorithm, estimated size and estimated cost. A subformula used twice is
+// printed once.
+void ctl_explain_plan(ctl_plan* plan, int node, FILE* out) {
+    print_plan(plan, node, NULL, out);
+}
+
+// Evaluate a formula and print its plan with what each node actually took:
+// result size, time of its own kernel, fixpoint iterations (sweep rounds or
+// worklist states) and transitions scanned. Nodes evaluated before, e.g. for
+// an earlier property, are marked cached, and nodes read from the result
+// cache are marked as such.
+void ctl_analyze_plan(ctl_plan* plan, int node, FILE* out) {
+    bool* cached = malloc(plan->num_nodes * sizeof(bool));
+    if (cached == NULL) {
+        fprintf(stderr, "Error: Memory allocation failed for plan\n");
+        return;
+    }
+    for (int i = 0; i < plan->num_nodes; i++) {
+        cached[i] = (plan->results[i] != NULL);
+    }
+
+    ctl_eval_plan_node(plan, node);
+    print_plan(plan, node, cached, out);
+    free(cached);
+}
+
+/* Canonical Form */
+
+// A formula as prefix text that does not depend on the plan it was compiled
+// into: propositions by name, the operands of &, | and <-> in sorted order,
+// e.g. "AG(|(!(p1c),!(p2c)))". Equal texts mean equal satisfaction sets in
+// any model with the same propositions, so the text keys the result cache.
+// The caller frees it; NULL if memory runs out.
+char* ctl_canonical_formula(ctl_plan* plan, int node) {
+    ctl_plan_node* n = &plan->nodes[node];
+    if (n->op == CTL_OP_PROP) {
+        return strdup(plan->model->prop_names[n->prop_id]);
+    }
+    if (n->left < 0) {
+        return strdup(op_name(n->op));
+    }
+
+    char* left = ctl_canonical_formula(plan, n->left);
+    char* right = (n->right >= 0) ? ctl_canonical_formula(plan, n->right) : NULL;
+    if (left == NULL || (n->right >= 0 && right == NULL)) {
+        free(left);
+        free(right);
+        return NULL;
+    }
+    bool commutative = (n->op == CTL_OP_AND || n->op == CTL_OP_OR || n->op == CTL_OP_IFF);
+    if (commutative && strcmp(left, right) > 0) {
+        char* swap = left;
+        left = right;
+        right = swap;
+    }
+
+    const char* name = op_name(n->op);
+    size_t length = strlen(name) + strlen(left) + ((right != NULL) ? strlen(right) : 0) + 4;
+    char* text = malloc(length);
+    if (text != NULL) {
+        if (right != NULL) {
+            snprintf(text, length, "%s(%s,%s)", name, left, right);
+        } else {
+            snprintf(text, length, "%s(%s)", name, left);
+        }
+    }
+    free(left);
+    free(right);
+    return text;
+}
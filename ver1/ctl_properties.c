@@ -0,0 +1,374 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include "ctl_api.h"
+
+/*
+ * Model files and property files.
+ *
+ * A model file lists a Kripke structure one directive per line ('#' starts
+ * a comment):
+ *
+ *     states 9                 number of states (first directive)
+ *     props p1n p1t p1c        propositions (optional, fixes their order)
+ *     init 0                   initial states
+ *     label 0 p1n p2n          propositions true in a state
+ *     trans 0 1 5              successors of a state
+ *     fair !p1c                fairness constraint, as a formula (evaluated
+ *                              when read, so it follows the labels)
+ *
+ * A property file holds one property per line as "name: formula" (a line
+ * without a name gets one from its line number). A line that starts with
+ * whitespace continues the formula of the property above it, so long
+ * formulas can be written as indented blocks.
+ */
+
+// Read a whole line into a growing buffer; false at end of file
+static bool read_line(FILE* file, char** buffer, size_t* capacity) {
+    size_t length = 0;
+    int c;
+
+    while ((c = fgetc(file)) != EOF && c != '\n') {
+        if (length + 1 >= *capacity) {
+            size_t new_capacity = (*capacity == 0) ? 256 : 2 * *capacity;
+            char* grown = realloc(*buffer, new_capacity);
+            if (grown == NULL) {
+                fprintf(stderr, "Error: Memory allocation failed while reading\n");
+                return false;
+            }
+            *buffer = grown;
+            *capacity = new_capacity;
+        }
+        (*buffer)[length++] = (char)c;
+    }
+    if (c == EOF && length == 0) {
+        return false;
+    }
+
+    if (*buffer == NULL) {
+        *buffer = malloc(1);
+        *capacity = 1;
+        if (*buffer == NULL) return false;
+    }
+    if (length > 0 && (*buffer)[length - 1] == '\r') {
+        length--;
+    }
+    (*buffer)[length] = '\0';
+    return true;
+}
+
+// Cut a line at its comment and trailing whitespace
+static void strip_line(char* line) {
+    char* comment = strchr(line, '#');
+    if (comment != NULL) {
+        *comment = '\0';
+    }
+    size_t length = strlen(line);
+    while (length > 0 && isspace((unsigned char)line[length - 1])) {
+        line[--length] = '\0';
+    }
+}
+
+// Parse a state ID within the model's states
+static bool parse_state_id(const char* text, model* model, int* state_id) {
+    char* end;
+    long value = strtol(text, &end, 10);
+    if (*end != '\0' || value < 0 || value >= model->num_states) {
+        return false;
+    }
+    *state_id = (int)value;
+    return true;
+}
+
+/* Model Files */
+
+// Load a model file; NULL (after reporting the line) if it cannot be read
+model* ctl_load_model(const char* path) {
+    FILE* file = fopen(path, "r");
+    if (file == NULL) {
+        fprintf(stderr, "Error: Cannot open model file %s\n", path);
+        return NULL;
+    }
+
+    model* model = ctl_create_model();
+    char* line = NULL;
+    size_t capacity = 0;
+    int line_number = 0;
+    bool ok = (model != NULL);
+    bool have_states = false;
+
+    while (ok && read_line(file, &line, &capacity)) {
+        line_number++;
+        strip_line(line);
+        char* line_end = line + strlen(line);
+
+        const char* separators = " \t";
+        char* directive = strtok(line, separators);
+        if (directive == NULL) {
+            continue;
+        }
+
+        if (strcmp(directive, "states") == 0) {
+            char* count = strtok(NULL, separators);
+            int num_states = (count != NULL) ? atoi(count) : 0;
+            if (have_states || num_states <= 0 || num_states > MAX_STATES) {
+                fprintf(stderr, "Error: %s:%d: Expected one 'states <n>' with 1 <= n <= %d\n",
+                        path, line_number, MAX_STATES);
+                ok = false;
+                break;
+            }
+            for (int i = 0; i < num_states; i++) {
+                ctl_add_state(model);
+            }
+            have_states = true;
+            continue;
+        }
+
+        if (!have_states) {
+            fprintf(stderr, "Error: %s:%d: 'states' must come first\n", path, line_number);
+            ok = false;
+            break;
+        }
+
+        if (strcmp(directive, "props") == 0) {
+            for (char* name = strtok(NULL, separators); name != NULL && ok; name = strtok(NULL, separators)) {
+                ok = ctl_add_proposition(model, name) >= 0;
+            }
+        } else if (strcmp(directive, "init") == 0 || strcmp(directive, "label") == 0 ||
+                   strcmp(directive, "trans") == 0) {
+            int state_id;
+            char* first = strtok(NULL, separators);
+            if (first == NULL || !parse_state_id(first, model, &state_id)) {
+                fprintf(stderr, "Error: %s:%d: Invalid state ID\n", path, line_number);
+                ok = false;
+                break;
+            }
+
+            if (strcmp(directive, "init") == 0) {
+                // "init 0 3 4" declares several initial states
+                for (char* text = first; text != NULL && ok; text = strtok(NULL, separators)) {
+                    ok = parse_state_id(text, model, &state_id);
+                    if (ok) ctl_set_initial_state(model, state_id);
+                }
+            } else if (strcmp(directive, "label") == 0) {
+                for (char* name = strtok(NULL, separators); name != NULL && ok; name = strtok(NULL, separators)) {
+                    int prop_id = ctl_add_proposition(model, name);
+                    ok = prop_id >= 0;
+                    if (ok) ctl_set_proposition_true(model, state_id, prop_id);
+                }
+            } else {
+                int successor_id;
+                for (char* text = strtok(NULL, separators); text != NULL && ok; text = strtok(NULL, separators)) {
+                    ok = parse_state_id(text, model, &successor_id) &&
+                         ctl_add_transition(model, state_id, successor_id);
+                }
+            }
+            if (!ok) {
+                fprintf(stderr, "Error: %s:%d: Invalid '%s' directive\n", path, line_number, directive);
+            }
+        } else if (strcmp(directive, "fair") == 0) {
+            // The rest of the line is the formula
+            char* formula = directive + strlen(directive);
+            if (formula < line_end) formula++;
+            while (isspace((unsigned char)*formula)) formula++;
+            if (*formula == '\0') {
+                fprintf(stderr, "Error: %s:%d: Expected a formula after 'fair'\n", path, line_number);
+                ok = false;
+                break;
+            }
+            ok = ctl_add_fairness_formula(model, formula) >= 0;
+        } else {
+            fprintf(stderr, "Error: %s:%d: Unknown directive '%s'\n", path, line_number, directive);
+            ok = false;
+        }
+    }
+
+    if (ok && !have_states) {
+        fprintf(stderr, "Error: %s: No 'states' directive\n", path);
+        ok = false;
+    }
+
+    free(line);
+    fclose(file);
+    if (!ok) {
+        ctl_free_model(model);
+        return NULL;
+    }
+    return model;
+}
+
+/* Property Files */
+
+static bool add_property(ctl_property_list* list, const char* name, const char* formula, int line) {
+    if (list->num_properties == list->capacity) {
+        int capacity = (list->capacity == 0) ? 16 : 2 * list->capacity;
+        ctl_property* properties = realloc(list->properties, capacity * sizeof(ctl_property));
+        if (properties == NULL) {
+            fprintf(stderr, "Error: Memory allocation failed for properties\n");
+            return false;
+        }
+        list->properties = properties;
+        list->capacity = capacity;
+    }
+
+    ctl_property* property = &list->properties[list->num_properties++];
+    property->name = strdup(name);
+    property->formula = strdup(formula);
+    property->line = line;
+    property->root = -1;
+    return property->name != NULL && property->formula != NULL;
+}
+
+// Append a continuation line to the formula of the last property
+static bool continue_property(ctl_property_list* list, const char* text) {
+    ctl_property* property = &list->properties[list->num_properties - 1];
+    size_t length = strlen(property->formula);
+    char* formula = realloc(property->formula, length + strlen(text) + 2);
+    if (formula == NULL) {
+        fprintf(stderr, "Error: Memory allocation failed for properties\n");
+        return false;
+    }
+    if (length > 0) {
+        formula[length++] = ' ';
+    }
+    strcpy(formula + length, text);
+    property->formula = formula;
+    return true;
+}
+
+// Load a property file
+bool ctl_load_properties(ctl_property_list* list, const char* path) {
+    list->num_properties = 0;
+    list->capacity = 0;
+    list->properties = NULL;
+
+    FILE* file = fopen(path, "r");
+    if (file == NULL) {
+        fprintf(stderr, "Error: Cannot open property file %s\n", path);
+        return false;
+    }
+
+    char* line = NULL;
+    size_t capacity = 0;
+    int line_number = 0;
+    bool ok = true;
+
+    while (ok && read_line(file, &line, &capacity)) {
+        line_number++;
+        bool continuation = isspace((unsigned char)line[0]);
+        strip_line(line);
+
+        char* text = line;
+        while (isspace((unsigned char)*text)) text++;
+        if (*text == '\0') {
+            continue;
+        }
+
+        if (continuation && list->num_properties > 0) {
+            ok = continue_property(list, text);
+            continue;
+        }
+
+        char generated[32];
+        const char* name = generated;
+        char* colon = strchr(text, ':');
+        if (colon != NULL) {
+            *colon = '\0';
+            char* end = colon;
+            while (end > text && isspace((unsigned char)end[-1])) *--end = '\0';
+            name = text;
+            text = colon + 1;
+            while (isspace((unsigned char)*text)) text++;
+            if (*name == '\0') {
+                fprintf(stderr, "Error: %s:%d: Empty property name\n", path, line_number);
+                ok = false;
+                break;
+            }
+        } else {
+            snprintf(generated, sizeof(generated), "line%d", line_number);
+        }
+        ok = add_property(list, name, text, line_number);
+    }
+
+    free(line);
+    fclose(file);
+
+    // A named property whose block never got a formula
+    for (int i = 0; ok && i < list->num_properties; i++) {
+        if (list->properties[i].formula[0] == '\0') {
+            fprintf(stderr, "Error: %s:%d: Property '%s' has no formula\n",
+                    path, list->properties[i].line, list->properties[i].name);
+            ok = false;
+        }
+    }
+
+    if (!ok) {
+        ctl_free_properties(list);
+    }
+    return ok;
+}
+
+void ctl_free_properties(ctl_property_list* list) {
+    for (int i = 0; i < list->num_properties; i++) {
+        free(list->properties[i].name);
+        free(list->properties[i].formula);
+    }
+    free(list->properties);
+    list->properties = NULL;
+    list->num_properties = 0;
+    list->capacity = 0;
+}
+
+/* Batch Checking */
+
+// Reduce the model to the cone of influence of the property list: the states
+// reachable from the initial states, with the propositions the properties
+// mention. reduction->reduced is NULL if every state is reachable (the plan
+// is then built on the model itself). Returns false on errors.
+bool ctl_reduce_for_properties(ctl_reduction* reduction, ctl_property_list* list, model* model) {
+    bool used[MAX_PROPS] = {false};
+    for (int i = 0; i < list->num_properties; i++) {
+        ctl_formula_propositions(list->properties[i].formula, model, used);
+    }
+    return ctl_reduce_model(reduction, model, used, -1);
+}
+
+// Compile every property into the shared plan, then check them in file
+// order against the initial states, writing each verdict as soon as it is
+// known. Subformulas shared between properties are evaluated once. If the
+// plan is built on a reduced model, failing states are reported under their
+// IDs in the original model. A property that does not parse is reported as
+// invalid and skipped; the number of those goes to num_invalid. Returns the
+// number of properties that fail.
+int ctl_check_properties(ctl_property_list* list, ctl_plan* plan, ctl_reduction* reduction, FILE* out,
+                         int* num_invalid) {
+    int failures = 0;
+
+    *num_invalid = 0;
+    for (int i = 0; i < list->num_properties; i++) {
+        ctl_property* property = &list->properties[i];
+        property->root = ctl_compile_formula(plan, property->formula, &property->error);
+    }
+
+    for (int i = 0; i < list->num_properties; i++) {
+        ctl_property* property = &list->properties[i];
+        int failing_state;
+        if (property->root < 0) {
+            fprintf(out, "%s: invalid (line %d, column %d: %s)\n", property->name, property->line,
+                    property->error.position + 1, property->error.message);
+            (*num_invalid)++;
+        } else if (ctl_plan_holds_initially(plan, property->root, &failing_state)) {
+            fprintf(out, "%s: holds\n", property->name);
+        } else {
+            if (reduction != NULL && reduction->reduced != NULL) {
+                failing_state = reduction->original_state[failing_state];
+            }
+            fprintf(out, "%s: fails (initial state %d)\n", property->name, failing_state);
+            failures++;
+        }
+        fflush(out);
+    }
+
+    return failures;
+}
@@ -0,0 +1,569 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ctl_sat.h"
+
+/*
+ * CDCL SAT solver: two watched literals, first-UIP clause learning with
+ * non-chronological backjumping, VSIDS decisions with phase saving and
+ * geometric restarts. Assumptions are decided first, one per decision
+ * level, as in MiniSat; learned clauses never depend on them, so they
+ * stay valid across calls.
+ *
+ * Internally literal 2v is variable v and 2v+1 its negation.
+ */
+
+#define LIT_UNDEF -1
+#define VALUE_UNDEF -1
+#define RESTART_FIRST 100
+#define RESTART_GROWTH 1.5
+#define ACTIVITY_DECAY 0.95
+#define ACTIVITY_LIMIT 1e100
+
+// Growable array of ints
+typedef struct {
+    int* data;
+    int size;
+    int capacity;
+} int_vector;
+
+struct sat_solver {
+    int num_vars;
+    int var_capacity;
+    bool ok;                      // False once the clauses are unsatisfiable
+
+    // Clause database: clause c has clause_size[c] literals starting at arena[clause_start[c]]
+    int_vector arena;
+    int_vector clause_start;
+    int_vector clause_size;
+
+    int_vector* watches;          // Clauses watching each literal (indexed by literal)
+
+    // Assignment
+    signed char* value;           // Per variable: 0, 1 or VALUE_UNDEF
+    int* level;
+    int* reason;                  // Clause that implied the variable, -1 for decisions
+    bool* saved_phase;
+    int* trail;
+    int trail_size;
+    int_vector trail_lim;         // Trail position where each decision level starts
+    int qhead;                    // Next trail entry to propagate
+
+    // VSIDS: max-heap of variables by activity
+    double* activity;
+    double var_inc;
+    int* heap;
+    int heap_size;
+    int* heap_index;              // Position in the heap, -1 if not in it
+
+    // Conflict analysis
+    bool* seen;
+    bool* failed;                 // Assumptions involved in the last failure
+    int_vector learnt;
+};
+
+/* Helpers */
+
+static void vector_push(int_vector* v, int x) {
+    if (v->size == v->capacity) {
+        v->capacity = v->capacity ? v->capacity * 2 : 8;
+        v->data = realloc(v->data, v->capacity * sizeof(int));
+        if (v->data == NULL) {
+            fprintf(stderr, "Error: Memory allocation failed in SAT solver\n");
+            exit(1);
+        }
+    }
+    v->data[v->size++] = x;
+}
+
+static int to_internal(int lit) {
+    return lit > 0 ? 2 * lit : 2 * (-lit) + 1;
+}
+
+static int lit_var(int lit) {
+    return lit >> 1;
+}
+
+static int lit_value(sat_solver* solver, int lit) {
+    int v = solver->value[lit_var(lit)];
+    return v == VALUE_UNDEF ? VALUE_UNDEF : v ^ (lit & 1);
+}
+
+static int decision_level(sat_solver* solver) {
+    return solver->trail_lim.size;
+}
+
+/* Variable order heap */
+
+static bool heap_less(sat_solver* solver, int a, int b) {
+    return solver->activity[a] > solver->activity[b];
+}
+
+static void heap_up(sat_solver* solver, int pos) {
+    int var = solver->heap[pos];
+    while (pos > 0) {
+        int parent = (pos - 1) / 2;
+        if (!heap_less(solver, var, solver->heap[parent])) break;
+        solver->heap[pos] = solver->heap[parent];
+        solver->heap_index[solver->heap[pos]] = pos;
+        pos = parent;
+    }
+    solver->heap[pos] = var;
+    solver->heap_index[var] = pos;
+}
+
+static void heap_down(sat_solver* solver, int pos) {
+    int var = solver->heap[pos];
+    for (;;) {
+        int child = 2 * pos + 1;
+        if (child >= solver->heap_size) break;
+        if (child + 1 < solver->heap_size && heap_less(solver, solver->heap[child + 1], solver->heap[child])) {
+            child++;
+        }
+        if (!heap_less(solver, solver->heap[child], var)) break;
+        solver->heap[pos] = solver->heap[child];
+        solver->heap_index[solver->heap[pos]] = pos;
+        pos = child;
+    }
+    solver->heap[pos] = var;
+    solver->heap_index[var] = pos;
+}
+
+static void heap_insert(sat_solver* solver, int var) {
+    if (solver->heap_index[var] >= 0) return;
+    solver->heap[solver->heap_size] = var;
+    solver->heap_index[var] = solver->heap_size;
+    solver->heap_size++;
+    heap_up(solver, solver->heap_size - 1);
+}
+
+static int heap_pop(sat_solver* solver) {
+    int top = solver->heap[0];
+    solver->heap_index[top] = -1;
+    solver->heap_size--;
+    if (solver->heap_size > 0) {
+        solver->heap[0] = solver->heap[solver->heap_size];
+        solver->heap_index[solver->heap[0]] = 0;
+        heap_down(solver, 0);
+    }
+    return top;
+}
+
+static void bump_activity(sat_solver* solver, int var) {
+    solver->activity[var] += solver->var_inc;
+    if (solver->activity[var] > ACTIVITY_LIMIT) {
+        for (int v = 1; v <= solver->num_vars; v++) {
+            solver->activity[v] *= 1 / ACTIVITY_LIMIT;
+        }
+        solver->var_inc *= 1 / ACTIVITY_LIMIT;
+    }
+    if (solver->heap_index[var] >= 0) {
+        heap_up(solver, solver->heap_index[var]);
+    }
+}
+
+/* Solver lifetime */
+
+sat_solver* sat_new(void) {
+    sat_solver* solver = calloc(1, sizeof(sat_solver));
+    if (solver == NULL) {
+        fprintf(stderr, "Error: Memory allocation failed for SAT solver\n");
+        return NULL;
+    }
+    solver->ok = true;
+    solver->var_inc = 1.0;
+    return solver;
+}
+
+void sat_free(sat_solver* solver) {
+    if (solver == NULL) return;
+
+    for (int lit = 0; solver->watches != NULL && lit < 2 * (solver->var_capacity + 1); lit++) {
+        free(solver->watches[lit].data);
+    }
+    free(solver->watches);
+    free(solver->arena.data);
+    free(solver->clause_start.data);
+    free(solver->clause_size.data);
+    free(solver->value);
+    free(solver->level);
+    free(solver->reason);
+    free(solver->saved_phase);
+    free(solver->trail);
+    free(solver->trail_lim.data);
+    free(solver->activity);
+    free(solver->heap);
+    free(solver->heap_index);
+    free(solver->seen);
+    free(solver->failed);
+    free(solver->learnt.data);
+    free(solver);
+}
+
+// Grow the per-variable arrays to hold at least num_vars variables
+static void reserve_vars(sat_solver* solver, int num_vars) {
+    if (num_vars <= solver->var_capacity) return;
+
+    int old = solver->var_capacity;
+    int capacity = old ? old : 64;
+    while (capacity < num_vars) capacity *= 2;
+    int n = capacity + 1;
+
+    solver->watches = realloc(solver->watches, 2 * n * sizeof(int_vector));
+    solver->value = realloc(solver->value, n * sizeof(signed char));
+    solver->level = realloc(solver->level, n * sizeof(int));
+    solver->reason = realloc(solver->reason, n * sizeof(int));
+    solver->saved_phase = realloc(solver->saved_phase, n * sizeof(bool));
+    solver->trail = realloc(solver->trail, n * sizeof(int));
+    solver->activity = realloc(solver->activity, n * sizeof(double));
+    solver->heap = realloc(solver->heap, n * sizeof(int));
+    solver->heap_index = realloc(solver->heap_index, n * sizeof(int));
+    solver->seen = realloc(solver->seen, n * sizeof(bool));
+    solver->failed = realloc(solver->failed, n * sizeof(bool));
+    if (solver->watches == NULL || solver->value == NULL || solver->level == NULL ||
+        solver->reason == NULL || solver->saved_phase == NULL || solver->trail == NULL ||
+        solver->activity == NULL || solver->heap == NULL || solver->heap_index == NULL ||
+        solver->seen == NULL || solver->failed == NULL) {
+        fprintf(stderr, "Error: Memory allocation failed in SAT solver\n");
+        exit(1);
+    }
+
+    memset(&solver->watches[2 * (old + 1)], 0, 2 * (n - old - 1) * sizeof(int_vector));
+    if (old == 0) {
+        memset(solver->watches, 0, 2 * sizeof(int_vector));
+    }
+    solver->var_capacity = capacity;
+}
+
+int sat_new_var(sat_solver* solver) {
+    int var = ++solver->num_vars;
+    reserve_vars(solver, var);
+
+    solver->value[var] = VALUE_UNDEF;
+    solver->level[var] = 0;
+    solver->reason[var] = -1;
+    solver->saved_phase[var] = false;
+    solver->activity[var] = 0.0;
+    solver->heap_index[var] = -1;
+    solver->seen[var] = false;
+    solver->failed[var] = false;
+    heap_insert(solver, var);
+    return var;
+}
+
+int sat_num_vars(sat_solver* solver) {
+    return solver->num_vars;
+}
+
+/* Assignment and propagation */
+
+static void assign(sat_solver* solver, int lit, int reason) {
+    int var = lit_var(lit);
+    solver->value[var] = (lit & 1) ? 0 : 1;
+    solver->level[var] = decision_level(solver);
+    solver->reason[var] = reason;
+    solver->trail[solver->trail_size++] = lit;
+}
+
+static void backtrack(sat_solver* solver, int level) {
+    if (decision_level(solver) <= level) return;
+
+    int stop = solver->trail_lim.data[level];
+    for (int i = solver->trail_size - 1; i >= stop; i--) {
+        int var = lit_var(solver->trail[i]);
+        solver->saved_phase[var] = solver->value[var];
+        solver->value[var] = VALUE_UNDEF;
+        solver->reason[var] = -1;
+        heap_insert(solver, var);
+    }
+    solver->trail_size = stop;
+    solver->qhead = stop;
+    solver->trail_lim.size = level;
+}
+
+static int add_internal_clause(sat_solver* solver, const int* lits, int num_lits) {
+    int clause = solver->clause_start.size;
+    vector_push(&solver->clause_start, solver->arena.size);
+    vector_push(&solver->clause_size, num_lits);
+    for (int i = 0; i < num_lits; i++) {
+        vector_push(&solver->arena, lits[i]);
+    }
+    if (num_lits >= 2) {
+        vector_push(&solver->watches[lits[0]], clause);
+        vector_push(&solver->watches[lits[1]], clause);
+    }
+    return clause;
+}
+
+// Propagate the trail; returns a conflicting clause or -1
+static int propagate(sat_solver* solver) {
+    while (solver->qhead < solver->trail_size) {
+        int false_lit = solver->trail[solver->qhead++] ^ 1;
+        int_vector* ws = &solver->watches[false_lit];
+        int i = 0, j = 0;
+
+        while (i < ws->size) {
+            int clause = ws->data[i++];
+            int* c = &solver->arena.data[solver->clause_start.data[clause]];
+            int size = solver->clause_size.data[clause];
+
+            // Make c[1] the literal that became false
+            if (c[0] == false_lit) {
+                c[0] = c[1];
+                c[1] = false_lit;
+            }
+            if (lit_value(solver, c[0]) == 1) {
+                ws->data[j++] = clause;
+                continue;
+            }
+
+            // Look for a new literal to watch
+            bool moved = false;
+            for (int k = 2; k < size; k++) {
+                if (lit_value(solver, c[k]) != 0) {
+                    c[1] = c[k];
+                    c[k] = false_lit;
+                    vector_push(&solver->watches[c[1]], clause);
+                    moved = true;
+                    break;
+                }
+            }
+            if (moved) continue;
+
+            ws->data[j++] = clause;
+            if (lit_value(solver, c[0]) == 0) {
+                while (i < ws->size) {
+                    ws->data[j++] = ws->data[i++];
+                }
+                ws->size = j;
+                return clause;
+            }
+            assign(solver, c[0], clause);
+        }
+        ws->size = j;
+    }
+    return -1;
+}
+
+/* Conflict analysis */
+
+// First-UIP learning; fills solver->learnt (asserting literal first) and
+// returns the level to backjump to
+static int analyze(sat_solver* solver, int conflict) {
+    int path_count = 0;
+    int uip = LIT_UNDEF;
+    int index = solver->trail_size - 1;
+
+    solver->learnt.size = 0;
+    vector_push(&solver->learnt, LIT_UNDEF);
+
+    do {
+        int* c = &solver->arena.data[solver->clause_start.data[conflict]];
+        int size = solver->clause_size.data[conflict];
+
+        for (int k = (uip == LIT_UNDEF ? 0 : 1); k < size; k++) {
+            int var = lit_var(c[k]);
+            if (solver->seen[var] || solver->level[var] == 0) continue;
+            solver->seen[var] = true;
+            bump_activity(solver, var);
+            if (solver->level[var] == decision_level(solver)) {
+                path_count++;
+            } else {
+                vector_push(&solver->learnt, c[k]);
+            }
+        }
+
+        // Next literal of the current level on the trail
+        while (!solver->seen[lit_var(solver->trail[index])]) index--;
+        uip = solver->trail[index--];
+        conflict = solver->reason[lit_var(uip)];
+        solver->seen[lit_var(uip)] = false;
+        path_count--;
+
+        // The reason clause has the implied literal first
+        if (path_count > 0) {
+            int* r = &solver->arena.data[solver->clause_start.data[conflict]];
+            if (r[0] != uip) {
+                int size = solver->clause_size.data[conflict];
+                for (int k = 1; k < size; k++) {
+                    if (r[k] == uip) {
+                        r[k] = r[0];
+                        r[0] = uip;
+                        break;
+                    }
+                }
+            }
+        }
+    } while (path_count > 0);
+
+    solver->learnt.data[0] = uip ^ 1;
+
+    // Backjump level: highest level among the other literals, which goes to position 1
+    int backjump = 0;
+    for (int k = 1; k < solver->learnt.size; k++) {
+        int var = lit_var(solver->learnt.data[k]);
+        solver->seen[var] = false;
+        if (solver->level[var] > backjump) {
+            backjump = solver->level[var];
+            int tmp = solver->learnt.data[1];
+            solver->learnt.data[1] = solver->learnt.data[k];
+            solver->learnt.data[k] = tmp;
+        }
+    }
+    return backjump;
+}
+
+// Mark the assumptions that imply the negation of lit (lit itself included)
+static void analyze_final(sat_solver* solver, int lit) {
+    for (int v = 1; v <= solver->num_vars; v++) {
+        solver->failed[v] = false;
+    }
+    solver->failed[lit_var(lit)] = true;
+    if (decision_level(solver) == 0) return;
+
+    solver->seen[lit_var(lit)] = true;
+    for (int i = solver->trail_size - 1; i >= solver->trail_lim.data[0]; i--) {
+        int var = lit_var(solver->trail[i]);
+        if (!solver->seen[var]) continue;
+        if (solver->reason[var] < 0) {
+            solver->failed[var] = true;
+        } else {
+            int clause = solver->reason[var];
+            int* c = &solver->arena.data[solver->clause_start.data[clause]];
+            int size = solver->clause_size.data[clause];
+            for (int k = 1; k < size; k++) {
+                if (solver->level[lit_var(c[k])] > 0) {
+                    solver->seen[lit_var(c[k])] = true;
+                }
+            }
+        }
+        solver->seen[var] = false;
+    }
+    solver->seen[lit_var(lit)] = false;
+}
+
+/* Public interface */
+
+bool sat_add_clause(sat_solver* solver, const int* lits, int num_lits) {
+    if (!solver->ok) return false;
+    backtrack(solver, 0);
+
+    // Simplify against the level-0 assignment; drop duplicates and tautologies
+    solver->learnt.size = 0;
+    for (int i = 0; i < num_lits; i++) {
+        int lit = to_internal(lits[i]);
+        reserve_vars(solver, lit_var(lit));
+        while (solver->num_vars < lit_var(lit)) sat_new_var(solver);
+
+        int v = lit_value(solver, lit);
+        if (v == 1) return true;
+        if (v == 0) continue;
+
+        bool duplicate = false;
+        for (int k = 0; k < solver->learnt.size; k++) {
+            if (solver->learnt.data[k] == lit) duplicate = true;
+            if (solver->learnt.data[k] == (lit ^ 1)) return true;
+        }
+        if (!duplicate) vector_push(&solver->learnt, lit);
+    }
+
+    if (solver->learnt.size == 0) {
+        solver->ok = false;
+        return false;
+    }
+    if (solver->learnt.size == 1) {
+        assign(solver, solver->learnt.data[0], -1);
+        if (propagate(solver) >= 0) {
+            solver->ok = false;
+        }
+        return solver->ok;
+    }
+
+    add_internal_clause(solver, solver->learnt.data, solver->learnt.size);
+    return true;
+}
+
+sat_result sat_solve(sat_solver* solver, const int* assumptions, int num_assumptions) {
+    if (!solver->ok) return SAT_UNSATISFIABLE;
+    backtrack(solver, 0);
+
+    for (int i = 0; i < num_assumptions; i++) {
+        int var = lit_var(to_internal(assumptions[i]));
+        while (solver->num_vars < var) sat_new_var(solver);
+    }
+
+    int conflicts = 0;
+    double restart_limit = RESTART_FIRST;
+
+    for (;;) {
+        int conflict = propagate(solver);
+
+        if (conflict >= 0) {
+            if (decision_level(solver) == 0) {
+                solver->ok = false;
+                return SAT_UNSATISFIABLE;
+            }
+            conflicts++;
+
+            int backjump = analyze(solver, conflict);
+            backtrack(solver, backjump);
+            if (solver->learnt.size == 1) {
+                assign(solver, solver->learnt.data[0], -1);
+            } else {
+                int clause = add_internal_clause(solver, solver->learnt.data, solver->learnt.size);
+                assign(solver, solver->learnt.data[0], clause);
+            }
+            solver->var_inc /= ACTIVITY_DECAY;
+            continue;
+        }
+
+        if (conflicts >= restart_limit) {
+            conflicts = 0;
+            restart_limit *= RESTART_GROWTH;
+            backtrack(solver, 0);
+            continue;
+        }
+
+        // Decide: pending assumptions first, then the most active free variable
+        int next = LIT_UNDEF;
+        while (decision_level(solver) < num_assumptions) {
+            int lit = to_internal(assumptions[decision_level(solver)]);
+            int v = lit_value(solver, lit);
+            if (v == 1) {
+                vector_push(&solver->trail_lim, solver->trail_size);  // Already true: empty level
+            } else if (v == 0) {
+                analyze_final(solver, lit);
+                backtrack(solver, 0);
+                return SAT_UNSATISFIABLE;
+            } else {
+                next = lit;
+                break;
+            }
+        }
+
+        if (next == LIT_UNDEF) {
+            while (solver->heap_size > 0) {
+                int var = heap_pop(solver);
+                if (solver->value[var] == VALUE_UNDEF) {
+                    next = 2 * var + (solver->saved_phase[var] ? 0 : 1);
+                    break;
+                }
+            }
+            if (next == LIT_UNDEF) {
+                return SAT_SATISFIABLE;   // Every variable assigned without conflict
+            }
+        }
+
+        vector_push(&solver->trail_lim, solver->trail_size);
+        assign(solver, next, -1);
+    }
+}
+
+bool sat_value(sat_solver* solver, int var) {
+    return var >= 1 && var <= solver->num_vars && solver->value[var] == 1;
+}
+
+bool sat_failed_assumption(sat_solver* solver, int lit) {
+    int var = lit > 0 ? lit : -lit;
+    return var >= 1 && var <= solver->num_vars && solver->failed[var];
+}
@@ -0,0 +1,42 @@
+#ifndef CTL_SAT_H
+#define CTL_SAT_H
+
+#include <stdbool.h>
+
+/*
+ * Small embedded CDCL SAT solver used by the symbolic engines.
+ *
+ * Literals use the DIMACS convention: variable v (>= 1) is the literal v,
+ * its negation is -v. Clauses may be added between calls to sat_solve, and
+ * each call may pass assumptions, so one solver can be reused while a
+ * problem grows (incremental solving).
+ */
+
+typedef struct sat_solver sat_solver;
+
+typedef enum {
+    SAT_SATISFIABLE,
+    SAT_UNSATISFIABLE
+} sat_result;
+
+sat_solver* sat_new(void);
+void sat_free(sat_solver* solver);
+
+// Create a fresh variable and return its index
+int sat_new_var(sat_solver* solver);
+int sat_num_vars(sat_solver* solver);
+
+// Add a clause; returns false once the clause set is unsatisfiable
+bool sat_add_clause(sat_solver* solver, const int* lits, int num_lits);
+
+// Solve under the given assumptions (which hold for this call only)
+sat_result sat_solve(sat_solver* solver, const int* assumptions, int num_assumptions);
+
+// Value of a variable in the last satisfying assignment
+bool sat_value(sat_solver* solver, int var);
+
+// Assumptions involved in the last UNSAT answer under assumptions: true if
+// the negation of lit was implied by the other assumptions and the clauses
+bool sat_failed_assumption(sat_solver* solver, int lit);
+
+#endif /* CTL_SAT_H */
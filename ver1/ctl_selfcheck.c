@@ -0,0 +1,909 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ctl_api.h"
+
+/*
+ * Differential self-check (make check).
+ *
+ * Random models and random formulas are checked by every evaluation path of
+ * the verifier and by a reference evaluator that iterates the fixpoint
+ * equations straight from their definitions, sharing no code with the
+ * kernels. The paths are:
+ *
+ *   - compiled plans, simplified and as written, with the planner's choice
+ *     of algorithm and with each candidate algorithm forced on every node
+ *   - the initial-state checks: the plan's early-exit searches, IC3 and
+ *     bounded model checking
+ *   - the initial-state verdict of a plan on the formula's cone of
+ *     influence, as property files are checked
+ *
+ * Some models have deadlock states, where paths are maximal: EX and AX are
+ * false there, and a path that ends in a deadlock satisfies G P and P W Q
+ * if P held all along, and F P and P U Q only if the target was reached.
+ * Some models have fairness constraints; fair paths are infinite and visit
+ * every constraint infinitely often, and the reference computes the fair
+ * states by the Emerson-Lei fixpoint rather than by SCCs.
+ *
+ * A disagreement is shrunk to a minimal model and formula before it is
+ * reported. Each iteration also checks the compact set operations against
+ * plain state sets on random sets of every container.
+ */
+
+#define SELFCHECK_MAX_NODES 48
+#define SELFCHECK_MAX_STATES 96        // Bound of the large models
+#define SELFCHECK_SMALL_STATES 10      // Bound of the small models
+#define SELFCHECK_LARGE_PERCENT 20     // Models drawn from SELFCHECK_SMALL_STATES + 1 .. SELFCHECK_MAX_STATES
+#define SELFCHECK_DEADLOCK_PERCENT 30  // Models with deadlock states
+#define SELFCHECK_FAIR_PERCENT 25      // Models with fairness constraints
+#define SELFCHECK_MAX_FAIRNESS 2
+#define SELFCHECK_MAX_PROPS 3
+#define SELFCHECK_MAX_SUCC 3
+#define SELFCHECK_MAX_DEPTH 4
+
+// A formula node; operands are indices into the owning formula
+typedef struct {
+    ctl_op op;
+    int prop;
+    int left;
+    int right;
+} selfcheck_node;
+
+typedef struct {
+    selfcheck_node nodes[SELFCHECK_MAX_NODES];
+    int num_nodes;
+    int root;
+} selfcheck_formula;
+
+// Plain description of a test model, easy to mutate while shrinking
+typedef struct {
+    int num_states;
+    int num_props;
+    int num_fairness;
+    bool labels[SELFCHECK_MAX_STATES][SELFCHECK_MAX_PROPS];
+    int num_succ[SELFCHECK_MAX_STATES];
+    int succ[SELFCHECK_MAX_STATES][SELFCHECK_MAX_SUCC];
+    bool initial[SELFCHECK_MAX_STATES];
+    bool fair[SELFCHECK_MAX_FAIRNESS][SELFCHECK_MAX_STATES];
+} selfcheck_model;
+
+/* Evaluation paths under test */
+
+typedef enum {
+    CHECK_PLAN,                       // Satisfaction set of a compiled plan
+    CHECK_INITIAL,                    // ctl_check_formula_initial (early exit, IC3 for safety)
+    CHECK_INITIAL_ENGINE,             // ctl_check_formula_initial_engine
+    CHECK_REDUCED                     // Initial-state verdict of a plan on the cone of influence
+} check_kind;
+
+typedef struct {
+    const char* name;
+    check_kind kind;
+    bool simplify;                    // CHECK_PLAN, CHECK_REDUCED: rewrite with CTL identities
+    int forced;                       // CHECK_PLAN, CHECK_REDUCED: candidate forced on every node
+                                      //   (-1 for the planner's)
+    ctl_engine engine;                // CHECK_INITIAL_ENGINE
+} selfcheck_path;
+
+static const selfcheck_path selfcheck_paths[] = {
+    {"plan", CHECK_PLAN, true, -1, CTL_ENGINE_EXPLICIT},
+    {"plan (unsimplified)", CHECK_PLAN, false, -1, CTL_ENGINE_EXPLICIT},
+    {"plan, 1st candidate", CHECK_PLAN, true, 0, CTL_ENGINE_EXPLICIT},
+    {"plan, 2nd candidate", CHECK_PLAN, true, 1, CTL_ENGINE_EXPLICIT},
+    {"plan, 3rd candidate", CHECK_PLAN, true, 2, CTL_ENGINE_EXPLICIT},
+    {"plan (unsimplified), 2nd candidate", CHECK_PLAN, false, 1, CTL_ENGINE_EXPLICIT},
+    {"initial check", CHECK_INITIAL, true, -1, CTL_ENGINE_EXPLICIT},
+    {"initial check, explicit", CHECK_INITIAL_ENGINE, true, -1, CTL_ENGINE_EXPLICIT},
+    {"initial check, BMC", CHECK_INITIAL_ENGINE, true, -1, CTL_ENGINE_BMC},
+    {"initial check, IC3", CHECK_INITIAL_ENGINE, true, -1, CTL_ENGINE_IC3},
+    {"initial check, cone of influence", CHECK_REDUCED, true, -1, CTL_ENGINE_EXPLICIT}
+};
+
+#define NUM_PATHS ((int)(sizeof(selfcheck_paths) / sizeof(selfcheck_paths[0])))
+
+// Algorithms the planner chooses between for an operator (as in
+// choose_algorithm); NULL for operators without a fixpoint choice
+static const ctl_algorithm* candidate_algorithms(ctl_op op, int* count) {
+    static const ctl_algorithm direct[] = {CTL_ALG_DIRECT};
+    static const ctl_algorithm until[] = {CTL_ALG_SWEEP, CTL_ALG_WORKLIST};
+    static const ctl_algorithm eg[] = {CTL_ALG_SWEEP, CTL_ALG_WORKLIST, CTL_ALG_DUAL_WORKLIST};
+    static const ctl_algorithm af[] = {CTL_ALG_DUAL_SWEEP, CTL_ALG_WORKLIST};
+    static const ctl_algorithm ag[] = {CTL_ALG_DUAL_SWEEP, CTL_ALG_DUAL_WORKLIST, CTL_ALG_WORKLIST};
+    static const ctl_algorithm au[] = {CTL_ALG_WORKLIST, CTL_ALG_DUAL_SWEEP};
+    static const ctl_algorithm weak[] = {CTL_ALG_WORKLIST};
+
+    switch (op) {
+        case CTL_OP_EX: case CTL_OP_AX: *count = 1; return direct;
+        case CTL_OP_EF: case CTL_OP_EU: *count = 2; return until;
+        case CTL_OP_EG: *count = 3; return eg;
+        case CTL_OP_AF: *count = 2; return af;
+        case CTL_OP_AG: *count = 3; return ag;
+        case CTL_OP_AU: *count = 2; return au;
+        case CTL_OP_EW: case CTL_OP_AW: case CTL_OP_ER: case CTL_OP_AR: *count = 1; return weak;
+        default: *count = 0; return NULL;
+    }
+}
+
+/* Random generation */
+
+// xorshift32, so a seed reproduces a run on every platform
+static unsigned int next_random(unsigned int* state) {
+    unsigned int x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+static int random_below(unsigned int* state, int bound) {
+    return (int)(next_random(state) % (unsigned int)bound);
+}
+
+// Random model: mostly small, some with about one deadlock state in five,
+// some with fairness constraints, and one or two initial states
+static void random_model(selfcheck_model* tm, unsigned int* rng) {
+    memset(tm, 0, sizeof(*tm));
+    if (random_below(rng, 100) < SELFCHECK_LARGE_PERCENT) {
+        tm->num_states = SELFCHECK_SMALL_STATES + 1 +
+                         random_below(rng, SELFCHECK_MAX_STATES - SELFCHECK_SMALL_STATES);
+    } else {
+        tm->num_states = 1 + random_below(rng, SELFCHECK_SMALL_STATES);
+    }
+    tm->num_props = 1 + random_below(rng, SELFCHECK_MAX_PROPS);
+    bool deadlocks = random_below(rng, 100) < SELFCHECK_DEADLOCK_PERCENT;
+    if (random_below(rng, 100) < SELFCHECK_FAIR_PERCENT) {
+        tm->num_fairness = 1 + random_below(rng, SELFCHECK_MAX_FAIRNESS);
+    }
+
+    for (int s = 0; s < tm->num_states; s++) {
+        for (int p = 0; p < tm->num_props; p++) {
+            tm->labels[s][p] = random_below(rng, 2) == 1;
+        }
+        for (int c = 0; c < tm->num_fairness; c++) {
+            tm->fair[c][s] = random_below(rng, 3) == 0;
+        }
+        if (deadlocks && random_below(rng, 5) == 0) {
+            continue;
+        }
+        tm->num_succ[s] = 1 + random_below(rng, SELFCHECK_MAX_SUCC);
+        for (int j = 0; j < tm->num_succ[s]; j++) {
+            tm->succ[s][j] = random_below(rng, tm->num_states);
+        }
+    }
+    int num_initial = random_below(rng, 3);
+    for (int i = 0; i < num_initial; i++) {
+        tm->initial[random_below(rng, tm->num_states)] = true;
+    }
+}
+
+static bool is_binary(ctl_op op) {
+    return op == CTL_OP_AND || op == CTL_OP_OR || op == CTL_OP_IMPLIES || op == CTL_OP_IFF || op >= CTL_OP_EU;
+}
+
+static int add_formula_node(selfcheck_formula* f, ctl_op op, int prop, int left, int right) {
+    selfcheck_node* node = &f->nodes[f->num_nodes];
+    node->op = op;
+    node->prop = prop;
+    node->left = left;
+    node->right = right;
+    return f->num_nodes++;
+}
+
+// Random formula of at most the given depth over num_props propositions;
+// `top` picks the operator from those the initial-state engines specialize in
+static int random_formula(selfcheck_formula* f, int depth, int num_props, bool top, unsigned int* rng) {
+    static const ctl_op top_ops[] = {CTL_OP_EF, CTL_OP_EU, CTL_OP_EG, CTL_OP_AF, CTL_OP_AG};
+
+    // Leave room for the two operands of a binary node
+    if (depth == 0 || f->num_nodes + 3 >= SELFCHECK_MAX_NODES || (!top && random_below(rng, 4) == 0)) {
+        if (random_below(rng, 10) == 0) {
+            return add_formula_node(f, random_below(rng, 2) ? CTL_OP_TRUE : CTL_OP_FALSE, -1, -1, -1);
+        }
+        return add_formula_node(f, CTL_OP_PROP, random_below(rng, num_props), -1, -1);
+    }
+
+    ctl_op op = top ? top_ops[random_below(rng, 5)] : (ctl_op)(CTL_OP_NOT + random_below(rng, CTL_OP_AR - CTL_OP_NOT + 1));
+    int left = random_formula(f, depth - 1, num_props, false, rng);
+    int right = is_binary(op) ? random_formula(f, depth - 1, num_props, false, rng) : -1;
+    return add_formula_node(f, op, -1, left, right);
+}
+
+static int formula_size(const selfcheck_formula* f, int index) {
+    const selfcheck_node* node = &f->nodes[index];
+    int size = 1;
+    if (node->left >= 0) size += formula_size(f, node->left);
+    if (node->right >= 0) size += formula_size(f, node->right);
+    return size;
+}
+
+/* Formula text (both spellings of the binary temporal operators) */
+
+static void append_text(char* text, int* length, const char* format, const char* operand) {
+    *length += snprintf(text + *length, MAX_FORMULA_LEN - *length, format, operand);
+    if (*length >= MAX_FORMULA_LEN) *length = MAX_FORMULA_LEN - 1;
+}
+
+static void write_formula_node(char* text, int* length, const selfcheck_formula* f, int index) {
+    static const char* names[] = {
+        "true", "false", "", "!", "&", "|", "->", "<->",
+        "EX", "AX", "EF", "AF", "EG", "AG", "EU", "AU", "EW", "AW", "ER", "AR"
+    };
+    static const char* letters[] = {"U", "U", "W", "W", "R", "R"};
+    const selfcheck_node* node = &f->nodes[index];
+    char prop[16];
+
+    switch (node->op) {
+        case CTL_OP_TRUE:
+        case CTL_OP_FALSE:
+            append_text(text, length, "%s", names[node->op]);
+            break;
+        case CTL_OP_PROP:
+            snprintf(prop, sizeof(prop), "p%d", node->prop);
+            append_text(text, length, "%s", prop);
+            break;
+        case CTL_OP_NOT:
+            append_text(text, length, "%s", "!");
+            write_formula_node(text, length, f, node->left);
+            break;
+        case CTL_OP_AND:
+        case CTL_OP_OR:
+        case CTL_OP_IMPLIES:
+        case CTL_OP_IFF:
+            append_text(text, length, "%s", "(");
+            write_formula_node(text, length, f, node->left);
+            append_text(text, length, " %s ", names[node->op]);
+            write_formula_node(text, length, f, node->right);
+            append_text(text, length, "%s", ")");
+            break;
+        case CTL_OP_EU:
+        case CTL_OP_AU:
+        case CTL_OP_EW:
+        case CTL_OP_AW:
+        case CTL_OP_ER:
+        case CTL_OP_AR:
+            if (index % 2 == 0) {
+                append_text(text, length, "%s(", names[node->op]);
+                write_formula_node(text, length, f, node->left);
+                append_text(text, length, "%s", ", ");
+                write_formula_node(text, length, f, node->right);
+                append_text(text, length, "%s", ")");
+            } else {
+                append_text(text, length, "%s[", (node->op % 2 == 0) ? "E" : "A");
+                write_formula_node(text, length, f, node->left);
+                append_text(text, length, " %s ", letters[node->op - CTL_OP_EU]);
+                write_formula_node(text, length, f, node->right);
+                append_text(text, length, "%s", "]");
+            }
+            break;
+        default:
+            append_text(text, length, "%s ", names[node->op]);
+            write_formula_node(text, length, f, node->left);
+            break;
+    }
+}
+
+static void formula_text(char* text, const selfcheck_formula* f) {
+    int length = 0;
+    text[0] = '\0';
+    write_formula_node(text, &length, f, f->root);
+}
+
+/* Model construction */
+
+static model* build_model(const selfcheck_model* tm) {
+    char name[16];
+    model* m = ctl_create_model();
+    if (m == NULL) return NULL;
+
+    for (int s = 0; s < tm->num_states; s++) {
+        ctl_add_state(m);
+    }
+    for (int p = 0; p < tm->num_props; p++) {
+        snprintf(name, sizeof(name), "p%d", p);
+        ctl_add_proposition(m, name);
+    }
+    for (int s = 0; s < tm->num_states; s++) {
+        for (int p = 0; p < tm->num_props; p++) {
+            if (tm->labels[s][p]) {
+                ctl_set_proposition_true(m, s, p);
+            }
+        }
+        for (int j = 0; j < tm->num_succ[s]; j++) {
+            ctl_add_transition(m, s, tm->succ[s][j]);
+        }
+        if (tm->initial[s]) {
+            ctl_set_initial_state(m, s);
+        }
+    }
+    for (int c = 0; c < tm->num_fairness; c++) {
+        state_set states;
+        ctl_init_state_set(&states, tm->num_states);
+        for (int s = 0; s < tm->num_states; s++) {
+            if (tm->fair[c][s]) ctl_add_to_state_set(&states, s);
+        }
+        ctl_add_fairness_constraint(m, &states);
+    }
+    return m;
+}
+
+/* Reference semantics */
+
+// τEX / τAX straight from the definitions; a deadlock state, which has no
+// next state, gets `deadlock`
+static void reference_tau(bool* result, const bool* z, const selfcheck_model* tm, bool universal, bool deadlock) {
+    for (int s = 0; s < tm->num_states; s++) {
+        bool any = false, all = true;
+        for (int j = 0; j < tm->num_succ[s]; j++) {
+            if (z[tm->succ[s][j]]) any = true;
+            else all = false;
+        }
+        result[s] = (tm->num_succ[s] == 0) ? deadlock : universal ? all : any;
+    }
+}
+
+// Iterate from ∅ (least) or W (greatest) until stable:
+//   until    Z = Q ∨ (P ∧ τ(Z))     least; a deadlock never reaches Q
+//   weak     Z = Q ∨ (P ∧ τ(Z))     greatest; a path may end in a deadlock
+//   release  Z = Q ∧ (P ∨ τ(Z))     greatest
+static void reference_fixpoint(bool* z, const bool* p, const bool* q, const selfcheck_model* tm,
+                               bool universal, bool greatest, bool release) {
+    bool tau[SELFCHECK_MAX_STATES];
+    bool changed = true;
+
+    for (int s = 0; s < tm->num_states; s++) {
+        z[s] = greatest;
+    }
+    while (changed) {
+        changed = false;
+        reference_tau(tau, z, tm, universal, greatest);
+        for (int s = 0; s < tm->num_states; s++) {
+            bool next = release ? (q[s] && (p[s] || tau[s])) : (q[s] || (p[s] && tau[s]));
+            if (next != z[s]) {
+                z[s] = next;
+                changed = true;
+            }
+        }
+    }
+}
+
+// Fair EG P by Emerson-Lei: Z = P ∧ ⋀c EX E[P U (Z ∧ Fc)], the greatest such Z
+static void reference_fair_eg(bool* z, const bool* p, const selfcheck_model* tm) {
+    bool target[SELFCHECK_MAX_STATES], reach[SELFCHECK_MAX_STATES], step[SELFCHECK_MAX_STATES];
+    bool changed = true;
+
+    for (int s = 0; s < tm->num_states; s++) {
+        z[s] = true;
+    }
+    while (changed) {
+        bool next[SELFCHECK_MAX_STATES];
+        memcpy(next, p, tm->num_states * sizeof(bool));
+        for (int c = 0; c < tm->num_fairness; c++) {
+            for (int s = 0; s < tm->num_states; s++) {
+                target[s] = z[s] && tm->fair[c][s];
+            }
+            reference_fixpoint(reach, p, target, tm, false, false, false);
+            reference_tau(step, reach, tm, false, false);
+            for (int s = 0; s < tm->num_states; s++) {
+                next[s] = next[s] && step[s];
+            }
+        }
+        changed = memcmp(next, z, tm->num_states * sizeof(bool)) != 0;
+        memcpy(z, next, tm->num_states * sizeof(bool));
+    }
+}
+
+static void negate(bool* result, const bool* set, int num_states) {
+    for (int s = 0; s < num_states; s++) result[s] = !set[s];
+}
+
+// Fair temporal operators: fair E[P U Q] = E[P U (Q ∧ fair)], fair EX P =
+// EX (P ∧ fair), fair EG by Emerson-Lei, and the universal operators as the
+// duals of the existential ones
+static void reference_fair(bool* result, ctl_op op, const bool* p, const bool* q, const selfcheck_model* tm) {
+    int n = tm->num_states;
+    bool all[SELFCHECK_MAX_STATES] = {false}, fair[SELFCHECK_MAX_STATES] = {false};
+    bool target[SELFCHECK_MAX_STATES] = {false}, not_p[SELFCHECK_MAX_STATES] = {false};
+    bool not_q[SELFCHECK_MAX_STATES] = {false}, a[SELFCHECK_MAX_STATES] = {false}, b[SELFCHECK_MAX_STATES] = {false};
+
+    for (int s = 0; s < n; s++) all[s] = true;
+    reference_fair_eg(fair, all, tm);
+    negate(not_p, p, n);
+    if (q != NULL) negate(not_q, q, n);
+
+    switch (op) {
+        case CTL_OP_EX:
+        case CTL_OP_AX:
+            for (int s = 0; s < n; s++) target[s] = (op == CTL_OP_EX ? p[s] : not_p[s]) && fair[s];
+            reference_tau(result, target, tm, false, false);
+            if (op == CTL_OP_AX) negate(result, result, n);
+            break;
+        case CTL_OP_EF:
+        case CTL_OP_AG:
+            for (int s = 0; s < n; s++) target[s] = (op == CTL_OP_EF ? p[s] : not_p[s]) && fair[s];
+            reference_fixpoint(result, all, target, tm, false, false, false);
+            if (op == CTL_OP_AG) negate(result, result, n);
+            break;
+        case CTL_OP_EG:
+            reference_fair_eg(result, p, tm);
+            break;
+        case CTL_OP_AF:
+            reference_fair_eg(result, not_p, tm);
+            negate(result, result, n);
+            break;
+        case CTL_OP_EU:
+        case CTL_OP_EW:
+            for (int s = 0; s < n; s++) target[s] = q[s] && fair[s];
+            reference_fixpoint(result, p, target, tm, false, false, false);
+            if (op == CTL_OP_EW) {
+                reference_fair_eg(a, p, tm);
+                for (int s = 0; s < n; s++) result[s] = result[s] || a[s];
+            }
+            break;
+        case CTL_OP_AU:
+        case CTL_OP_AW:
+            // ¬E[¬Q U (¬P ∧ ¬Q)], and for AU also ¬EG ¬Q
+            for (int s = 0; s < n; s++) target[s] = not_p[s] && not_q[s] && fair[s];
+            reference_fixpoint(a, not_q, target, tm, false, false, false);
+            if (op == CTL_OP_AU) {
+                reference_fair_eg(b, not_q, tm);
+                for (int s = 0; s < n; s++) a[s] = a[s] || b[s];
+            }
+            negate(result, a, n);
+            break;
+        case CTL_OP_ER:
+            // E[Q U (P ∧ Q)] ∨ EG Q
+            for (int s = 0; s < n; s++) target[s] = p[s] && q[s] && fair[s];
+            reference_fixpoint(result, q, target, tm, false, false, false);
+            reference_fair_eg(a, q, tm);
+            for (int s = 0; s < n; s++) result[s] = result[s] || a[s];
+            break;
+        default:
+            // AR: ¬E[¬P U ¬Q]
+            for (int s = 0; s < n; s++) target[s] = not_q[s] && fair[s];
+            reference_fixpoint(a, not_p, target, tm, false, false, false);
+            negate(result, a, n);
+            break;
+    }
+}
+
+// Reference satisfaction set of a formula node
+static void reference_eval(bool* result, const selfcheck_formula* f, int index, const selfcheck_model* tm) {
+    const selfcheck_node* node = &f->nodes[index];
+    int n = tm->num_states;
+    bool left[SELFCHECK_MAX_STATES], right[SELFCHECK_MAX_STATES], all[SELFCHECK_MAX_STATES], none[SELFCHECK_MAX_STATES];
+
+    for (int s = 0; s < n; s++) {
+        all[s] = true;
+        none[s] = false;
+    }
+    switch (node->op) {
+        case CTL_OP_TRUE:  memcpy(result, all, n * sizeof(bool)); return;
+        case CTL_OP_FALSE: memcpy(result, none, n * sizeof(bool)); return;
+        case CTL_OP_PROP:
+            for (int s = 0; s < n; s++) result[s] = tm->labels[s][node->prop];
+            return;
+        default:
+            break;
+    }
+
+    reference_eval(left, f, node->left, tm);
+    if (node->right >= 0) {
+        reference_eval(right, f, node->right, tm);
+    }
+    if (node->op >= CTL_OP_EX && tm->num_fairness > 0) {
+        reference_fair(result, node->op, left, node->right >= 0 ? right : NULL, tm);
+        return;
+    }
+
+    switch (node->op) {
+        case CTL_OP_NOT:     negate(result, left, n); break;
+        case CTL_OP_AND:     for (int s = 0; s < n; s++) result[s] = left[s] && right[s]; break;
+        case CTL_OP_OR:      for (int s = 0; s < n; s++) result[s] = left[s] || right[s]; break;
+        case CTL_OP_IMPLIES: for (int s = 0; s < n; s++) result[s] = !left[s] || right[s]; break;
+        case CTL_OP_IFF:     for (int s = 0; s < n; s++) result[s] = left[s] == right[s]; break;
+        case CTL_OP_EX: reference_tau(result, left, tm, false, false); break;
+        case CTL_OP_AX: reference_tau(result, left, tm, true, false); break;
+        case CTL_OP_EF: reference_fixpoint(result, all, left, tm, false, false, false); break;
+        case CTL_OP_AF: reference_fixpoint(result, all, left, tm, true, false, false); break;
+        case CTL_OP_EG: reference_fixpoint(result, left, none, tm, false, true, false); break;
+        case CTL_OP_AG: reference_fixpoint(result, left, none, tm, true, true, false); break;
+        case CTL_OP_EU: reference_fixpoint(result, left, right, tm, false, false, false); break;
+        case CTL_OP_AU: reference_fixpoint(result, left, right, tm, true, false, false); break;
+        case CTL_OP_EW: reference_fixpoint(result, left, right, tm, false, true, false); break;
+        case CTL_OP_AW: reference_fixpoint(result, left, right, tm, true, true, false); break;
+        case CTL_OP_ER: reference_fixpoint(result, left, right, tm, false, true, true); break;
+        case CTL_OP_AR: reference_fixpoint(result, left, right, tm, true, true, true); break;
+        default: break;
+    }
+}
+
+// Does the formula hold in every initial state (state 0 if none is marked)?
+static bool reference_holds_initially(const bool* result, const selfcheck_model* tm) {
+    bool any_initial = false;
+    for (int s = 0; s < tm->num_states; s++) {
+        if (!tm->initial[s]) continue;
+        any_initial = true;
+        if (!result[s]) return false;
+    }
+    return any_initial || result[0];
+}
+
+/* Running one path */
+
+// Evaluate the formula on a path; `got` receives the satisfaction set
+// (CHECK_PLAN) or the initial-state verdict in got[0]. False if the formula
+// did not compile.
+static bool path_eval(bool* got, const selfcheck_path* path, const char* text, model* m) {
+    if (path->kind == CHECK_INITIAL) {
+        got[0] = ctl_check_formula_initial(text, m);
+        return true;
+    }
+    if (path->kind == CHECK_INITIAL_ENGINE) {
+        got[0] = ctl_check_formula_initial_engine(text, m, path->engine);
+        return true;
+    }
+
+    // The cone of influence, as for a property file of this one formula
+    ctl_reduction reduction;
+    reduction.reduced = NULL;
+    if (path->kind == CHECK_REDUCED) {
+        bool used[MAX_PROPS] = {false};
+        ctl_formula_propositions(text, m, used);
+        if (!ctl_reduce_model(&reduction, m, used, -1)) return false;
+    }
+
+    ctl_plan* plan = ctl_create_plan((reduction.reduced != NULL) ? reduction.reduced : m);
+    ctl_parse_error error;
+    if (plan == NULL) {
+        ctl_free_reduction(&reduction);
+        return false;
+    }
+    plan->simplify = path->simplify;
+    int root = ctl_compile_formula(plan, text, &error);
+    if (root < 0) {
+        ctl_print_parse_error(text, &error, stdout);
+        ctl_free_plan(plan);
+        ctl_free_reduction(&reduction);
+        return false;
+    }
+    for (int i = 0; path->forced >= 0 && i < plan->num_nodes; i++) {
+        int count;
+        const ctl_algorithm* candidates = candidate_algorithms(plan->nodes[i].op, &count);
+        if (candidates != NULL && plan->nodes[i].algorithm != CTL_ALG_FAIR) {
+            plan->nodes[i].algorithm = candidates[path->forced % count];
+        }
+    }
+
+    if (path->kind == CHECK_REDUCED) {
+        got[0] = ctl_plan_holds_initially(plan, root, NULL);
+        ctl_free_plan(plan);
+        ctl_free_reduction(&reduction);
+        return true;
+    }
+
+    state_set result;
+    ctl_decompress_state_set(&result, ctl_eval_plan_node(plan, root), m->num_states);
+    for (int s = 0; s < m->num_states; s++) {
+        got[s] = result.members[s];
+    }
+    ctl_free_plan(plan);
+    return true;
+}
+
+// Evaluate with the path and the reference; true if they disagree
+static bool path_mismatch(const selfcheck_model* tm, const selfcheck_formula* f, const selfcheck_path* path,
+                          bool* got, bool* expected) {
+    char text[MAX_FORMULA_LEN];
+    model* m = build_model(tm);
+    if (m == NULL) return false;
+
+    formula_text(text, f);
+    bool compiled = path_eval(got, path, text, m);
+    reference_eval(expected, f, f->root, tm);
+    ctl_free_model(m);
+    if (!compiled) return true;
+
+    if (path->kind != CHECK_PLAN) {
+        expected[0] = reference_holds_initially(expected, tm);
+        return got[0] != expected[0];
+    }
+    for (int s = 0; s < tm->num_states; s++) {
+        if (got[s] != expected[s]) return true;
+    }
+    return false;
+}
+
+/* Shrinking */
+
+static bool still_fails(const selfcheck_model* tm, const selfcheck_formula* f, const selfcheck_path* path) {
+    bool got[SELFCHECK_MAX_STATES], expected[SELFCHECK_MAX_STATES];
+    return path_mismatch(tm, f, path, got, expected);
+}
+
+// Replace subformulas by one of their operands or by a proposition while the mismatch persists
+static bool shrink_formula(const selfcheck_model* tm, selfcheck_formula* f, const selfcheck_path* path) {
+    bool progress = false;
+
+    for (int i = 0; i < f->num_nodes; i++) {
+        selfcheck_node original = f->nodes[i];
+        if (original.left < 0) continue;
+
+        int operands[2] = {original.left, original.right};
+        bool replaced = false;
+        for (int c = 0; c < 2 && !replaced; c++) {
+            if (operands[c] < 0) continue;
+            f->nodes[i] = f->nodes[operands[c]];
+            replaced = still_fails(tm, f, path);
+            if (!replaced) {
+                f->nodes[i] = original;
+            }
+        }
+
+        for (int p = 0; p < tm->num_props && !replaced; p++) {
+            f->nodes[i].op = CTL_OP_PROP;
+            f->nodes[i].prop = p;
+            f->nodes[i].left = f->nodes[i].right = -1;
+            replaced = still_fails(tm, f, path);
+            if (!replaced) {
+                f->nodes[i] = original;
+            }
+        }
+        progress = progress || replaced;
+    }
+
+    return progress;
+}
+
+// Remove state victim and the edges into it
+static void remove_state(selfcheck_model* dst, const selfcheck_model* src, int victim) {
+    memset(dst, 0, sizeof(*dst));
+    dst->num_states = src->num_states - 1;
+    dst->num_props = src->num_props;
+    dst->num_fairness = src->num_fairness;
+
+    for (int s = 0, d = 0; s < src->num_states; s++) {
+        if (s == victim) continue;
+        memcpy(dst->labels[d], src->labels[s], sizeof(src->labels[s]));
+        dst->initial[d] = src->initial[s];
+        for (int c = 0; c < src->num_fairness; c++) {
+            dst->fair[c][d] = src->fair[c][s];
+        }
+        for (int j = 0; j < src->num_succ[s]; j++) {
+            int t = src->succ[s][j];
+            if (t == victim) continue;
+            dst->succ[d][dst->num_succ[d]++] = t > victim ? t - 1 : t;
+        }
+        d++;
+    }
+}
+
+// Drop states, transitions, labels and fairness members while the mismatch persists
+static bool shrink_model(selfcheck_model* tm, const selfcheck_formula* f, const selfcheck_path* path) {
+    selfcheck_model* candidate = malloc(sizeof(selfcheck_model));
+    bool progress = false;
+    if (candidate == NULL) return false;
+
+    for (int s = tm->num_states - 1; s >= 0 && tm->num_states > 1; s--) {
+        remove_state(candidate, tm, s);
+        if (still_fails(candidate, f, path)) {
+            *tm = *candidate;
+            progress = true;
+        }
+    }
+
+    for (int s = 0; s < tm->num_states; s++) {
+        for (int j = tm->num_succ[s] - 1; j >= 0; j--) {
+            *candidate = *tm;
+            candidate->succ[s][j] = candidate->succ[s][--candidate->num_succ[s]];
+            if (still_fails(candidate, f, path)) {
+                *tm = *candidate;
+                progress = true;
+            }
+        }
+        for (int p = 0; p < tm->num_props; p++) {
+            if (!tm->labels[s][p]) continue;
+            *candidate = *tm;
+            candidate->labels[s][p] = false;
+            if (still_fails(candidate, f, path)) {
+                *tm = *candidate;
+                progress = true;
+            }
+        }
+        for (int c = 0; c < tm->num_fairness; c++) {
+            if (!tm->fair[c][s]) continue;
+            *candidate = *tm;
+            candidate->fair[c][s] = false;
+            if (still_fails(candidate, f, path)) {
+                *tm = *candidate;
+                progress = true;
+            }
+        }
+    }
+
+    free(candidate);
+    return progress;
+}
+
+static void print_counterexample(const selfcheck_model* tm, const selfcheck_formula* f, const selfcheck_path* path) {
+    bool got[SELFCHECK_MAX_STATES], expected[SELFCHECK_MAX_STATES];
+    char text[MAX_FORMULA_LEN];
+    path_mismatch(tm, f, path, got, expected);
+    formula_text(text, f);
+
+    printf("  Minimal counterexample for %s:\n", path->name);
+    printf("  Formula: %s\n", text);
+    if (path->kind != CHECK_PLAN) {
+        printf("  Holds initially: %s, reference: %s\n", got[0] ? "true" : "false", expected[0] ? "true" : "false");
+    }
+    for (int s = 0; s < tm->num_states; s++) {
+        printf("    State %d%s: {", s, tm->initial[s] ? " (initial)" : "");
+        bool first = true;
+        for (int p = 0; p < tm->num_props; p++) {
+            if (tm->labels[s][p]) {
+                printf("%sp%d", first ? "" : ", ", p);
+                first = false;
+            }
+        }
+        printf("} -> {");
+        for (int j = 0; j < tm->num_succ[s]; j++) {
+            printf("%s%d", j > 0 ? ", " : "", tm->succ[s][j]);
+        }
+        printf("}");
+        for (int c = 0; c < tm->num_fairness; c++) {
+            if (tm->fair[c][s]) printf(" fair%d", c);
+        }
+        if (path->kind == CHECK_PLAN) {
+            printf("  got: %s, reference: %s", got[s] ? "true" : "false", expected[s] ? "true" : "false");
+        }
+        printf("\n");
+    }
+}
+
+/* Compact sets */
+
+// Random set in one of four shapes, so that every container turns up
+static void random_members(bool* members, int num_states, unsigned int* rng) {
+    int shape = random_below(rng, 4);
+    bool inside = random_below(rng, 2) == 1;
+    for (int s = 0; s < num_states; s++) {
+        switch (shape) {
+            case 0: members[s] = random_below(rng, 20) == 0; break;   // Sparse
+            case 1: members[s] = random_below(rng, 20) != 0; break;   // Nearly full
+            case 2:                                                   // Long runs
+                if (random_below(rng, 16) == 0) inside = !inside;
+                members[s] = inside;
+                break;
+            default: members[s] = random_below(rng, 2) == 1; break;
+        }
+    }
+}
+
+static void members_to_set(state_set* set, const bool* members, int num_states) {
+    ctl_init_state_set(set, num_states);
+    for (int s = 0; s < num_states; s++) {
+        if (members[s]) ctl_add_to_state_set(set, s);
+    }
+}
+
+// Does the compact set hold exactly the expected states?
+static bool compact_matches(ctl_compact_set* set, const bool* expected, int num_states) {
+    state_set plain;
+    int size = 0;
+    if (set == NULL) return false;
+    ctl_decompress_state_set(&plain, set, num_states);
+    for (int s = 0; s < num_states; s++) {
+        if (plain.members[s] != expected[s] || ctl_compact_set_contains(set, s) != expected[s]) {
+            return false;
+        }
+        size += expected[s];
+    }
+    return set->size == size;
+}
+
+// Compress two random sets and check the compact operations against the
+// plain ones; returns the name of the first operation that differs, or NULL
+static const char* check_compact_sets(int num_states, unsigned int* rng) {
+    static bool a[MAX_STATES], b[MAX_STATES], expected[MAX_STATES];
+    unsigned short runs[MAX_STATES + 1];
+    state_set set_a, set_b;
+    const char* failed = NULL;
+
+    random_members(a, num_states, rng);
+    random_members(b, num_states, rng);
+    members_to_set(&set_a, a, num_states);
+    members_to_set(&set_b, b, num_states);
+    ctl_compact_set* ca = ctl_compress_state_set(&set_a, num_states);
+    ctl_compact_set* cb = ctl_compress_state_set(&set_b, num_states);
+    ctl_compact_set* result;
+
+    if (!compact_matches(ca, a, num_states) || !compact_matches(cb, b, num_states)) {
+        failed = "compress";
+    }
+
+    int num_runs = failed ? 0 : ctl_compact_set_runs(ca, num_states, runs);
+    result = failed ? NULL : ctl_compact_set_from_runs(runs, num_runs, num_states);
+    if (!failed && !compact_matches(result, a, num_states)) failed = "runs";
+    free(result);
+
+    result = failed ? NULL : ctl_copy_compact_set(ca);
+    if (!failed && !compact_matches(result, a, num_states)) failed = "copy";
+    free(result);
+
+    for (int s = 0; s < num_states; s++) expected[s] = !a[s];
+    result = failed ? NULL : ctl_compact_complement(ca, num_states);
+    if (!failed && !compact_matches(result, expected, num_states)) failed = "complement";
+    free(result);
+
+    for (int s = 0; s < num_states; s++) expected[s] = a[s] || b[s];
+    result = failed ? NULL : ctl_compact_union(ca, cb, num_states);
+    if (!failed && !compact_matches(result, expected, num_states)) failed = "union";
+    free(result);
+
+    for (int s = 0; s < num_states; s++) expected[s] = a[s] && b[s];
+    result = failed ? NULL : ctl_compact_intersect(ca, cb, num_states);
+    if (!failed && !compact_matches(result, expected, num_states)) failed = "intersect";
+    free(result);
+
+    free(ca);
+    free(cb);
+    return failed;
+}
+
+/* Driver */
+
+// Run the differential test; returns the number of mismatches found
+int ctl_run_selfcheck(int iterations, unsigned int seed) {
+    unsigned int rng = seed != 0 ? seed : 1;
+    int failures = 0;
+    selfcheck_model* tm = malloc(sizeof(selfcheck_model));
+    selfcheck_model* small = malloc(sizeof(selfcheck_model));
+    if (tm == NULL || small == NULL) {
+        fprintf(stderr, "Error: Memory allocation failed for the self-check\n");
+        free(tm);
+        free(small);
+        return 1;
+    }
+
+    printf("===== CTL Self-Check: %d evaluation paths against a reference =====\n", NUM_PATHS);
+    printf("Iterations: %d, seed: %u\n", iterations, seed);
+
+    for (int it = 0; it < iterations; it++) {
+        selfcheck_formula f;
+
+        random_model(tm, &rng);
+        f.num_nodes = 0;
+        f.root = random_formula(&f, 1 + random_below(&rng, SELFCHECK_MAX_DEPTH), tm->num_props,
+                                random_below(&rng, 2) == 0, &rng);
+
+        for (int k = 0; k < NUM_PATHS; k++) {
+            const selfcheck_path* path = &selfcheck_paths[k];
+            if (!still_fails(tm, &f, path)) continue;
+
+            printf("[ERROR] Iteration %d: %s disagrees with the reference\n", it, path->name);
+            selfcheck_formula small_f = f;
+            *small = *tm;
+            while (shrink_formula(small, &small_f, path) || shrink_model(small, &small_f, path)) {
+            }
+            printf("  Shrunk from %d states / %d formula nodes to %d states / %d formula nodes\n",
+                   tm->num_states, formula_size(&f, f.root),
+                   small->num_states, formula_size(&small_f, small_f.root));
+            print_counterexample(small, &small_f, path);
+            failures++;
+        }
+
+        int num_states = 1 + random_below(&rng, (it % 4 == 0) ? MAX_STATES : SELFCHECK_MAX_STATES);
+        const char* failed = check_compact_sets(num_states, &rng);
+        if (failed != NULL) {
+            printf("[ERROR] Iteration %d: compact %s differs from the state set operation (%d states)\n",
+                   it, failed, num_states);
+            failures++;
+        }
+    }
+
+    free(tm);
+    free(small);
+    printf("Self-check %s: %d mismatch(es) in %d iterations\n",
+           failures == 0 ? "passed" : "FAILED", failures, iterations);
+    return failures;
+}